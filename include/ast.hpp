@@ -0,0 +1,199 @@
+#pragma once
+#ifndef __AST_H
+#define __AST_H
+#include "parser.hpp"
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+class Ast;
+
+// Type the analyzer resolved for a node.
+enum VarType {
+    TYPE_UNKNOWN,
+    TYPE_INT,
+    TYPE_STRING,
+    TYPE_BOOL,
+    TYPE_FUNCTION,
+    TYPE_FLOAT,
+    TYPE_DICT,
+};
+
+// Facts about a node the analyzer established, as bits of Ast::flags.
+enum AstFlag : uint8_t {
+    FLAG_STATE = 1 << 0, // declares, reads or assigns a page's reactive state
+};
+
+// Handle to one node of a flat Ast. Cheap to copy; a default-constructed
+// handle is the empty node, and tests false like a null AST_NODE* did.
+class AstNode
+{
+    public:
+        class iterator;
+        class range;
+
+        AstNode() = default;
+        AstNode(const Ast *ast, uint32_t id) : ast(ast), index(id) {}
+
+        explicit operator bool() const { return ast != nullptr; }
+        bool operator==(const AstNode &other) const { return ast == other.ast && index == other.index; }
+        bool operator!=(const AstNode &other) const { return !(*this == other); }
+
+        uint32_t id() const { return index; }
+        enum NODE_TYPE type() const;
+        AstNode child() const;       // the CHILD slot
+        AstNode nextSibling() const; // next entry of the parent's SUB_STATEMENTS
+        range subs() const;          // SUB_STATEMENTS
+        AstNode sub(size_t i) const;
+        size_t subCount() const;
+
+        bool hasValue() const;
+        const std::string &value() const;
+        Symbol symbol() const; // the value's symbol, 0 if the node has none
+        int64_t intValue() const;  // NODE_INT literal
+        double floatValue() const; // NODE_FLOAT literal
+
+        // Set by SemanticAnalyzer::analyze(); TYPE_UNKNOWN and false before that.
+        enum VarType resolvedType() const;
+        bool isState() const;
+
+        int lineno() const;
+        int charno() const;
+        uint32_t offset() const; // span of the token the node was built at
+        uint32_t length() const;
+
+    private:
+        const Ast *ast = nullptr;
+        uint32_t index = 0;
+};
+
+enum AstEdge {
+    EDGE_ROOT,
+    EDGE_CHILD,
+    EDGE_SUB
+};
+
+// Pre-order walk over an Ast: CHILD first, then SUB_STATEMENTS in order.
+class AstVisitor
+{
+    public:
+        virtual ~AstVisitor() = default;
+        // Return false to skip the node's children.
+        virtual bool enter(AstNode node, AstEdge edge, int depth) = 0;
+        virtual void leave(AstNode node, AstEdge edge, int depth) {}
+};
+
+// The AST in contiguous arrays, one entry per node. Each node's SUB_STATEMENTS
+// occupy a consecutive block, so sub(i) is firstChild + i and nextSibling is the
+// next slot of the block. Values are held as Symbols, so equal strings share one
+// id across every Ast of the process.
+//
+// The parser still builds AST_NODEs in the session arena; Ast is laid out from
+// them once parsing finishes.
+class Ast
+{
+    friend class AstCache;
+    friend class Optimizer;
+
+    public:
+        static constexpr uint32_t NONE = UINT32_MAX;
+        static constexpr uint8_t EMPTY = 0xFF; // kind of a null SUB_STATEMENTS entry
+
+        Ast(const AST_NODE *root, std::pmr::memory_resource *arena = std::pmr::get_default_resource());
+        // One program out of several modules: a root whose SUB_STATEMENTS are each
+        // module's top-level statements in turn, minus its imports.
+        Ast(const std::vector<const Ast *> &modules, std::pmr::memory_resource *arena = std::pmr::get_default_resource());
+
+        AstNode root() const { return node(0); }
+        AstNode node(uint32_t id) const;
+        size_t size() const { return kinds.size(); }
+
+        void walk(AstVisitor &visitor) const;
+        void walk(AstNode from, AstVisitor &visitor, AstEdge edge = EDGE_ROOT, int depth = 0) const;
+
+        std::pmr::vector<uint8_t> kinds;
+        std::pmr::vector<uint32_t> children;    // CHILD slot, NONE if absent
+        std::pmr::vector<uint32_t> firstChild;  // first SUB_STATEMENTS entry, NONE if none
+        std::pmr::vector<uint32_t> nextSibling; // NONE for the last entry of a block
+        std::pmr::vector<uint32_t> childCounts;
+        std::pmr::vector<Symbol> symbols;       // the node's value, 0 means none
+        std::pmr::vector<NumericValue> numbers; // parsed literal, zero elsewhere
+        std::pmr::vector<uint8_t> types;        // VarType, filled in by analysis
+        std::pmr::vector<uint8_t> flags;        // AstFlag bits, filled in by analysis
+        std::pmr::vector<uint32_t> lines;
+        std::pmr::vector<uint32_t> columns;
+        std::pmr::vector<uint32_t> offsets;
+        std::pmr::vector<uint32_t> lengths;
+
+    private:
+        explicit Ast(std::pmr::memory_resource *arena);
+
+        uint32_t push(uint8_t kind, Symbol symbol, NumericValue number, uint32_t line, uint32_t column,
+                      uint32_t offset, uint32_t length);
+        uint32_t allocate(const AST_NODE *node);
+        void layout(const AST_NODE *node, uint32_t id);
+        uint32_t copy(const Ast &from, uint32_t id);
+        void layout(const Ast &from, uint32_t source, uint32_t id);
+        void reserve(size_t count);
+};
+
+class AstNode::iterator
+{
+    public:
+        iterator(const Ast *ast, uint32_t id) : ast(ast), index(id) {}
+        AstNode operator*() const { return ast->node(index); }
+        iterator &operator++() { index++; return *this; }
+        iterator operator+(size_t n) const { return iterator(ast, index + n); }
+        bool operator==(const iterator &other) const { return index == other.index; }
+        bool operator!=(const iterator &other) const { return index != other.index; }
+
+    private:
+        const Ast *ast;
+        uint32_t index;
+};
+
+class AstNode::range
+{
+    public:
+        range(const Ast *ast, uint32_t first, uint32_t count) : ast(ast), first(first), count(count) {}
+        iterator begin() const { return iterator(ast, first); }
+        iterator end() const { return iterator(ast, first + count); }
+        size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+        AstNode operator[](size_t i) const { return ast->node(first + i); }
+        AstNode back() const { return ast->node(first + count - 1); }
+
+    private:
+        const Ast *ast;
+        uint32_t first;
+        uint32_t count;
+};
+
+inline AstNode Ast::node(uint32_t id) const
+{
+    return (id == NONE || kinds[id] == EMPTY) ? AstNode() : AstNode(this, id);
+}
+
+inline enum NODE_TYPE AstNode::type() const { return (enum NODE_TYPE)ast->kinds[index]; }
+inline AstNode AstNode::child() const { return ast->node(ast->children[index]); }
+inline AstNode AstNode::nextSibling() const { return ast->node(ast->nextSibling[index]); }
+inline AstNode::range AstNode::subs() const
+{
+    return ast ? range(ast, ast->firstChild[index], ast->childCounts[index]) : range(nullptr, 0, 0);
+}
+inline AstNode AstNode::sub(size_t i) const { return ast->node(ast->firstChild[index] + i); }
+inline size_t AstNode::subCount() const { return ast->childCounts[index]; }
+inline bool AstNode::hasValue() const { return ast->symbols[index] != 0; }
+inline const std::string &AstNode::value() const { return Symbols::name(ast->symbols[index]); }
+inline Symbol AstNode::symbol() const { return ast->symbols[index]; }
+inline int64_t AstNode::intValue() const { return ast->numbers[index].integer; }
+inline double AstNode::floatValue() const { return ast->numbers[index].real; }
+inline enum VarType AstNode::resolvedType() const { return (enum VarType)ast->types[index]; }
+inline bool AstNode::isState() const { return ast->flags[index] & FLAG_STATE; }
+inline int AstNode::lineno() const { return ast->lines[index]; }
+inline int AstNode::charno() const { return ast->columns[index]; }
+inline uint32_t AstNode::offset() const { return ast->offsets[index]; }
+inline uint32_t AstNode::length() const { return ast->lengths[index]; }
+
+#endif
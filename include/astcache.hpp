@@ -0,0 +1,57 @@
+#pragma once
+#ifndef __ASTCACHE_H
+#define __ASTCACHE_H
+#include "ast.hpp"
+#include "session.hpp"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+// 128-bit digest of a source file's bytes. Not cryptographic, just wide enough
+// that two versions of a file won't collide by accident.
+struct SourceHash {
+    uint64_t low = 0;
+    uint64_t high = 0;
+
+    bool operator==(const SourceHash &other) const { return low == other.low && high == other.high; }
+    bool operator!=(const SourceHash &other) const { return !(*this == other); }
+};
+
+SourceHash hashSource(std::string_view text);
+// Folds `next` into `hash`, in order, to key a whole program by its modules.
+SourceHash combineHashes(SourceHash hash, SourceHash next);
+
+// Parsed modules on disk, one entry per source file, so a build can take the Ast
+// of an unchanged file without lexing or parsing it. An entry is only used when
+// it was written from exactly the same bytes by the same helios executable and
+// cache format; anything else is a miss and the entry is overwritten by the next
+// store().
+//
+// An entry is the Ast arrays as they sit in memory followed by the value
+// strings, so loading it is a memory-mapped read and a copy per array.
+//
+// The cache also remembers the last program (every module's hash) that got
+// through analysis without a single diagnostic. Its modules are stored along
+// with the types and flags analysis wrote into them, so an unchanged program
+// skips semantic analysis as well.
+class AstCache
+{
+    public:
+        explicit AstCache(std::string directory = ".helios/cache") : directory(std::move(directory)) {}
+
+        // null on a miss. The Ast is allocated from `session`; its values are interned as Symbols.
+        std::unique_ptr<Ast> load(const std::string &path, SourceHash hash, CompilationSession &session) const;
+        bool store(const std::string &path, SourceHash hash, const Ast &ast) const;
+
+        bool isChecked(SourceHash program) const;
+        void markChecked(SourceHash program) const;
+
+    private:
+        std::string directory;
+
+        std::string entryFor(const std::string &path) const;
+        bool write(const std::string &file, const std::string &bytes) const;
+};
+
+#endif
@@ -4,7 +4,11 @@
 #include <sstream>
 #include <string>
 #include <vector>
+#include <unordered_map>
 
+#include "lexer.hpp"
+#include "module.hpp"
+#include "objectcache.hpp"
 
 
 using namespace std;
@@ -19,7 +23,8 @@ class Core {
         // --------------------- File Generation ---------------------
         void generateFiles(const vector<string>& targets, const string& pname);
 
-        void builder();
+        // false if index.ink has errors; they are printed and nothing is written
+        bool builder();
 
         void devTarget(const vector<string>& targets, const string& pname);
         // --------------------- Run Production ---------------------
@@ -29,8 +34,15 @@ class Core {
 
 
         // --------------------- Clean ---------------------
-        void cleanProject(const string& pname);
+        // `runtime` also drops the runtime builds every project shares
+        void cleanProject(const string& pname, bool runtime = false);
 
     private:
-        
+        // one per source file, surviving between dev-server rebuilds so a save only
+        // re-lexes the edited lines and re-parses the edited top-level statements
+        unordered_map<string, ModuleState> sources;
+        // parsed files on disk, so a fresh process skips the front end for unchanged ones
+        AstCache astcache;
+        // em++ objects and linked apps, by what they were built from
+        ObjectCache objectcache;
 };
\ No newline at end of file
@@ -0,0 +1,49 @@
+#pragma once
+#ifndef __DIAGNOSTICS_H
+#define __DIAGNOSTICS_H
+#include "lexer.hpp"
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+enum Severity {
+    SEVERITY_ERROR,
+    SEVERITY_WARNING
+};
+
+struct Diagnostic {
+    Severity severity;
+    std::string kind;    // "ParserError", "Semantics Error", ...
+    std::string message;
+    int lineno;          // 0 when the problem has no single location
+    int charno;
+    int width;           // carets under the offending token
+};
+
+// Thrown once an error has been reported, to unwind the parser or analyzer to
+// the nearest statement boundary it can carry on from.
+struct RecoverableError {};
+
+// Every lex, parse and semantic problem of one build. Stages report here and
+// keep going, so a single build shows all of them instead of only the first.
+class Diagnostics
+{
+    public:
+        void error(const std::string &kind, const std::string &message, int lineno = 0, int charno = 0, int width = 1);
+        void warning(const std::string &message, int lineno = 0, int charno = 0, int width = 1);
+
+        bool hasErrors() const { return errors > 0; }
+        size_t errorCount() const { return errors; }
+        const std::vector<Diagnostic> &all() const { return diagnostics; }
+
+        // In the order reported, each with its source line and carets. `file`
+        // names the source in each location when the build has several.
+        void print(std::ostream &out, const SourceMap &source, const std::string &file = "") const;
+
+    private:
+        std::vector<Diagnostic> diagnostics;
+        size_t errors = 0;
+};
+
+#endif
@@ -0,0 +1,103 @@
+#pragma once
+#ifndef __KEYWORDS_H
+#define __KEYWORDS_H
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+enum Keyword : uint8_t {
+    KW_NONE,
+    KW_IF,
+    KW_ELSE,
+    KW_WHILE,
+    KW_FOR,
+    KW_RETURN,
+    KW_CLASS,
+    KW_IMPORT,
+    KW_PASS,
+    KW_BREAK,
+    KW_CONTINUE,
+    KW_DEF,
+    KW_TYPE,
+    KW_TRUE,
+    KW_FALSE,
+    KW_PRINT,
+    KW_PAGE,
+    KW_APP,
+    KW_VIEW,
+    KW_TEXT,
+    KW_IMG,
+    KW_CANVAS,
+    KW_INPUT,
+    KW_STATE,
+    KW_GO,
+    KW_STYLESHEET,
+    KW_TO_INT,
+    KW_TO_STR,
+    KW_TO_FLOAT,
+    KW_DRAW,
+    KW_SIN,
+    KW_SQRT,
+    KW_COS,
+    KW_TAN,
+    KW_POW,
+    KW_PLATFORM,
+    KW_COUNT
+};
+
+// Spelling of every keyword, indexed by its Keyword id.
+inline constexpr std::array<std::string_view, KW_COUNT> keywordNames = {
+    "", "if", "else", "while", "for", "return", "class",
+    "import", "pass", "break", "continue", "def", "type",
+    "true", "false", "print", "page", "app", "view", "text",
+    "img", "canvas", "input", "state", "go", "stylesheet",
+    "to_int", "to_str", "to_float", "draw", "sin", "sqrt",
+    "cos", "tan", "pow", "Platform"
+};
+
+// Perfect hash over the keyword set: two leading chars, the last char and the length
+// land every keyword in its own slot of a 64-entry table, so recognizing an
+// identifier is one table probe plus one compare.
+constexpr unsigned keywordHash(std::string_view word)
+{
+    return ((unsigned char)word[0] * 7 + (unsigned char)word[1] * 5 +
+            (unsigned char)word[word.size() - 1] * 18 + word.size()) & 63;
+}
+
+constexpr std::array<uint8_t, 64> buildKeywordTable()
+{
+    std::array<uint8_t, 64> table{};
+    for (int id = 1; id < KW_COUNT; id++)
+    {
+        table[keywordHash(keywordNames[id])] = id;
+    }
+    return table;
+}
+
+inline constexpr std::array<uint8_t, 64> keywordTable = buildKeywordTable();
+
+constexpr Keyword lookupKeyword(std::string_view word)
+{
+    if (word.size() < 2 || word.size() > 10)
+    {
+        return KW_NONE;
+    }
+    Keyword id = (Keyword)keywordTable[keywordHash(word)];
+    return (id != KW_NONE && keywordNames[id] == word) ? id : KW_NONE;
+}
+
+constexpr bool keywordTableIsPerfect()
+{
+    for (int id = 1; id < KW_COUNT; id++)
+    {
+        if (lookupKeyword(keywordNames[id]) != id)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(keywordTableIsPerfect(), "keyword hash collides; pick new keywordHash constants");
+
+#endif
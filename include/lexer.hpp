@@ -3,10 +3,13 @@
 #define __LEXER_H
 #include <iostream>
 #include <string>
-#include <sstream>
+#include <string_view>
+#include <cstdint>
 #include <cctype>
 #include <vector>
 #include <algorithm>
+#include "keywords.hpp"
+#include "symbols.hpp"
 
 enum Tokentype {
     TOKEN_ID,
@@ -44,53 +47,149 @@ enum Tokentype {
     TOKEN_BACKLASH,
     TOKEN_DOT,
     TOKEN_FLOAT,
+    TOKEN_ERROR, // text the lexer could not make sense of; the parser reports it
     TOKEN_EOF
 };
 
+// Lightweight view of one token, materialized from a TokenStream on demand.
 struct Token
 {
     enum Tokentype TYPE;
-    std::string value;
+    std::string_view value; // view into the source buffer (or the stream's unescaped literal storage)
     int lineno;
     int charno;
-    std::string sourceLine;
-    std::string extra;
+    Keyword keyword;        // KW_NONE unless TYPE is TOKEN_KEYWORD
+    Symbol symbol;          // 0 unless TYPE is TOKEN_ID
+};
+
+// Struct-of-arrays token buffer. Every field lives in its own packed array,
+// indexed by token position, so a whole file costs a handful of allocations.
+class TokenStream
+{
+    public:
+        // lengths[] with this bit set hold an index into literalStarts: the token's
+        // text is an unescaped copy in `literals`, though offsets[] still points at the source
+        static constexpr uint32_t ESCAPED = 1u << 31;
+
+        TokenStream() = default;
+        TokenStream(std::string_view source);
+
+        void reserve(size_t count);
+        void push(enum Tokentype type, uint32_t offset, uint32_t length, int lineno, int charno, Keyword keyword = KW_NONE,
+                  Symbol symbol = 0);
+        void pushLiteral(std::string_view value, uint32_t offset, int lineno, int charno);
+        // Append tokens [begin, end) of `other`, shifting their source offsets and line numbers.
+        void append(const TokenStream &other, size_t begin, size_t end, int offsetShift, int lineShift);
+        // Index of the first token whose source offset is >= `offset`.
+        size_t lowerBound(uint32_t offset) const;
+
+        size_t size() const { return types.size(); }
+        enum Tokentype type(size_t index) const { return (enum Tokentype)types[index]; }
+        std::string_view value(size_t index) const;
+        // Positions past the end read as EOF, so the parser never runs off the buffer.
+        Token at(size_t index) const;
+
+        std::string_view source;
+        std::string literals;
+        std::vector<uint32_t> literalStarts;
+        std::vector<uint8_t> types;
+        std::vector<uint8_t> keywords;
+        std::vector<Symbol> symbols;
+        std::vector<uint32_t> offsets;
+        std::vector<uint32_t> lengths;
+        std::vector<uint32_t> lines;
+        std::vector<uint32_t> columns;
 };
 
 std::string typetostring(enum Tokentype TYPE);
 
+// Line-start offsets over the immutable source buffer.
+// Diagnostics rebuild the offending line from here instead of every token carrying a copy.
+class SourceMap
+{
+    public:
+        SourceMap() = default;
+        SourceMap(std::string_view text);
+
+        std::string_view line(int lineno) const;
+        int lineCount() const { return lineStarts.size(); }
+
+    private:
+        std::string_view text;
+        std::vector<int> lineStarts;
+};
+
+// A newline the lexer always turns into a TOKEN_NEWLINE with the column reset,
+// so lexing can restart right after it without looking further back.
+bool isSafeLineBreak(std::string_view text, size_t newline);
+
 class Lexer
 {
+    friend class IncrementalLexer;
     public:
-        Lexer(std::string sourceCode);
-        
-        std::vector<std::string> keywords = {
-            "if", "else", "while", "for", "return", "class", "import", "pass", "break", "continue", "def","type", "true", "false","print", "page", "app", "view", "text", "img", "canvas" , "input", "state", "go", "stylesheet", "to_int", "to_str", "to_float", "draw", "sin", "sqrt", "cos", "tan", "pow", "Platform"
-        };
+        // `sourceCode` is borrowed; the buffer must outlive the lexer and the TokenStream it returns
+        Lexer(std::string_view sourceCode);
         
         char advance();
 
         void checkAndSkip();
 
-        Token * tokenizeID_KEYWORD();
+        void tokenizeID_KEYWORD();
         
-        Token  * tokenizeOP(enum Tokentype Type, char expected);
+        void tokenizeOP(enum Tokentype Type, char expected);
 
-        Token * tokenizespecial(enum Tokentype TYPE);
+        void tokenizespecial(enum Tokentype TYPE);
 
-        Token * tokenizeINT();
-        Token * tokenizeSTR(enum Tokentype TYPE);
-        std::vector<Token *> tokenize();
+        void tokenizeINT();
+        void tokenizeSTR(enum Tokentype TYPE);
+        TokenStream tokenize();
         char peak(int offset);
+
+        // Inputs at least this large are split at line boundaries and lexed on the shared thread pool.
+        static constexpr int PARALLEL_MIN_BYTES = 1 << 20;
+        static constexpr int PARALLEL_CHUNK_BYTES = 256 << 10;
+
+        const SourceMap &sourceMap() const { return sourcemap; }
     private:
-        std::string source;
+        std::string_view source;
+        SourceMap sourcemap;
+        TokenStream tokens;
+        std::string unescaped; // scratch buffer for decoding escaped string literals
         int cursor;
         int size;
         char current;
-        std::stringstream currentLine;
         int linenum;
         int charnum;
         bool ctrl;
+
+        Lexer(std::string_view sourceCode, int begin, int end);
+        bool scan();
+        bool tokenizeParallel();
+        int chunkBoundary(int from) const;
+
+        void skipTo(int position);
+        std::string_view slice(int start) const { return source.substr(start, cursor - start); }
+        void emit(enum Tokentype type, int start, int charno) { tokens.push(type, start, cursor - start, linenum, charno); }
+};
+
+// Keeps the last source and its tokens between builds. update() diffs the new
+// text against the old one, re-lexes only the lines that changed and splices
+// the result between the untouched head and tail of the previous stream.
+class IncrementalLexer
+{
+    public:
+        // The returned stream views text() and stays valid until the next update().
+        const TokenStream &update(std::string_view text);
+        std::string_view text() const { return previous; }
+        size_t relexedBytes() const { return relexed; }
+
+    private:
+        std::string previous;
+        TokenStream tokens;
+        bool primed = false;
+        size_t relexed = 0;
+
+        const TokenStream &relexAll(std::string_view text);
 };
 
 
@@ -0,0 +1,97 @@
+#pragma once
+#ifndef __MODULE_H
+#define __MODULE_H
+#include "ast.hpp"
+#include "astcache.hpp"
+#include "lexer.hpp"
+#include "parser.hpp"
+#include "semantics.hpp"
+#include "session.hpp"
+#include "sourcefile.hpp"
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct Module;
+
+// What a file keeps between builds, so the next one re-lexes and re-parses
+// only what changed.
+struct ModuleState {
+    IncrementalLexer lexer;
+    IncrementalParser parser;
+};
+
+struct ModuleImport {
+    AstNode node; // the import statement
+    Module *module;
+};
+
+// One .ink file of the program and everything its front end produced. Each
+// module has its own session, so modules can be parsed on different threads.
+// Statements reused from an earlier build live in that build's session, which
+// the module's IncrementalParser keeps alive.
+struct Module {
+    std::string path; // normalized, relative to the project root
+    std::shared_ptr<CompilationSession> session = std::make_shared<CompilationSession>();
+    SourceFile source; // kept open only when the Ast came from the cache, for the source map
+    SourceHash hash;
+    SourceMap sourcemap;
+    ModuleState *state = nullptr;
+    std::unique_ptr<Ast> ast; // null if the file couldn't be read
+    bool cached = false;      // ast was loaded from the AstCache rather than parsed
+    std::unique_ptr<SemanticAnalyzer> analyzer;
+    std::vector<ModuleImport> imports;
+    int level = 0; // 1 + the highest level among its imports
+};
+
+// The entry file and everything it imports. Files are lexed and parsed on the
+// shared thread pool a wave at a time, each wave being the files the previous
+// one imported for the first time. Analysis then runs level by level, so a
+// module is checked once everything it imports has been, and all modules of one
+// level run side by side.
+//
+// With a cache, a file whose bytes match its entry isn't lexed or parsed at all,
+// and a program whose every module matches the last one that analyzed cleanly
+// isn't analyzed either.
+class ModuleGraph
+{
+    public:
+        // File states outlive the graph so each file is lexed and parsed incrementally across builds.
+        explicit ModuleGraph(std::unordered_map<std::string, ModuleState> &states, const AstCache *cache = nullptr)
+            : states(&states), cache(cache) {}
+
+        // false if the entry file can't be read
+        bool load(const std::string &entry);
+        void analyze();
+        // Every module's top-level statements, imports first, in one Ast
+        // allocated from `session`. The import statements themselves are dropped.
+        Ast merge(CompilationSession &session) const;
+
+        bool hasErrors() const;
+        size_t errorCount() const;
+        void printDiagnostics(std::ostream &out) const;
+        size_t bytesUsed() const;
+
+        // Dependencies before dependents; the entry file is last.
+        const std::vector<Module *> &order() const { return sorted; }
+
+    private:
+        std::unordered_map<std::string, ModuleState> *states;
+        const AstCache *cache;
+        std::vector<std::unique_ptr<Module>> modules; // discovery order, entry first
+        std::unordered_map<std::string, Module *> byPath;
+        std::vector<Module *> sorted;
+
+        Module *add(const std::string &path);
+        void parse(Module &module);
+        void resolveImports(Module &module, std::vector<Module *> &discovered);
+        void sort();
+        void visit(Module &module, std::unordered_map<Module *, int> &state, std::vector<Module *> &stack);
+        SourceHash programHash() const;
+        bool isClean() const;
+};
+
+#endif
@@ -0,0 +1,43 @@
+#pragma once
+#ifndef __OBJECTCACHE_H
+#define __OBJECTCACHE_H
+#include "astcache.hpp"
+#include <string>
+#include <vector>
+
+// em++ outputs on disk, filed under the hash of everything that went into
+// them. An object's key covers its unit's text, the headers every unit
+// includes, the flags and the compiler; a linked app's key covers the keys of
+// its objects and the link flags. When a build's generated code hasn't changed,
+// everything is found here and no compiler runs at all. Other single-file
+// outputs (the runtime's library and precompiled header) are kept the same way
+// as objects, under a suffix of their own.
+//
+// Entries are written beside their place, under a name no other build or
+// thread will pick, and renamed into it, so a reader sees a whole entry or
+// none. Nothing is ever evicted; `helios clean` empties the
+// directory.
+class ObjectCache
+{
+    public:
+        explicit ObjectCache(std::string directory = ".helios/cache/em") : directory(std::move(directory)) {}
+
+        // Where the object for `key` lives, once stored.
+        std::string objectFor(SourceHash key, const char *suffix = ".o") const;
+        bool hasObject(SourceHash key, const char *suffix = ".o") const;
+        // Where to compile the object for `key` before storing it.
+        std::string temporaryFor(SourceHash key, const char *suffix = ".o") const;
+        // Moves an object just compiled at `built` into place.
+        bool storeObject(SourceHash key, const std::string &built, const char *suffix = ".o") const;
+
+        // Copies every file linked under `key` into the directory `into`; false on a miss.
+        bool restoreLink(SourceHash key, const std::string &into) const;
+        bool storeLink(SourceHash key, const std::vector<std::string> &files) const;
+
+    private:
+        std::string directory;
+
+        std::string entryFor(SourceHash key, const char *suffix) const;
+};
+
+#endif
@@ -0,0 +1,76 @@
+#pragma once
+#ifndef __OPTIMIZER_H
+#define __OPTIMIZER_H
+#include "ast.hpp"
+#include "symbols.hpp"
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Value of an expression worked out ahead of time.
+struct Constant {
+    enum NODE_TYPE kind; // NODE_INT, NODE_FLOAT, NODE_STRING or NODE_BOOL
+    int64_t integer = 0;
+    double real = 0;
+    bool truth = false;
+    std::string text; // the literal as codegen prints it
+};
+
+// Runs between analysis and codegen on the merged program and lays out a new
+// Ast in which
+//  - constant expressions (literal arithmetic and comparisons, string
+//    concatenation, to_str/to_int/to_float of literals, sqrt, integer pow) are
+//    literals,
+//  - if/else chains and while loops with a constant condition keep only the
+//    branch that runs,
+//  - assignments nothing reads and expression statements, when the value has
+//    no side effects, and top-level defs nothing calls are gone.
+// A fold is only made when it gives exactly what the browser would compute, so
+// sin/cos/tan and int arithmetic that overflows are left as written.
+class Optimizer
+{
+    public:
+        explicit Optimizer(const Ast &program);
+
+        Ast run(std::pmr::memory_resource *arena = std::pmr::get_default_resource());
+
+    private:
+        // One node of the output: a copy of `source`, possibly under another
+        // kind or as a literal, with its children already decided.
+        struct Plan {
+            uint32_t source;
+            uint8_t kind;
+            const Constant *literal = nullptr;
+            std::unique_ptr<Plan> child;
+            std::vector<Plan> subs;
+        };
+
+        const Ast &program;
+        std::vector<std::optional<Constant>> constants; // by node id
+        std::vector<bool> folded;                        // constants[id] is decided
+        std::vector<bool> removed;                       // statements dropped so far
+        SymbolSet reads;
+
+        const Constant *fold(AstNode node);
+        std::optional<Constant> evaluate(AstNode node);
+        bool pure(AstNode node);
+
+        Plan expression(AstNode node);
+        Plan plain(AstNode node);
+        void body(AstNode block, std::vector<Plan> &out);
+        void statement(AstNode node, std::vector<Plan> &out);
+        void branch(AstNode node, std::vector<Plan> &out);
+
+        bool sweep(const Plan &root);
+        void collectReads(const Plan &plan);
+        bool mark(const Plan &plan);
+        bool unused(const Plan &statement, bool topLevel);
+
+        uint32_t allocate(Ast &out, const Plan &plan) const;
+        void layout(Ast &out, const Plan &plan, uint32_t id) const;
+};
+
+#endif
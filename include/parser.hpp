@@ -3,10 +3,14 @@
 #define __PARSER_H
 
 #include "lexer.hpp"
+#include "session.hpp"
+#include <memory>
+#include <memory_resource>
+#include <unordered_map>
 #include <vector>
 #include <string>
 #include <cctype>
-#include <regex>
+#include <cstdint>
 
 using namespace std;
  
@@ -63,40 +67,79 @@ enum NODE_TYPE {
     NODE_FLOAT,
     NODE_DRAW,
     NODE_INSTANCE,
-    NODE_PLATFORM_CLS
+    NODE_PLATFORM_CLS,
+    NODE_IMPORT
+};
+
+// Value of a NODE_INT or NODE_FLOAT literal, parsed once by the parser.
+union NumericValue {
+    int64_t integer;
+    double real;
+};
+
+// Binary operator tiers, loosest first.
+enum Precedence {
+    PREC_NONE,
+    PREC_COMPARISON,
+    PREC_ADDITIVE,
+    PREC_MULTIPLICATIVE
+};
+
+// A node's value: its text, and the symbol the lexer gave it when it came
+// straight from an identifier token, so laying out the Ast needn't hash it again.
+struct NodeText {
+    NodeText() = default;
+    NodeText(string *text, Symbol symbol = 0) : text(text), symbol(symbol) {}
+
+    string &operator*() const { return *text; }
+    string *operator->() const { return text; }
+    explicit operator bool() const { return text != nullptr; }
+
+    string *text = nullptr;
+    Symbol symbol = 0;
 };
 
 struct AST_NODE {
+    explicit AST_NODE(std::pmr::memory_resource *arena = std::pmr::get_default_resource())
+        : SUB_STATEMENTS(arena) {}
+
     enum NODE_TYPE TYPE;
-    string *value = nullptr;
+    NodeText value;
+    NumericValue number = {0};
     AST_NODE *CHILD = nullptr;
-    vector<AST_NODE *> SUB_STATEMENTS;
-    int lineno;
-    int charno;
-    std::string sourceLine;
-    std::string extra;
+    std::pmr::vector<AST_NODE *> SUB_STATEMENTS;
+    int lineno = 0;
+    int charno = 0;
+    uint32_t offset = 0; // source span of the token the node was created at
+    uint32_t length = 0;
 };
 
 string nodetostr(enum NODE_TYPE tYPE);
 
+class IncrementalParser;
+
 class Parser {
 public:
-    Parser(vector<Token *> tokens);
+    Parser(const TokenStream &tokens, const SourceMap &sourcemap, CompilationSession &compilation);
 
     // ---------- Error Handler ----------
     void parserError(const std::string &message);
      // ---------- Error Handler ----------
     void parserWarning(const std::string &message);
+    static string lexicalError(const Token &token);
 
     // ---------- Token Consumption ----------
-    Token *proceed(enum Tokentype Tokentype);
+    const Token &proceed(enum Tokentype Tokentype);
+
+    NodeText tokenText();
+    AST_NODE *newNode();
 
     // ---------- Atomic Parsing ----------
     AST_NODE *parseINT();
 
     AST_NODE *parseID();
 
-    AST_NODE *parseInstancecall(string *buffer);
+    AST_NODE *parseInstancecall(NodeText buffer);
 
     //parse list
     AST_NODE *parseList();
@@ -109,6 +152,7 @@ public:
     // ---------- Factor ----------
     AST_NODE *parseFactor();
 
+    AST_NODE *parseBinary(Precedence minPrecedence);
     AST_NODE *parseTerm();
     AST_NODE *parseExpression();
     AST_NODE *parseComparison();
@@ -124,9 +168,9 @@ public:
 
     AST_NODE *parseBOOL(enum NODE_TYPE Tokentype);
      // ---------- FUNCTION CALL ----------
-    AST_NODE *parseFunctionCall(string *funcName, NODE_TYPE tyPE = NODE_FUNCTION_CALL);
+    AST_NODE *parseFunctionCall(NodeText funcName, NODE_TYPE tyPE = NODE_FUNCTION_CALL);
     // ---------- FUNCTION DECLARATION ----------
-    AST_NODE *parseFunctionDecl(bool callback=false, string *funcname = nullptr, int *noargs = NULL);
+    AST_NODE *parseFunctionDecl(bool callback=false, NodeText funcname = {}, int *noargs = NULL);
 
     AST_NODE *parsePageParam();
     AST_NODE *parsepage();
@@ -137,8 +181,6 @@ public:
     AST_NODE *parseCtx();
     AST_NODE *parsePlatform();
 
-    std::vector<std::string> defined_keywords;
-    std::vector<std::string> loop_keywords;
     // ---------- Keyword Dispatcher ----------
     AST_NODE *parseKEYWORDS();
     AST_NODE * parseState();
@@ -146,13 +188,64 @@ public:
     AST_NODE * parseAtSym();
     // ---------- Generic Statement ----------
     AST_NODE *parseStatement(bool ispage = false);
+    // parseStatement, but a syntax error skips the statement and yields nullptr
+    AST_NODE *parseBlockStatement(bool ispage = false);
+    void synchronize(int start);
+    bool startsStatementLine(int newline, int column) const;
     // ---------- Parse Root ----------
-    AST_NODE *parse();
+    // With `previous`, top-level statements whose tokens haven't changed since
+    // the last parse are taken from it instead of being parsed again.
+    AST_NODE *parse(IncrementalParser *previous = nullptr);
 private:
     int limit;
     int index;
-    Token *current;
-    vector<Token *> parserTokens;
+    Token current;
+    const TokenStream *parserTokens;
+    const SourceMap *source;
+    CompilationSession *session;
+};
+
+// Keeps the top-level statements (page, def, @stylesheet, assignments, ...) of
+// the last parse of one file, each with a fingerprint of its tokens. The next
+// parse takes every statement whose tokens are unchanged as the very same
+// nodes, moved to their new line, and parses only the rest.
+class IncrementalParser {
+public:
+    // Parses into `session`, which is kept alive for as long as any statement
+    // parsed into it is still being reused.
+    AST_NODE *parse(const TokenStream &tokens, const SourceMap &sourcemap, const shared_ptr<CompilationSession> &session);
+
+    size_t reusedStatements() const { return reused; }
+    size_t parsedStatements() const { return parsed; }
+
+    // Old statements tried at each position before falling back to parsing.
+    static constexpr size_t LOOKAHEAD = 4;
+    // Sessions kept alive before the cache is dropped and everything reparsed.
+    static constexpr size_t MAX_GENERATIONS = 16;
+
+private:
+    friend class Parser;
+
+    struct Statement {
+        uint64_t fingerprint;
+        uint32_t tokens; // including the token after it, which the parser looked at
+        uint32_t offset;
+        int lineno;
+        AST_NODE *node;
+        shared_ptr<CompilationSession> session;
+    };
+
+    vector<Statement> statements;
+    vector<Statement> next;
+    vector<bool> used;
+    unordered_map<uint64_t, size_t> byFingerprint;
+    shared_ptr<CompilationSession> building;
+    size_t expected = 0;
+    size_t reused = 0;
+    size_t parsed = 0;
+
+    AST_NODE *reuse(const TokenStream &tokens, int start, int &end);
+    void record(const TokenStream &tokens, int start, int end, AST_NODE *node);
 };
 
 #endif
@@ -0,0 +1,21 @@
+#pragma once
+#ifndef __SCAN_H
+#define __SCAN_H
+#include <cstddef>
+
+// Run scanners used by the lexer's hot loops. Each one returns the index of the
+// first byte at or after `pos` (and before `end`) that ends the run, or `end`.
+// They look at 32 bytes per step with AVX2, 16 with SSE2, and fall back to a
+// plain loop elsewhere. None of the runs can contain '\n', so a caller only has
+// to move its column by the distance skipped.
+
+// ' ', '\t' and '\r'
+size_t scanBlanks(const char *text, size_t pos, size_t end);
+
+// [A-Za-z0-9_]
+size_t scanIdentifier(const char *text, size_t pos, size_t end);
+
+// stops on `quote`, '\\', '\n' or '\0'
+size_t scanString(const char *text, size_t pos, size_t end, char quote);
+
+#endif
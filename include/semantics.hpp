@@ -1,20 +1,12 @@
 #pragma once
-#include "parser.hpp"
+#include "ast.hpp"
+#include "diagnostics.hpp"
+#include "symbols.hpp"
 #include <iostream>
 #include <unordered_map>
 #include <vector>
 #include <string>
 
-enum VarType {
-    TYPE_UNKNOWN,
-    TYPE_INT,
-    TYPE_STRING,
-    TYPE_BOOL,
-    TYPE_FUNCTION,
-    TYPE_FLOAT,
-    TYPE_DICT,
-};
-
 string vartypestr(VarType type);
 
 struct VarInfo {
@@ -22,6 +14,46 @@ struct VarInfo {
     bool initialized;
 };
 
+// Variables in lexical scopes: the file's globals in a flat table by symbol,
+// and above them one frame per enclosing def, page or loop body. Frames are
+// runs of one reusable stack buffer, so pushing records a position, popping
+// truncates back to it, and the buffer is only ever as big as the deepest
+// nesting seen, however many bodies the program has.
+class ScopeStack {
+public:
+    void push();
+    void pop();
+    // Innermost binding of `name`, else the global one; null if neither exists.
+    VarInfo *find(Symbol name);
+    // Update `name` where it is bound, or bind it in the innermost scope.
+    void assign(Symbol name, VarInfo info);
+    // Bind `name` in the innermost scope, shadowing any outer binding.
+    void declare(Symbol name, VarInfo info);
+
+    SymbolMap<VarInfo> &globals() { return global; }
+    const SymbolMap<VarInfo> &globals() const { return global; }
+
+    // Pushes a frame for as long as it lives, however the body is left.
+    class Frame {
+    public:
+        explicit Frame(ScopeStack &stack) : stack(stack) { stack.push(); }
+        ~Frame() { stack.pop(); }
+        Frame(const Frame &) = delete;
+        Frame &operator=(const Frame &) = delete;
+    private:
+        ScopeStack &stack;
+    };
+
+private:
+    struct Binding {
+        Symbol name;
+        VarInfo info;
+    };
+    SymbolMap<VarInfo> global;
+    std::vector<Binding> bindings;   // every open frame's, innermost last
+    std::vector<uint32_t> frames;    // where each open frame starts in `bindings`
+};
+
 struct PageInfo {
     string title;
     bool index;
@@ -35,29 +67,41 @@ struct CallableInfo {
 };
 
 struct InstanceInfo {
-    std::unordered_map<std::string, CallableInfo> callables; //
+    SymbolMap<CallableInfo> callables; //
     bool issystemdefined;
 };
 
 class SemanticAnalyzer {
 public:
-    SemanticAnalyzer();
-    void analyze(AST_NODE *root);
+    SemanticAnalyzer(Diagnostics &diagnostics);
+    // Also records in `ast` the type of every node it checks, and which ones
+    // touch reactive state, so codegen can read them instead of re-deriving.
+    void analyze(Ast &ast);
+    // Make the top-level names of an already analyzed module visible here.
+    // Call before analyze().
+    void importFrom(const SemanticAnalyzer &module);
 
 private:
-    std::unordered_map<std::string, VarInfo> scope;
-    std::unordered_map<std::string, VarInfo> statevars;
-    std::unordered_map<std::string, VarInfo> declaredFunctions;
-    std::vector<std::string> calledFunctions;
-    std::unordered_map<std::string, PageInfo> pagescope;
-    std::unordered_map<std::string, InstanceInfo> instances;
-    std::unordered_map<std::string, CallableInfo> draw_callables;
+    // all keyed by the name's symbol
+    ScopeStack scopes;
+    SymbolMap<VarInfo> statevars;
+    SymbolMap<VarInfo> declaredFunctions;
+    std::vector<Symbol> calledFunctions;
+    SymbolMap<PageInfo> pagescope; // by route
+    SymbolMap<InstanceInfo> instances;
+    SymbolMap<CallableInfo> draw_callables;
+
+    SymbolMap<CallableInfo> platform_callables;
 
-    std::unordered_map<std::string, CallableInfo> platform_callables;
+    Diagnostics *diagnostics;
+    Ast *annotated = nullptr;
 
 
 
-    void parserError(const std::string &message, AST_NODE* current);
-    VarType checkNode(AST_NODE *node, bool uiexceptonstylsheet = false, bool funcdecl = false, bool isfrompage = false);
+    void parserError(const std::string &message, AstNode current);
+    VarType checkNode(AstNode node, bool uiexceptonstylsheet = false, bool funcdecl = false, bool isfrompage = false);
+    VarType inferNode(AstNode node, bool uiexceptonstylsheet, bool funcdecl, bool isfrompage);
+    void markState(AstNode node);
+    VarType checkStatement(AstNode node, bool uiexceptonstylsheet = false, bool funcdecl = false, bool isfrompage = false);
     void semanticError(const std::string &msg);
 };
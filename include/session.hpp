@@ -0,0 +1,95 @@
+#pragma once
+#ifndef __SESSION_H
+#define __SESSION_H
+#include "diagnostics.hpp"
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+// Bump allocator. Memory comes from a chain of geometrically growing blocks and
+// is only given back when the arena dies, so allocation is a pointer bump and
+// release costs one free() per block rather than one per object.
+class Arena : public std::pmr::memory_resource
+{
+    public:
+        explicit Arena(size_t firstBlock = 64 << 10);
+        ~Arena();
+        Arena(const Arena &) = delete;
+        Arena &operator=(const Arena &) = delete;
+
+        // Construct a T in the arena. Objects with a non-trivial destructor get a
+        // cleanup entry; everything else is simply forgotten when the arena goes.
+        template <typename T, typename... Args>
+        T *make(Args &&...args)
+        {
+            T *object = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+            if constexpr (!std::is_trivially_destructible_v<T>)
+            {
+                adopt(object);
+            }
+            return object;
+        }
+
+        // Run `object`'s destructor when the arena dies.
+        template <typename T>
+        void adopt(T *object)
+        {
+            addCleanup(object, [](void *p) { ((T *)p)->~T(); });
+        }
+
+        // Bytes handed out, and bytes reserved from the system.
+        size_t used() const { return usedBytes; }
+        size_t reserved() const { return reservedBytes; }
+
+    protected:
+        void *do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void *, size_t, size_t) override {}
+        bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+
+    private:
+        struct Block
+        {
+            Block *previous;
+            size_t size;
+        };
+        struct Cleanup
+        {
+            Cleanup *next;
+            void *object;
+            void (*destroy)(void *);
+        };
+
+        Block *blocks = nullptr;
+        Cleanup *cleanups = nullptr;
+        char *cursor = nullptr;
+        char *limit = nullptr;
+        size_t nextBlock;
+        size_t usedBytes = 0;
+        size_t reservedBytes = 0;
+
+        void grow(size_t atLeast);
+        void addCleanup(void *object, void (*destroy)(void *));
+};
+
+// Everything one lex -> parse -> sema -> codegen run allocates lives here and
+// goes away together when the session ends.
+class CompilationSession
+{
+    public:
+        Arena arena;
+        Diagnostics diagnostics;
+
+        template <typename T, typename... Args>
+        T *make(Args &&...args) { return arena.make<T>(std::forward<Args>(args)...); }
+
+        // AST strings. Only those too long for the small-string buffer need a cleanup.
+        std::string *text(std::string_view value);
+
+        size_t bytesUsed() const { return arena.used(); }
+};
+
+#endif
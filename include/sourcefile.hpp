@@ -0,0 +1,36 @@
+#pragma once
+#ifndef __SOURCEFILE_H
+#define __SOURCEFILE_H
+#include <string>
+#include <string_view>
+
+// Read-only view of a source file on disk. The file is memory-mapped where the
+// platform allows it; otherwise it is read() once into an owned buffer. Either
+// way the bytes are never copied again: the lexer, token stream and source map
+// all hold views into this object, so it must outlive them.
+class SourceFile
+{
+    public:
+        SourceFile() = default;
+        ~SourceFile();
+        SourceFile(const SourceFile &) = delete;
+        SourceFile &operator=(const SourceFile &) = delete;
+
+        bool open(const std::string &path);
+        void close();
+
+        std::string_view text() const { return std::string_view(data, length); }
+        bool isMapped() const { return mapped; }
+
+    private:
+        const char *data = nullptr;
+        size_t length = 0;
+        bool mapped = false;
+        std::string buffer; // read() fallback storage
+#ifdef _WIN32
+        void *fileHandle = nullptr;
+        void *mappingHandle = nullptr;
+#endif
+};
+
+#endif
@@ -0,0 +1,137 @@
+#pragma once
+#ifndef __SYMBOLS_H
+#define __SYMBOLS_H
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Dense id of an interned string. 0 is "no symbol"; its name reads as empty.
+using Symbol = uint32_t;
+
+// Every identifier and AST value the compiler has seen, each under one id for
+// the life of the process. The lexer interns identifiers as it scans them, so
+// later stages compare and look names up by id and never hash the text again.
+//
+// Interning is safe from any thread: the table is split into shards, each with
+// its own lock. Reading a name back takes no lock at all, since names are
+// never moved once stored.
+class Symbols
+{
+    public:
+        static Symbol intern(std::string_view name);
+        static const std::string &name(Symbol symbol);
+        // One past the highest id handed out so far.
+        static size_t count();
+};
+
+// Table keyed by symbol: a flat slot array indexed by id in front of the
+// entries themselves, which keep insertion order. Lookup is an array index.
+template <typename T>
+class SymbolMap
+{
+    public:
+        using Entry = std::pair<Symbol, T>;
+
+        SymbolMap() = default;
+        SymbolMap(std::initializer_list<std::pair<std::string_view, T>> named)
+        {
+            for (const auto &[name, value] : named)
+            {
+                (*this)[Symbols::intern(name)] = value;
+            }
+        }
+
+        T *find(Symbol symbol)
+        {
+            uint32_t slot = symbol < slots.size() ? slots[symbol] : 0;
+            return slot ? &entries[slot - 1].second : nullptr;
+        }
+        const T *find(Symbol symbol) const { return const_cast<SymbolMap *>(this)->find(symbol); }
+        bool contains(Symbol symbol) const { return find(symbol) != nullptr; }
+
+        T &operator[](Symbol symbol)
+        {
+            if (T *value = find(symbol))
+            {
+                return *value;
+            }
+            if (symbol >= slots.size())
+            {
+                slots.resize(symbol + 1, 0);
+            }
+            entries.push_back({symbol, T()});
+            slots[symbol] = entries.size();
+            return entries.back().second;
+        }
+
+        // Adds the entries of `other` this map doesn't have yet.
+        void insert(const SymbolMap &other)
+        {
+            for (const Entry &entry : other.entries)
+            {
+                if (!contains(entry.first))
+                {
+                    (*this)[entry.first] = entry.second;
+                }
+            }
+        }
+
+        void clear()
+        {
+            for (const Entry &entry : entries)
+            {
+                slots[entry.first] = 0;
+            }
+            entries.clear();
+        }
+
+        size_t size() const { return entries.size(); }
+        bool empty() const { return entries.empty(); }
+        typename std::vector<Entry>::const_iterator begin() const { return entries.begin(); }
+        typename std::vector<Entry>::const_iterator end() const { return entries.end(); }
+
+    private:
+        std::vector<Entry> entries;
+        std::vector<uint32_t> slots; // by symbol: 1 + position in entries, 0 if absent
+};
+
+// Set of symbols, in insertion order.
+class SymbolSet
+{
+    public:
+        bool contains(Symbol symbol) const { return symbol < present.size() && present[symbol]; }
+        void insert(Symbol symbol)
+        {
+            if (symbol >= present.size())
+            {
+                present.resize(symbol + 1, false);
+            }
+            if (!present[symbol])
+            {
+                present[symbol] = true;
+                members.push_back(symbol);
+            }
+        }
+        void clear()
+        {
+            for (Symbol symbol : members)
+            {
+                present[symbol] = false;
+            }
+            members.clear();
+        }
+
+        bool empty() const { return members.empty(); }
+        std::vector<Symbol>::const_iterator begin() const { return members.begin(); }
+        std::vector<Symbol>::const_iterator end() const { return members.end(); }
+
+    private:
+        std::vector<Symbol> members;
+        std::vector<bool> present;
+};
+
+#endif
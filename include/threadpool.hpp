@@ -0,0 +1,108 @@
+#pragma once
+#ifndef __THREADPOOL_H
+#define __THREADPOOL_H
+#include <condition_variable>
+#include <cstdlib>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Fixed-size worker pool shared by the compiler's parallel stages.
+// Jobs must not block on other jobs of the same pool; callers that may already
+// be running on a worker check onWorkerThread() and do the work inline instead.
+class ThreadPool
+{
+    public:
+        explicit ThreadPool(unsigned count = std::thread::hardware_concurrency())
+        {
+            if (count == 0)
+            {
+                count = 1;
+            }
+            for (unsigned i = 0; i < count; i++)
+            {
+                workers.emplace_back([this] { work(); });
+            }
+        }
+
+        ~ThreadPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            wake.notify_all();
+            for (std::thread &worker : workers)
+            {
+                worker.join();
+            }
+        }
+
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        template <typename F>
+        std::future<std::invoke_result_t<F>> submit(F &&job)
+        {
+            auto task = std::make_shared<std::packaged_task<std::invoke_result_t<F>()>>(std::forward<F>(job));
+            std::future<std::invoke_result_t<F>> result = task->get_future();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                jobs.push([task] { (*task)(); });
+            }
+            wake.notify_one();
+            return result;
+        }
+
+        unsigned size() const { return workers.size(); }
+
+        static bool onWorkerThread() { return isWorker(); }
+
+        // Process-wide pool sized to the machine, or to HELIOS_THREADS when set.
+        static ThreadPool &shared()
+        {
+            const char *threads = std::getenv("HELIOS_THREADS");
+            static ThreadPool pool(threads ? (unsigned)std::strtoul(threads, nullptr, 10) : std::thread::hardware_concurrency());
+            return pool;
+        }
+
+    private:
+        std::vector<std::thread> workers;
+        std::queue<std::function<void()>> jobs;
+        std::mutex mutex;
+        std::condition_variable wake;
+        bool stopping = false;
+
+        static bool &isWorker()
+        {
+            static thread_local bool worker = false;
+            return worker;
+        }
+
+        void work()
+        {
+            isWorker() = true;
+            for (;;)
+            {
+                std::function<void()> job;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    wake.wait(lock, [this] { return stopping || !jobs.empty(); });
+                    if (stopping && jobs.empty())
+                    {
+                        return;
+                    }
+                    job = std::move(jobs.front());
+                    jobs.pop();
+                }
+                job();
+            }
+        }
+};
+
+#endif
@@ -0,0 +1,7 @@
+#pragma once
+#ifndef __VERSION_H
+#define __VERSION_H
+
+#define HELIOS_VERSION "0.1.0"
+
+#endif
@@ -0,0 +1,80 @@
+#pragma once
+#ifndef __CODEWRITER_H
+#define __CODEWRITER_H
+#include <charconv>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// Append-only sink for generated code. Text lands in chunks that are never
+// moved or copied once written: when one fills, the next is allocated, each
+// twice the size of the one before up to CHUNK. Output made out of order (a
+// function body before its return type is known, the whole of main before its
+// header) goes into a writer of its own and is spliced in whole with append().
+// writeTo() hands every chunk to the OS in one gathered write.
+class CodeWriter
+{
+    public:
+        static constexpr size_t FIRST_CHUNK = 256;
+        static constexpr size_t CHUNK = 64 << 10;
+
+        CodeWriter() = default;
+        CodeWriter(CodeWriter &&) = default;
+        CodeWriter &operator=(CodeWriter &&) = default;
+        CodeWriter(const CodeWriter &) = delete;
+        CodeWriter &operator=(const CodeWriter &) = delete;
+
+        CodeWriter &operator<<(std::string_view text)
+        {
+            if (text.size() > spare())
+            {
+                grow(text.size());
+            }
+            Chunk &chunk = chunks.back();
+            text.copy(chunk.data.get() + chunk.used, text.size());
+            chunk.used += text.size();
+            bytes += text.size();
+            return *this;
+        }
+        CodeWriter &operator<<(const std::string &text) { return *this << std::string_view(text); }
+        CodeWriter &operator<<(const char *text) { return *this << std::string_view(text); }
+        CodeWriter &operator<<(char c) { return *this << std::string_view(&c, 1); }
+
+        template <typename T, typename = std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, char> && !std::is_same_v<T, bool>>>
+        CodeWriter &operator<<(T number)
+        {
+            char digits[24];
+            return *this << std::string_view(digits, std::to_chars(digits, digits + sizeof digits, number).ptr - digits);
+        }
+
+        // Move everything `other` holds onto the end of this writer.
+        void append(CodeWriter &&other);
+
+        size_t size() const { return bytes; }
+        bool empty() const { return bytes == 0; }
+        std::string str() const;
+
+        // Creates the parent directory if needed; false if the file can't be written.
+        bool writeTo(const std::string &path) const;
+        // Same, but a file already holding this text is left alone, so its
+        // modification time still says when it last changed.
+        bool writeIfChanged(const std::string &path) const;
+
+    private:
+        struct Chunk {
+            std::unique_ptr<char[]> data;
+            size_t used = 0;
+            size_t capacity = 0;
+        };
+        std::vector<Chunk> chunks;
+        size_t bytes = 0;
+        size_t nextChunk = FIRST_CHUNK; // not reset by append(), so splicing in small writers doesn't shrink ours
+
+        size_t spare() const { return chunks.empty() ? 0 : chunks.back().capacity - chunks.back().used; }
+        void grow(size_t needed);
+};
+
+#endif
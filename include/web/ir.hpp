@@ -0,0 +1,117 @@
+#pragma once
+#ifndef __IR_H
+#define __IR_H
+#include "ast.hpp"
+#include "codewriter.hpp"
+#include "symbols.hpp"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// What WebEngine lowers the checked Ast to before printing C++: each page as a
+// list of UI-tree ops, every value those ops use as a three-address IrExpr.
+// IrPasses rewrite the ops in between, so the printer only ever sees the
+// result. Statements with no ops of their own yet travel as IR_RAW C++ text.
+
+enum IrValueOp : uint8_t {
+    VALUE_CONST,   // literal; text is its C++ spelling, or the characters of a TYPE_STRING
+    VALUE_NAME,    // a C++ name, printed as text
+    VALUE_STATE,   // current value of the @state `text`
+    VALUE_BINARY,  // operands[0] text operands[1]
+    VALUE_POSTFIX, // operands[0] text
+    VALUE_CALL,    // text(operands...)
+};
+
+struct IrValue {
+    IrValueOp op;
+    VarType type = TYPE_UNKNOWN;
+    std::string text;
+    Symbol symbol = 0;              // the variable of a VALUE_NAME or VALUE_STATE
+    std::vector<uint32_t> operands; // earlier values of the same IrExpr
+};
+
+// An expression as values each computed from earlier ones; the last is the
+// result. Empty when there is no expression.
+struct IrExpr {
+    std::vector<IrValue> values;
+
+    bool empty() const { return values.empty(); }
+    uint32_t result() const { return values.size() - 1; }
+    uint32_t push(IrValue value)
+    {
+        values.push_back(std::move(value));
+        return values.size() - 1;
+    }
+    // The lone string literal this expression is, if it is one.
+    const std::string *literal() const;
+};
+
+enum IrOpKind : uint8_t {
+    IR_RAW,     // C++ statements, as text
+    IR_STATE,   // auto name = make_shared<appstate::State<key>>("name", value)
+    IR_ELEMENT, // VNode name(key[, value])
+    IR_ATTR,    // name.setAttr(key, value)
+    IR_FIELD,   // name.key = value
+    IR_CLICK,   // name.onClick([captures]() { body; updateUI(mask); })
+    IR_APPEND,  // key.addChild(name)
+    IR_SECTION, // if (page.section(index, mask)) { body }
+    IR_STATIC,  // static constexpr char name[] = value; key.addChild(VNode::prerendered(name))
+};
+
+struct IrOp {
+    IrOpKind kind;
+    std::string name; // the element or state variable; the text of an IR_RAW
+    std::string key;  // attribute, field, tag, parent or C++ type, by kind
+    IrExpr value;
+    std::vector<IrOp> body;             // IR_CLICK, IR_SECTION
+    std::vector<std::string> captures;  // IR_CLICK
+    Symbol symbol = 0;                  // IR_STATE; for an IR_RAW, the page variable it assigns
+    std::vector<Symbol> uses;           // IR_RAW: names it reads; IR_CLICK: states it assigns
+    bool opaque = false;                // IR_RAW: calls out, so may read any state
+    uint32_t index = 0;                 // IR_SECTION
+    uint64_t mask = ~uint64_t(0);       // IR_SECTION: state read; IR_CLICK: state written
+};
+
+// One unit WebEngine lowers at a time: a page's builder, or an element made
+// outside one.
+struct IrPage {
+    std::vector<IrOp> ops;
+};
+
+class IrPass
+{
+    public:
+        virtual ~IrPass() = default;
+        virtual const char *name() const = 0;
+        virtual void run(IrPage &page) = 0;
+};
+
+// Passes in the order they were added.
+class PassManager
+{
+    public:
+        void add(std::unique_ptr<IrPass> pass);
+        void run(IrPage &page);
+
+        // What every build runs.
+        static PassManager standard();
+
+    private:
+        std::vector<std::unique_ptr<IrPass>> passes;
+};
+
+// The C++ for IR, laid out as WebEngine has always printed it.
+std::string cppLiteral(const std::string &text);
+std::string maskLiteral(uint64_t mask);
+std::string printExpr(const IrExpr &expr);
+void printOps(const std::vector<IrOp> &ops, CodeWriter &out);
+CodeWriter &operator<<(CodeWriter &out, const IrExpr &expr);
+
+// An expression passed to a function: a lone string literal goes in unwrapped.
+struct IrArgument {
+    const IrExpr &expr;
+};
+CodeWriter &operator<<(CodeWriter &out, const IrArgument &argument);
+
+#endif
@@ -0,0 +1,45 @@
+#pragma once
+#ifndef __IRPASSES_H
+#define __IRPASSES_H
+#include "ir.hpp"
+
+// Joins string constants the lowering left as separate pieces, so a style with
+// no variables in it prints as one literal.
+class FoldStrings : public IrPass
+{
+    public:
+        const char *name() const override { return "fold-strings"; }
+        void run(IrPage &page) override;
+};
+
+// Replaces each element subtree built only from literals (no state, variable,
+// click or statement anywhere in it) with its HTML, serialized here the way the
+// runtime's renderToHTML would, as a static constexpr string. Canvases keep
+// their ops; the runtime mounts them separately.
+class HoistStatic : public IrPass
+{
+    public:
+        const char *name() const override { return "hoist-static"; }
+        void run(IrPage &page) override;
+};
+
+// Works out the state bits each section reads and each click writes: bit i for
+// the page's i-th @state, and for a page variable whatever it was computed
+// from. Anything it can't place keeps every bit.
+class StateMasks : public IrPass
+{
+    public:
+        const char *name() const override { return "state-masks"; }
+        void run(IrPage &page) override;
+
+    private:
+        SymbolMap<uint64_t> dependencies;
+        size_t states = 0;
+
+        uint64_t reads(const IrExpr &expr) const;
+        uint64_t reads(const IrOp &op) const;
+        uint64_t writes(const IrOp &op) const;
+        void assign(std::vector<IrOp> &ops);
+};
+
+#endif
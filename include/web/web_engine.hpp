@@ -7,7 +7,10 @@
 #include <vector>
 #include <unordered_map>
 #include <algorithm>
-#include "parser.hpp" 
+#include <cstdint>
+#include "ast.hpp"
+#include "codewriter.hpp"
+#include "ir.hpp"
 
 using namespace std;
 
@@ -16,40 +19,64 @@ class WebEngine {
         // A runtime environment for values known at generation-time (optional).
         // You can populate this map before calling gen() if you want generator-time resolution.
         unordered_map<string,string> env;
-        stringstream filebuffer;
-        stringstream mainbuffer;
+        CodeWriter headerbuffer; // app.hpp, which every unit includes: functions and page builder declarations
+        CodeWriter filebuffer; // app.cpp above main()
+        CodeWriter mainbuffer; // route table, first thing in main()
+        // The translation units gen() wrote, app.cpp first. Core::builder compiles
+        // each on its own and links them.
+        vector<string> units;
 
         WebEngine();
 
-        string pyxtocpp_type(enum NODE_TYPE type, AST_NODE* node);
+        string cppType(AstNode node);
 
-        bool gen(AST_NODE *root);
+        bool gen(const Ast &ast);
     private:
         int idcount;
         int pagecount;
-        vector<string> statevars;
-        unordered_map<string, bool> variable_buffer;
-        
+        SymbolSet statevars; // state variables of the page being generated, for lambda captures
+        SymbolMap<bool> variable_buffer; // globals, true for stylesheets; in declaration order
+        // Root variables some page unit reads, with their C++ type. They live at
+        // namespace scope in app.cpp instead of in main(), so the units can see them.
+        SymbolMap<string> hoisted;
+        // Pages built in a unit of their own, by node id, with the hoisted variables each reads.
+        unordered_map<uint32_t, vector<Symbol>> pageunits;
+        vector<pair<string, CodeWriter>> pagefiles;
+        PassManager passes = PassManager::standard();
 
-        // Escape C-style string literal (for embedding fixed literal pieces in generated C++ code)
-        static string escape_for_cpp_literal(const string &in);
+        void conditionFor(AstNode p, CodeWriter &out);
 
-        // Helper to create a C++ literal: "\"...\""
-        static string cpp_literal(const string &s);
-        
-        string exprForNode(AST_NODE *p);
+        // Picks the root pages that can go in units of their own: those reading
+        // only root variables whose type can be spelled out.
+        void planUnits(const Ast &ast);
+        string globalType(AstNode p);
+        void declareGlobals(const vector<Symbol> &names, CodeWriter &out);
+        static void collectNames(AstNode p, SymbolSet &names);
+
+        // Ast -> IR. Statements the IR has no ops for are printed by HandleAst
+        // and carried as IR_RAW.
+        uint32_t lowerExpr(AstNode p, IrExpr &expr);
+        IrExpr lowerExpr(AstNode p);
+        IrExpr lowerAttribute(AstNode p);
+        IrExpr lowerStyle(AstNode dict);
+        IrOp lowerState(AstNode p);
+        IrOp lowerStatement(AstNode p, string parent, bool funcdecl = false);
+        void lowerElement(AstNode p, string parent, string el, string eltype, bool isvar, vector<IrOp> &ops);
+        static bool elementKind(NODE_TYPE type, string &el, string &eltype);
+        static void collectUses(AstNode p, IrOp &op);
+        static bool addsChildren(AstNode p);
+        static void collectWrites(AstNode p, vector<Symbol> &states);
 
-        string MakePage(AST_NODE *p, string var, bool firstpage=false); 
+        // Emitters write straight into `out`.
+        void MakePage(AstNode p, string var, CodeWriter &out, bool firstpage=false); 
         
-        string MakeElement(AST_NODE *p, string parent = "root", string el = "div",string eltype = "view", bool isvar=false);
+        void MakeElement(AstNode p, CodeWriter &out, string parent = "root", string el = "div",string eltype = "view", bool isvar=false);
 
-        string MakeConversion(AST_NODE *p, NODE_TYPE type, bool isroot = false);
+        void MakeConversion(AstNode p, NODE_TYPE type, CodeWriter &out, bool isroot = false);
 
-        string MakeDraw(AST_NODE *p,bool isroot=true, string parent="root");
+        void MakeDraw(AstNode p, CodeWriter &out, bool isroot=true, string parent="root");
 
-        string makeMath(AST_NODE *p, NODE_TYPE nodetype);
+        void makeMath(AstNode p, NODE_TYPE nodetype, CodeWriter &out);
 
-        string HandleAst(AST_NODE *p, string parent = "root", bool funcdecl=false, bool fromui = true);
-        // Write file to disk
-        bool makefile(const string &directoryPath, const string &filebuffer);
+        void HandleAst(AstNode p, CodeWriter &out, string parent = "root", bool funcdecl=false, bool fromui = true);
 };
\ No newline at end of file
@@ -9,6 +9,7 @@
 #include <cstring>
 
 #include "core.hpp"
+#include "version.hpp"
 
 
 using namespace std;
@@ -65,17 +66,18 @@ int main(int argc, char ** argv) {
         Core.buildTarget(targets, projectName);
     } else if (cmd == "clean") {
         string projectName = targets[0];
-        Core.cleanProject(projectName);
+        bool runtime = find(targets.begin(), targets.end(), "--runtime") != targets.end();
+        Core.cleanProject(projectName, runtime);
     } else if (cmd == "help") {
         cout << "Available commands:\n";
         cout << "  create <project_name> - Create a new project\n";
         cout << "  dev <project_name> - Start development server\n";
         cout << "  run <project_name> - Run the project\n";
         cout << "  build <project_name> - Build the project\n";
-        cout << "  clean <project_name> - Clean the project\n";
+        cout << "  clean <project_name> [--runtime] - Clean the project; --runtime also drops the shared runtime builds\n";
         cout << "  help - Show this help message\n";
     } else if (cmd == "--version" || cmd == "-v") {
-        cout << "Helios CLI Version 0.1.0\n";
+        cout << "Helios CLI Version " HELIOS_VERSION "\n";
 
     } else {
         cout << "Unknown command: " << cmd << "\n";
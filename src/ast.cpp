@@ -0,0 +1,228 @@
+#include "ast.hpp"
+#include <utility>
+
+static size_t countNodes(const AST_NODE *node)
+{
+    if (!node)
+    {
+        return 1;
+    }
+    size_t count = 1 + (node->CHILD ? countNodes(node->CHILD) : 0);
+    for (const AST_NODE *sub : node->SUB_STATEMENTS)
+    {
+        count += countNodes(sub);
+    }
+    return count;
+}
+
+Ast::Ast(std::pmr::memory_resource *arena)
+    : kinds(arena), children(arena), firstChild(arena), nextSibling(arena), childCounts(arena),
+      symbols(arena), numbers(arena), types(arena), flags(arena), lines(arena), columns(arena), offsets(arena), lengths(arena)
+{
+}
+
+Ast::Ast(const AST_NODE *root, std::pmr::memory_resource *arena) : Ast(arena)
+{
+    reserve(countNodes(root));
+    layout(root, allocate(root));
+}
+
+Ast::Ast(const std::vector<const Ast *> &modules, std::pmr::memory_resource *arena) : Ast(arena)
+{
+    size_t count = 1;
+    for (const Ast *module : modules)
+    {
+        count += module->size();
+    }
+    reserve(count);
+
+    uint32_t root = push(NODE_ROOT, 0, NumericValue{0}, 0, 0, 0, 0);
+    std::vector<std::pair<const Ast *, uint32_t>> statements;
+    for (const Ast *module : modules)
+    {
+        for (AstNode statement : module->root().subs())
+        {
+            if (statement && statement.type() != NODE_IMPORT)
+            {
+                statements.push_back({module, statement.id()});
+            }
+        }
+    }
+    uint32_t first = kinds.size();
+    for (size_t i = 0; i < statements.size(); i++)
+    {
+        copy(*statements[i].first, statements[i].second);
+        if (i + 1 < statements.size())
+        {
+            nextSibling[first + i] = first + i + 1;
+        }
+    }
+    if (!statements.empty())
+    {
+        firstChild[root] = first;
+        childCounts[root] = statements.size();
+    }
+    for (size_t i = 0; i < statements.size(); i++)
+    {
+        layout(*statements[i].first, statements[i].second, first + i);
+    }
+}
+
+void Ast::reserve(size_t count)
+{
+    kinds.reserve(count);
+    children.reserve(count);
+    firstChild.reserve(count);
+    nextSibling.reserve(count);
+    childCounts.reserve(count);
+    symbols.reserve(count);
+    numbers.reserve(count);
+    types.reserve(count);
+    flags.reserve(count);
+    lines.reserve(count);
+    columns.reserve(count);
+    offsets.reserve(count);
+    lengths.reserve(count);
+}
+
+uint32_t Ast::push(uint8_t kind, Symbol symbol, NumericValue number, uint32_t line, uint32_t column,
+                   uint32_t offset, uint32_t length)
+{
+    uint32_t id = kinds.size();
+    kinds.push_back(kind);
+    children.push_back(NONE);
+    firstChild.push_back(NONE);
+    nextSibling.push_back(NONE);
+    childCounts.push_back(0);
+    symbols.push_back(symbol);
+    numbers.push_back(number);
+    types.push_back(TYPE_UNKNOWN);
+    flags.push_back(0);
+    lines.push_back(line);
+    columns.push_back(column);
+    offsets.push_back(offset);
+    lengths.push_back(length);
+    return id;
+}
+
+uint32_t Ast::allocate(const AST_NODE *node)
+{
+    if (!node)
+    {
+        return push(EMPTY, 0, NumericValue{0}, 0, 0, 0, 0);
+    }
+    // identifiers were interned by the lexer; other values (literals, operators) are interned here
+    Symbol symbol = node->value.symbol;
+    if (!symbol && node->value)
+    {
+        symbol = Symbols::intern(*node->value);
+    }
+    return push(node->TYPE, symbol, node->number, node->lineno, node->charno, node->offset, node->length);
+}
+
+uint32_t Ast::copy(const Ast &from, uint32_t id)
+{
+    uint32_t to = push(from.kinds[id], from.symbols[id], from.numbers[id], from.lines[id], from.columns[id], from.offsets[id], from.lengths[id]);
+    types[to] = from.types[id];
+    flags[to] = from.flags[id];
+    return to;
+}
+
+// Give the node's CHILD and its whole SUB_STATEMENTS block their slots first,
+// then lay out each of them in turn.
+void Ast::layout(const AST_NODE *node, uint32_t id)
+{
+    if (!node)
+    {
+        return;
+    }
+    if (node->CHILD)
+    {
+        children[id] = allocate(node->CHILD);
+    }
+    uint32_t count = node->SUB_STATEMENTS.size();
+    uint32_t first = kinds.size();
+    for (uint32_t i = 0; i < count; i++)
+    {
+        allocate(node->SUB_STATEMENTS[i]);
+        if (i + 1 < count)
+        {
+            nextSibling[first + i] = first + i + 1;
+        }
+    }
+    if (count)
+    {
+        firstChild[id] = first;
+        childCounts[id] = count;
+    }
+
+    if (node->CHILD)
+    {
+        layout(node->CHILD, children[id]);
+    }
+    for (uint32_t i = 0; i < count; i++)
+    {
+        layout(node->SUB_STATEMENTS[i], first + i);
+    }
+}
+
+// Same as above, copying from another Ast's node `source` into `id`.
+void Ast::layout(const Ast &from, uint32_t source, uint32_t id)
+{
+    if (from.kinds[source] == EMPTY)
+    {
+        return;
+    }
+    uint32_t child = from.children[source];
+    if (child != NONE)
+    {
+        children[id] = copy(from, child);
+    }
+    uint32_t count = from.childCounts[source];
+    uint32_t sourceFirst = from.firstChild[source];
+    uint32_t first = kinds.size();
+    for (uint32_t i = 0; i < count; i++)
+    {
+        copy(from, sourceFirst + i);
+        if (i + 1 < count)
+        {
+            nextSibling[first + i] = first + i + 1;
+        }
+    }
+    if (count)
+    {
+        firstChild[id] = first;
+        childCounts[id] = count;
+    }
+
+    if (child != NONE)
+    {
+        layout(from, child, children[id]);
+    }
+    for (uint32_t i = 0; i < count; i++)
+    {
+        layout(from, sourceFirst + i, first + i);
+    }
+}
+
+void Ast::walk(AstVisitor &visitor) const
+{
+    walk(root(), visitor, EDGE_ROOT, 0);
+}
+
+void Ast::walk(AstNode from, AstVisitor &visitor, AstEdge edge, int depth) const
+{
+    if (!from)
+    {
+        return;
+    }
+    if (visitor.enter(from, edge, depth))
+    {
+        walk(from.child(), visitor, EDGE_CHILD, depth + 1);
+        for (AstNode sub : from.subs())
+        {
+            walk(sub, visitor, EDGE_SUB, depth + 1);
+        }
+    }
+    visitor.leave(from, edge, depth);
+}
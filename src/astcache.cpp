@@ -0,0 +1,365 @@
+#include "astcache.hpp"
+#include "sourcefile.hpp"
+#include "version.hpp"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <mach-o/dyld.h>
+#endif
+
+namespace fs = std::filesystem;
+
+// Bump whenever the entry layout changes. What the parser and analysis make of
+// a file is covered by builderStamp() instead.
+static constexpr uint32_t CACHE_FORMAT = 4;
+static constexpr uint32_t NODE_KINDS = NODE_IMPORT + 1;
+
+static inline uint64_t rotl(uint64_t x, int bits)
+{
+    return (x << bits) | (x >> (64 - bits));
+}
+
+static inline uint64_t finalize(uint64_t x)
+{
+    x ^= x >> 33;
+    x *= 0xFF51AFD7ED558CCDull;
+    x ^= x >> 33;
+    x *= 0xC4CEB9FE1A85EC53ull;
+    x ^= x >> 33;
+    return x;
+}
+
+// Two lanes over 8-byte words, each with its own multipliers, crossed at the end.
+SourceHash hashSource(std::string_view text)
+{
+    const uint64_t k1 = 0x87C37B91114253D5ull;
+    const uint64_t k2 = 0x4CF5AD432745937Full;
+    uint64_t low = 0x9E3779B97F4A7C15ull ^ text.size();
+    uint64_t high = 0xC2B2AE3D27D4EB4Full + text.size();
+    size_t i = 0;
+    for (; i + 8 <= text.size(); i += 8)
+    {
+        uint64_t word;
+        std::memcpy(&word, text.data() + i, 8);
+        low = rotl(low ^ (word * k1), 31) * k2;
+        high = rotl(high + (word * k2), 29) * k1 ^ low;
+    }
+    uint64_t tail = 0;
+    if (i < text.size())
+    {
+        std::memcpy(&tail, text.data() + i, text.size() - i);
+    }
+    low = rotl(low ^ (tail * k1), 31) * k2;
+    high = rotl(high + (tail * k2), 29) * k1 ^ low;
+
+    low = finalize(low + high);
+    high = finalize(high + low);
+    return {low, high};
+}
+
+SourceHash combineHashes(SourceHash hash, SourceHash next)
+{
+    uint64_t low = finalize(hash.low ^ rotl(next.low, 17)) + next.high;
+    uint64_t high = finalize(hash.high + rotl(next.high, 41)) ^ next.low;
+    return {low, finalize(high ^ low)};
+}
+
+// Which helios wrote an entry: the running executable, where it is, when it
+// was written and how big it is. Any rebuild of helios misses every entry an
+// older build left, whatever changed in it, so nothing has to remember to bump
+// a version when the parser or analysis change.
+static SourceHash builderStamp()
+{
+    static const SourceHash stamp = [] {
+        std::string path;
+#ifdef _WIN32
+        char buffer[MAX_PATH];
+        path.assign(buffer, GetModuleFileNameA(nullptr, buffer, MAX_PATH));
+#elif defined(__APPLE__)
+        char buffer[4096];
+        uint32_t size = sizeof buffer;
+        if (_NSGetExecutablePath(buffer, &size) == 0)
+        {
+            path = buffer;
+        }
+#else
+        std::error_code unreadable;
+        path = fs::read_symlink("/proc/self/exe", unreadable).string();
+#endif
+        std::string stamp = HELIOS_VERSION;
+        std::error_code error, unsized;
+        auto written = fs::last_write_time(path, error);
+        auto size = fs::file_size(path, unsized);
+        if (!error && !unsized)
+        {
+            stamp += " " + path + "@" + std::to_string(written.time_since_epoch().count()) + "#" + std::to_string(size);
+        }
+        return hashSource(stamp);
+    }();
+    return stamp;
+}
+
+// What an entry was written from. Anything but an exact match is a miss.
+struct CacheKey {
+    char magic[8];
+    uint32_t format;
+    uint32_t nodeKinds;
+    uint64_t builderLow;
+    uint64_t builderHigh;
+    uint64_t sourceLow;
+    uint64_t sourceHigh;
+
+    CacheKey(const char *kind, SourceHash source)
+    {
+        std::memset(this, 0, sizeof *this);
+        std::strncpy(magic, kind, sizeof magic);
+        SourceHash builder = builderStamp();
+        builderLow = builder.low;
+        builderHigh = builder.high;
+        format = CACHE_FORMAT;
+        nodeKinds = NODE_KINDS;
+        sourceLow = source.low;
+        sourceHigh = source.high;
+    }
+    bool matches(std::string_view bytes) const { return bytes.size() >= sizeof *this && std::memcmp(this, bytes.data(), sizeof *this) == 0; }
+};
+
+// Entry layout, native byte order (the cache never leaves the machine):
+//   CacheKey, EntrySizes,
+//   numbers, then children, firstChild, nextSibling, childCounts, values,
+//   lines, columns, offsets and lengths, one element per node,
+//   the byte length of every value,
+//   kinds, types and flags, one byte per node each,
+//   the values' bytes back to back.
+// Symbols only mean something inside one process, so an entry numbers its
+// values 1..n in its own table and load() interns them afresh.
+struct EntrySizes {
+    uint32_t nodes;
+    uint32_t values; // not counting 0, "no value"
+    uint64_t valueBytes;
+};
+
+template <typename T>
+static void put(std::string &out, const T *data, size_t count)
+{
+    if (count)
+    {
+        out.append((const char *)data, count * sizeof(T));
+    }
+}
+
+class EntryReader
+{
+    public:
+        EntryReader(const char *at) : at(at) {}
+
+        template <typename T>
+        void into(std::pmr::vector<T> &array, size_t count)
+        {
+            array.resize(count);
+            if (count)
+            {
+                std::memcpy(array.data(), at, count * sizeof(T));
+            }
+            at += count * sizeof(T);
+        }
+        const char *skip(size_t bytes)
+        {
+            const char *from = at;
+            at += bytes;
+            return from;
+        }
+
+    private:
+        const char *at;
+};
+
+static size_t entrySize(const EntrySizes &sizes)
+{
+    return sizeof(CacheKey) + sizeof(EntrySizes) + (size_t)sizes.nodes * (sizeof(NumericValue) + 9 * sizeof(uint32_t) + 3) +
+           (size_t)sizes.values * sizeof(uint32_t) + sizes.valueBytes;
+}
+
+// Every index must land inside the Ast, so a damaged entry can't send a walk astray.
+static bool linksValid(const Ast &ast, size_t values)
+{
+    uint32_t nodes = ast.size();
+    for (uint32_t id = 0; id < nodes; id++)
+    {
+        if ((ast.children[id] != Ast::NONE && ast.children[id] >= nodes) ||
+            (ast.nextSibling[id] != Ast::NONE && ast.nextSibling[id] >= nodes) ||
+            (ast.firstChild[id] != Ast::NONE && (uint64_t)ast.firstChild[id] + ast.childCounts[id] > nodes) ||
+            ast.symbols[id] > values)
+        {
+            return false;
+        }
+    }
+    return nodes > 0;
+}
+
+std::string AstCache::entryFor(const std::string &path) const
+{
+    char name[24];
+    std::snprintf(name, sizeof name, "%016llx.ast", (unsigned long long)hashSource(path).low);
+    return (fs::path(directory) / name).string();
+}
+
+std::unique_ptr<Ast> AstCache::load(const std::string &path, SourceHash hash, CompilationSession &session) const
+{
+    SourceFile entry;
+    if (!entry.open(entryFor(path)))
+    {
+        return nullptr;
+    }
+    std::string_view bytes = entry.text();
+    CacheKey key("HLXAST", hash);
+    EntrySizes sizes;
+    if (bytes.size() < sizeof key + sizeof sizes || !key.matches(bytes))
+    {
+        return nullptr;
+    }
+    std::memcpy(&sizes, bytes.data() + sizeof key, sizeof sizes);
+    if (bytes.size() != entrySize(sizes))
+    {
+        return nullptr;
+    }
+
+    std::unique_ptr<Ast> ast(new Ast(&session.arena));
+    EntryReader in(bytes.data() + sizeof key + sizeof sizes);
+    in.into(ast->numbers, sizes.nodes);
+    in.into(ast->children, sizes.nodes);
+    in.into(ast->firstChild, sizes.nodes);
+    in.into(ast->nextSibling, sizes.nodes);
+    in.into(ast->childCounts, sizes.nodes);
+    in.into(ast->symbols, sizes.nodes);
+    in.into(ast->lines, sizes.nodes);
+    in.into(ast->columns, sizes.nodes);
+    in.into(ast->offsets, sizes.nodes);
+    in.into(ast->lengths, sizes.nodes);
+    std::pmr::vector<uint32_t> valueLengths(&session.arena);
+    in.into(valueLengths, sizes.values);
+    in.into(ast->kinds, sizes.nodes);
+    in.into(ast->types, sizes.nodes);
+    in.into(ast->flags, sizes.nodes);
+    if (!linksValid(*ast, sizes.values))
+    {
+        return nullptr;
+    }
+
+    uint64_t total = 0;
+    for (uint32_t length : valueLengths)
+    {
+        total += length;
+    }
+    if (total != sizes.valueBytes)
+    {
+        return nullptr;
+    }
+    std::vector<Symbol> symbols = {0};
+    symbols.reserve(sizes.values + 1);
+    for (uint32_t length : valueLengths)
+    {
+        symbols.push_back(Symbols::intern(std::string_view(in.skip(length), length)));
+    }
+    for (Symbol &symbol : ast->symbols)
+    {
+        symbol = symbols[symbol];
+    }
+    return ast;
+}
+
+bool AstCache::store(const std::string &path, SourceHash hash, const Ast &ast) const
+{
+    CacheKey key("HLXAST", hash);
+    SymbolMap<uint32_t> numbering;
+    std::vector<uint32_t> values(ast.size());
+    std::vector<uint32_t> valueLengths;
+    EntrySizes sizes = {(uint32_t)ast.size(), 0, 0};
+    for (size_t id = 0; id < ast.size(); id++)
+    {
+        Symbol symbol = ast.symbols[id];
+        if (!symbol)
+        {
+            continue;
+        }
+        uint32_t &number = numbering[symbol];
+        if (!number)
+        {
+            number = ++sizes.values;
+            valueLengths.push_back(Symbols::name(symbol).size());
+            sizes.valueBytes += valueLengths.back();
+        }
+        values[id] = number;
+    }
+
+    std::string out;
+    out.reserve(entrySize(sizes));
+    put(out, &key, 1);
+    put(out, &sizes, 1);
+    put(out, ast.numbers.data(), sizes.nodes);
+    put(out, ast.children.data(), sizes.nodes);
+    put(out, ast.firstChild.data(), sizes.nodes);
+    put(out, ast.nextSibling.data(), sizes.nodes);
+    put(out, ast.childCounts.data(), sizes.nodes);
+    put(out, values.data(), sizes.nodes);
+    put(out, ast.lines.data(), sizes.nodes);
+    put(out, ast.columns.data(), sizes.nodes);
+    put(out, ast.offsets.data(), sizes.nodes);
+    put(out, ast.lengths.data(), sizes.nodes);
+    put(out, valueLengths.data(), valueLengths.size());
+    put(out, ast.kinds.data(), sizes.nodes);
+    put(out, ast.types.data(), sizes.nodes);
+    put(out, ast.flags.data(), sizes.nodes);
+    for (const auto &[symbol, number] : numbering)
+    {
+        out += Symbols::name(symbol);
+    }
+    return write(entryFor(path), out);
+}
+
+bool AstCache::isChecked(SourceHash program) const
+{
+    CacheKey key("HLXOK", program);
+    SourceFile record;
+    if (!record.open((fs::path(directory) / "checked").string()))
+    {
+        return false;
+    }
+    return record.text().size() == sizeof key && key.matches(record.text());
+}
+
+void AstCache::markChecked(SourceHash program) const
+{
+    CacheKey key("HLXOK", program);
+    write((fs::path(directory) / "checked").string(), std::string((const char *)&key, sizeof key));
+}
+
+// Written beside the entry and renamed over it, so a reader sees the old entry
+// or the new one and never half of each. The temporary is named after the
+// content, so two builds racing on one entry write identical bytes.
+bool AstCache::write(const std::string &file, const std::string &bytes) const
+{
+    std::error_code error;
+    fs::create_directories(directory, error);
+    char suffix[24];
+    std::snprintf(suffix, sizeof suffix, ".%016llx", (unsigned long long)hashSource(bytes).low);
+    std::string temporary = file + suffix;
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        if (!out.write(bytes.data(), bytes.size()))
+        {
+            return false;
+        }
+    }
+    fs::rename(temporary, file, error);
+    if (error)
+    {
+        fs::remove(temporary, error);
+        return false;
+    }
+    return true;
+}
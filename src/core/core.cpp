@@ -4,17 +4,23 @@
 #include <cstring>
 
 #include "core.hpp"
+#include "sourcefile.hpp"
 #include "lexer.hpp"
 #include "parser.hpp"
 #include "astvisualise.hpp"
 #include "semantics.hpp"
+#include "module.hpp"
+#include "optimizer.hpp"
 #include "web_engine.hpp"
+#include "threadpool.hpp"
+#include "objectcache.hpp"
 
 
 #include <boost/beast.hpp>
 #include <boost/asio.hpp>
 
 #include <memory>
+#include <future>
 #include "httpserver.hpp"
 #include "websocketserver.hpp"
 #include "heliosfilewatcher.hpp"
@@ -143,7 +149,12 @@ void Core::generateFiles(const vector<string>& targets, const string& pname) {
                 </body>
                 </html>)";
             ofstream(root + "/web/vdom.hpp") << R"(#pragma once
+                // a guard as well: a precompiled copy of this header, built in
+                // another project, doesn't count as this file for #pragma once
+                #ifndef __VDOM_H
+                #define __VDOM_H
                 #include <emscripten.h>
+                #include <cstdint>
                 #include <string>
                 #include <cstring>
                 #include <vector>
@@ -151,6 +162,16 @@ void Core::generateFiles(const vector<string>& targets, const string& pname) {
                 #include <sstream>
                 #include <functional>
                 #include <algorithm>
+                // not used by the runtime itself, but by every generated unit; here so the
+                // precompiled header covers them too
+                #include <iostream>
+                #include <memory>
+                #include <format>
+                #include <cmath>
+
+                // The runtime's declarations, plus the State template. Everything else is
+                // defined in vdom.cpp, which the builder compiles once into a library that
+                // every build of the app links against.
 
                 // -------------------- Forward declarations --------------------
                 struct VPage;
@@ -158,16 +179,8 @@ void Core::generateFiles(const vector<string>& targets, const string& pname) {
 
                 // -------------------- Global Page State --------------------
                 namespace GlobalState {
-                    static VPage* currentPage = nullptr;
-                    
-                    static void setCurrentPage(VPage* page) {
-                        currentPage = page;
-                    }
-                    
-                    static VPage* getCurrentPage() {
-                        return currentPage;
-                    }
-                
+                    void setCurrentPage(VPage* page);
+                    VPage* getCurrentPage();
                 }
 
                 // -------------------- Proper State Management --------------------
@@ -176,13 +189,13 @@ void Core::generateFiles(const vector<string>& targets, const string& pname) {
                     class State {
                     private:
                         std::string key;
-                        
+        
                     public:
                         State(const std::string& k, T initial) : key(k) {
                             // Force initialization in JS storage
                             initialize(initial);
                         }
-                        
+        
                         void initialize(T initial_value) {
                             if constexpr (std::is_same_v<T, int>) {
                                 EM_ASM({
@@ -201,7 +214,7 @@ void Core::generateFiles(const vector<string>& targets, const string& pname) {
                                 }, key.c_str(), initial_value.c_str());
                             }
                         }
-                        
+        
                         void set(T new_value) {
                             if constexpr (std::is_same_v<T, int>) {
                                 EM_ASM({
@@ -215,7 +228,7 @@ void Core::generateFiles(const vector<string>& targets, const string& pname) {
                                 }, key.c_str(), new_value.c_str());
                             }
                         }
-                        
+        
                         T get() const {
                             if constexpr (std::is_same_v<T, int>) {
                                 return EM_ASM_INT({
@@ -236,7 +249,7 @@ void Core::generateFiles(const vector<string>& targets, const string& pname) {
                                     stringToUTF8(val, buffer, length);
                                     return buffer;
                                 }, key.c_str());
-                                
+                
                                 if (result) {
                                     std::string str(result);
                                     free(result);
@@ -257,25 +270,13 @@ void Core::generateFiles(const vector<string>& targets, const string& pname) {
                 private:
                     static std::unordered_map<std::string, std::function<void()>> callbacks;
                     static int nextId;
-                    
+    
                 public:
-                    static std::string registerCallback(std::function<void()> callback) {
-                        std::string id = "callback_" + std::to_string(nextId++);
-                        callbacks[id] = callback;
-                        return id;
-                    }
-                    
-                    static void invokeCallback(const std::string& id) {
-                        auto it = callbacks.find(id);
-                        if (it != callbacks.end()) {
-                            it->second();
-                        }
-                    }
+                    static std::string registerCallback(std::function<void()> callback);
+    
+                    static void invokeCallback(const std::string& id);
                 };
 
-                std::unordered_map<std::string, std::function<void()>> CallbackRegistry::callbacks;
-                int CallbackRegistry::nextId = 0;
-
                 // -------------------- VNode --------------------
                 enum class VNodeType {
                     NORMAL,
@@ -296,39 +297,35 @@ void Core::generateFiles(const vector<string>& targets, const string& pname) {
                     std::unordered_map<std::string, std::string> attrs;
                     std::function<void()> onclick;
                     std::string callback_id;
+                    const char* markup = nullptr; // whole subtree, rendered by the compiler
 
                     VNode() = default;
                     VNode(std::string t, std::string txt="") : tag(t), text(txt) {}
-                    
+
+                    // A subtree with nothing dynamic in it, as the HTML it always renders to
+                    static VNode prerendered(const char* html);
+    
                     // Helper methods for building VNodes
-                    VNode& setText(const std::string& newText) {
-                        text = newText;
-                        return *this;
-                    }
-                    
-                    VNode& setAttr(const std::string& key, const std::string& value) {
-                        if(key == "id" || type == VNodeType::CANVAS) {
-                            canvasid = value;
-                        }
-                        attrs[key] = value;
-                        return *this;
-                    }
-                    
-                    VNode& addChild(const VNode& child) {
-                        children.push_back(child);
-                        return *this;
-                    }
-                    
-                    VNode& onClick(std::function<void()> handler) {
-                        onclick = handler;
-                        return *this;
-                    }
+                    VNode& setText(const std::string& newText);
+    
+                    VNode& setAttr(const std::string& key, const std::string& value);
+    
+                    VNode& addChild(const VNode& child);
+    
+                    VNode& onClick(std::function<void()> handler);
                 };
 
                 // -------------------- VPage --------------------
+                // The builder adds each top-level element, and each statement that adds
+                // any, inside a section that the compiler tagged with the @state it
+                // reads (bit i = the page's i-th state). A rebuild for some changed
+                // state re-creates only the sections whose mask meets it, replacing
+                // the children they added last time; the others keep their nodes and
+                // HTML, however many children they hold.
                 struct VPage {
                     std::string title;
                     std::vector<VNode> children;
+                    std::vector<std::string> html; // per child, empty until rendered
                     std::unordered_map<std::string, std::string> bodyAttrs;
                     std::string stylesheet;
 
@@ -337,53 +334,32 @@ void Core::generateFiles(const vector<string>& targets, const string& pname) {
                     bool reqanimate = false;
                     std::function<void()> onanimate;
                     std::unordered_map<std::string, std::function<void()>> page_callbacks;
+                    uint64_t changed = ~0ull; // state the running build is for
+                    std::vector<size_t> sections; // children each section added, by section index
+                    size_t open = SIZE_MAX;        // section being re-created, if any
+                    size_t next = 0;               // where the next section's children go
 
-                    
+    
                     // Helper methods
-                    VPage& setTitle(const std::string& newTitle) {
-                        title = newTitle;
-                        return *this;
-                    }
+                    VPage& setTitle(const std::string& newTitle);
 
-                    VPage& addStyle(const std::string& newstylesheet) {
-                        stylesheet = newstylesheet;
-                        return *this;
-                    }
-                    
-                    VPage& addChild(const VNode& child) {
-                        children.push_back(child);
-                        return *this;
-                    }
-                    
-                    VPage& clearChildren() {
-                        children.clear();
-                        onMount_list.clear();
-                        return *this;
-                    }
+                    VPage& addStyle(const std::string& newstylesheet);
+    
+                    VPage& addChild(const VNode& child);
 
-                    void rebuild() {
-                        if (!builder) return;
-                        clearChildren();
-                        builder(*this);
-                    }
-                    
-                    // Render this page
-                    void render() {
-                        rebuild();
-                        renderPage(*this);
+                    // Whether the builder should re-create section `index`, which reads `reads`.
+                    bool section(size_t index, uint64_t reads);
+    
+                    VPage& clearChildren();
 
-                    }
-                    void onMount(std::function<void()> fn) {
-                        onMount_list.push_back(fn);
-                    }
+                    void rebuild(uint64_t state = ~0ull);
+    
+                    // Render this page
+                    void render(uint64_t state = ~0ull);
+                    void onMount(std::function<void()> fn);
 
-                    void onAnimatefps(std::function<void()> fn) {
-                        reqanimate = true;
-                        onanimate = fn;
-                    }
-                    void addevent(std::string event, std::function<void()> fn) {
-                        page_callbacks[event] = fn;
-                    }
+                    void onAnimatefps(std::function<void()> fn);
+                    void addevent(std::string event, std::function<void()> fn);
                 };
 
 
@@ -392,162 +368,55 @@ void Core::generateFiles(const vector<string>& targets, const string& pname) {
                 public:
                     Canvas2D(std::string canvasId) : id(canvasId) {}
 
-                    void clear() {
-                        EM_ASM({
-                            if (document.getElementById($0)) {
-                                const ctx = document.getElementById(UTF8ToString($0)).getContext("2d");
-                                ctx.clearRect(0, 0, ctx.canvas.width, ctx.canvas.height);
-                            }
-                            
-                        }, id.c_str());
-                    }
+                    void clear();
 
                     // if i get lost
-                    
-                    void setFill(const std::string& color) {
-                        EM_ASM({
-                            const ctx = document.getElementById(UTF8ToString($0))?.getContext("2d");
-                            if (!ctx) return;
-                            ctx.fillStyle = UTF8ToString($1);
-                        }, id.c_str(), color.c_str());
-                    }
+    
+                    void setFill(const std::string& color);
 
-                    void setStroke(const std::string& color) {
-                        EM_ASM({
-                            const ctx = document.getElementById(UTF8ToString($0))?.getContext("2d");
-                            if (!ctx) return;
-                            ctx.strokeStyle = UTF8ToString($1);
-                        }, id.c_str(), color.c_str());
-                    }
+                    void setStroke(const std::string& color);
 
-                    void lineWidth(size_t w) {
-                        EM_ASM({
-                            const ctx = document.getElementById(UTF8ToString($0))?.getContext("2d");
-                            if (!ctx) return;
-                            ctx.lineWidth = $1;
-                        }, id.c_str(), w);
-                    }
+                    void lineWidth(size_t w);
 
-                    void alpha(double a) {
-                        EM_ASM({
-                            const ctx = document.getElementById(UTF8ToString($0))?.getContext("2d");
-                            if (!ctx) return;
-                            ctx.globalAlpha = $1;
-                        }, id.c_str(), a);
-                    }
+                    void alpha(double a);
 
                     // ─────────────────────────────
                     // Shapes
                     // ─────────────────────────────
 
-                    void rect(size_t x, size_t y, size_t w, size_t h) {
-                        EM_ASM({
-                            const ctx = document.getElementById(UTF8ToString($0))?.getContext("2d");
-                            if (!ctx) return;
-                            ctx.fillRect($1, $2, $3, $4);
-                        }, id.c_str(), x, y, w, h);
-                    }
+                    void rect(size_t x, size_t y, size_t w, size_t h);
 
-                    void strokeRect(size_t x, size_t y, size_t w, size_t h) {
-                        EM_ASM({
-                            const ctx = document.getElementById(UTF8ToString($0))?.getContext("2d");
-                            if (!ctx) return;
-                            ctx.strokeRect($1, $2, $3, $4);
-                        }, id.c_str(), x, y, w, h);
-                    }
+                    void strokeRect(size_t x, size_t y, size_t w, size_t h);
 
-                    void line(size_t x1, size_t y1, size_t x2, size_t y2) {
-                        EM_ASM({
-                            const ctx = document.getElementById(UTF8ToString($0))?.getContext("2d");
-                            if (!ctx) return;
-                            ctx.beginPath();
-                            ctx.moveTo($1, $2);
-                            ctx.lineTo($3, $4);
-                            ctx.stroke();
-                        }, id.c_str(), x1, y1, x2, y2);
-                    }
+                    void line(size_t x1, size_t y1, size_t x2, size_t y2);
 
-                    void circle(size_t x, size_t y, size_t r) {
-                        EM_ASM({
-                            const ctx = document.getElementById(UTF8ToString($0))?.getContext("2d");
-                            if (!ctx) return;
-                            ctx.beginPath();
-                            ctx.arc($1, $2, $3, 0, Math.PI * 2);
-                            ctx.fill();
-                        }, id.c_str(), x, y, r);
-                    }
+                    void circle(size_t x, size_t y, size_t r);
 
-                    void strokeCircle(size_t x, size_t y, size_t r) {
-                        EM_ASM({
-                            const ctx = document.getElementById(UTF8ToString($0))?.getContext("2d");
-                            if (!ctx) return;
-                            ctx.beginPath();
-                            ctx.arc($1, $2, $3, 0, Math.PI * 2);
-                            ctx.stroke();
-                        }, id.c_str(), x, y, r);
-                    }
+                    void strokeCircle(size_t x, size_t y, size_t r);
 
                     // ─────────────────────────────
                     // Text
                     // ─────────────────────────────
 
-                    void font(const std::string& f) {
-                        EM_ASM({
-                            const ctx = document.getElementById(UTF8ToString($0))?.getContext("2d");
-                            if (!ctx) return;
-                            ctx.font = UTF8ToString($1);
-                        }, id.c_str(), f.c_str());
-                    }
+                    void font(const std::string& f);
 
-                    void text(const std::string& t, size_t x, size_t y) {
-                        EM_ASM({
-                            const ctx = document.getElementById(UTF8ToString($0))?.getContext("2d");
-                            if (!ctx) return;
-                            ctx.fillText(UTF8ToString($1), $2, $3);
-                        }, id.c_str(), t.c_str(), x, y);
-                    }
+                    void text(const std::string& t, size_t x, size_t y);
 
                     // ─────────────────────────────
                     // Transforms
                     // ─────────────────────────────
 
-                    void move(size_t x, size_t y) {
-                        EM_ASM({
-                            const ctx = document.getElementById(UTF8ToString($0))?.getContext("2d");
-                            if (!ctx) return;
-                            ctx.translate($1, $2);
-                        }, id.c_str(), x, y);
-                    }
+                    void move(size_t x, size_t y);
 
-                    void rotate(double r) {
-                        EM_ASM({
-                            const ctx = document.getElementById(UTF8ToString($0))?.getContext("2d");
-                            if (!ctx) return;
-                            ctx.rotate($1);
-                        }, id.c_str(), r);
-                    }
+                    void rotate(double r);
 
-                    void scale(double x, double y) {
-                        EM_ASM({
-                            const ctx = document.getElementById(UTF8ToString($0))?.getContext("2d");
-                            if (!ctx) return;
-                            ctx.scale($1, $2);
-                        }, id.c_str(), x, y);
-                    }
+                    void scale(double x, double y);
                 };
 
                 class Platform {
                     public:
-                        int height() {
-                            return EM_ASM_INT({
-                                return window.innerHeight || document.documentElement.clientHeight || document.body.clientHeight;
-                            });
-                        }
-                        int width() {
-                            return EM_ASM_INT({
-                                return window.innerWidth || document.documentElement.clientWidth || document.body.clientWidth;
-                            });
-                        }
+                        int height();
+                        int width();
 
 
                 };
@@ -558,78 +427,410 @@ void Core::generateFiles(const vector<string>& targets, const string& pname) {
                     using Handler = std::shared_ptr<VPage>; // store shared_ptr to avoid copies
 
                     // Add a route
-                    static void add(const std::string& path, Handler handler) {
-                        routes()[path] = handler;
-                    }
+                    static void add(const std::string& path, Handler handler);
 
                     // Navigate to a path
-                    static void navigate(const std::string& path) {
-                        auto it = routes().find(path);
-                        if (it != routes().end() && it->second) {
-                            currentPath() = path;
-                            it->second->render();
-                        } else {
-                            get404()->render();
-                        }
+                    static void navigate(const std::string& path);
+
+                    static void go(const std::string& path, bool push = true);
+
+                    // Get the current path
+                    static std::string getCurrentPath();
+
+                private:
+                    // Route map
+                    static std::unordered_map<std::string, Router::Handler>& routes();
+
+                    // Current path
+                    static std::string& currentPath();
+
+                    // 404 page
+                    static Router::Handler get404();
+                };
+
+                // -------------------- JavaScript Interop --------------------
+                extern "C" {
+                    void invokeVNodeCallback(const char* callbackId);
+                    void js_insertHTML(const char* html);
+                    void handleRoute(const char* route);
+                    void js_setTitle(const char* title);
+                    void js_insertCSS(const char* css);
+                    void js_setBodyAttr(const char* key, const char* val);
+                    char* allocateString(const char* str);
+                    void freeString(char* str);
+                    void js_mountCanvas(const char* id, const char* html);
+                    void animatefps();
+                    void js_reqfps();
+                    void handleEvent(const char* event);
+                    void js_addpageEventlisteners(const char* event);
+                }
+
+                // -------------------- Render VNode to HTML --------------------
+                std::string renderToHTML(const VNode& node);
+
+                // -------------------- Bind onclick --------------------
+                void bindOnClick(VNode& node);
+
+                // -------------------- Render Page --------------------
+                void renderPage(VPage& page);
+
+                #endif)";
+            ofstream(root + "/web/vdom.cpp") << R"(#include "vdom.hpp"
+
+                // -------------------- Global Page State --------------------
+                namespace GlobalState {
+                    static VPage* currentPage = nullptr;
+
+                    void setCurrentPage(VPage* page) {
+                        currentPage = page;
                     }
 
-                    static void go(const std::string& path, bool push = true) {
-                        auto it = routes().find(path);
-                        if (it != routes().end()) {
-                            currentPath() = path;
-                            GlobalState::setCurrentPage(&(*(it->second)));
-                            it->second->render(); 
+                    VPage* getCurrentPage() {
+                        return currentPage;
+                    }
+                }
 
-                            if (push) {
-                                EM_ASM({
-                                    history.pushState({}, "", UTF8ToString($0));
-                                }, path.c_str());
-                            }
-                        } else {
-                            get404()->rebuild();
-                        }
+                // -------------------- Callback Registry --------------------
+                std::unordered_map<std::string, std::function<void()>> CallbackRegistry::callbacks;
+                int CallbackRegistry::nextId = 0;
+
+                std::string CallbackRegistry::registerCallback(std::function<void()> callback) {
+                    std::string id = "callback_" + std::to_string(nextId++);
+                    callbacks[id] = callback;
+                    return id;
+                }
+
+                void CallbackRegistry::invokeCallback(const std::string& id) {
+                    auto it = callbacks.find(id);
+                    if (it != callbacks.end()) {
+                        it->second();
                     }
+                }
 
-                    // Get the current path
-                    static std::string getCurrentPath() {
-                        return currentPath();
+                // -------------------- VNode --------------------
+                VNode VNode::prerendered(const char* html) {
+                    VNode node;
+                    node.markup = html;
+                    return node;
+                }
+
+                VNode& VNode::setText(const std::string& newText) {
+                    text = newText;
+                    return *this;
+                }
+
+                VNode& VNode::setAttr(const std::string& key, const std::string& value) {
+                    if(key == "id" || type == VNodeType::CANVAS) {
+                        canvasid = value;
                     }
+                    attrs[key] = value;
+                    return *this;
+                }
 
-                private:
-                    // Route map
-                    static std::unordered_map<std::string, Handler>& routes() {
-                        static std::unordered_map<std::string, Handler> r;
-                        return r;
+                VNode& VNode::addChild(const VNode& child) {
+                    children.push_back(child);
+                    return *this;
+                }
+
+                VNode& VNode::onClick(std::function<void()> handler) {
+                    onclick = handler;
+                    return *this;
+                }
+
+                // -------------------- VPage --------------------
+                VPage& VPage::setTitle(const std::string& newTitle) {
+                    title = newTitle;
+                    return *this;
+                }
+
+                VPage& VPage::addStyle(const std::string& newstylesheet) {
+                    stylesheet = newstylesheet;
+                    return *this;
+                }
+
+                VPage& VPage::addChild(const VNode& child) {
+                    if (open == SIZE_MAX) {
+                        children.push_back(child);
+                        html.emplace_back();
+                        return *this;
                     }
+                    children.insert(children.begin() + next, child);
+                    html.insert(html.begin() + next, std::string());
+                    next++;
+                    sections[open]++;
+                    return *this;
+                }
 
-                    // Current path
-                    static std::string& currentPath() {
-                        static std::string p;
-                        return p;
+                bool VPage::section(size_t index, uint64_t reads) {
+                    bool added = index >= sections.size();
+                    if (added) {
+                        sections.resize(index + 1, 0);
+                    }
+                    size_t begin = next;
+                    if (!added && changed != ~0ull && reads != ~0ull && (reads & changed) == 0) {
+                        // kept as it is; the next section starts after it
+                        open = SIZE_MAX;
+                        next = begin + sections[index];
+                        return false;
+                    }
+                    children.erase(children.begin() + begin, children.begin() + begin + sections[index]);
+                    html.erase(html.begin() + begin, html.begin() + begin + sections[index]);
+                    sections[index] = 0;
+                    open = index;
+                    return true;
+                }
+
+                VPage& VPage::clearChildren() {
+                    children.clear();
+                    html.clear();
+                    sections.clear();
+                    onMount_list.clear();
+                    return *this;
+                }
+
+                void VPage::rebuild(uint64_t state) {
+                    if (!builder) return;
+                    if (state == ~0ull) {
+                        clearChildren();
+                    } else {
+                        onMount_list.clear();
                     }
+                    changed = state;
+                    open = SIZE_MAX;
+                    next = 0;
+                    builder(*this);
+                    changed = ~0ull;
+                    open = SIZE_MAX;
+                }
 
-                    // 404 page
-                    static Handler get404() {
-                        static Handler notfound;
-                        std::string notfound_path = "/notfound";
-                        auto it = routes().find(notfound_path);
-                        if (it != routes().end() && it->second) {
-                            notfound = [it]() {
-                                
-                                return it->second;
-                            }();
-                        } else {
-                            notfound = []() {
-                                auto page = std::make_shared<VPage>();
-                                page->setTitle("Page Not Found");
-                                page->addChild(VNode("p", "Page not found"));
-                                return page;
-                            }();
+                void VPage::render(uint64_t state) {
+                    rebuild(state);
+                    renderPage(*this);
+
+                }
+
+                void VPage::onMount(std::function<void()> fn) {
+                    onMount_list.push_back(fn);
+                }
+
+                void VPage::onAnimatefps(std::function<void()> fn) {
+                    reqanimate = true;
+                    onanimate = fn;
+                }
+
+                void VPage::addevent(std::string event, std::function<void()> fn) {
+                    page_callbacks[event] = fn;
+                }
+
+                // -------------------- Canvas2D --------------------
+                void Canvas2D::clear() {
+                    EM_ASM({
+                        if (document.getElementById($0)) {
+                            const ctx = document.getElementById(UTF8ToString($0)).getContext("2d");
+                            ctx.clearRect(0, 0, ctx.canvas.width, ctx.canvas.height);
                         }
-                        
-                        return notfound;
+        
+                    }, id.c_str());
+                }
+
+                void Canvas2D::setFill(const std::string& color) {
+                    EM_ASM({
+                        const ctx = document.getElementById(UTF8ToString($0))?.getContext("2d");
+                        if (!ctx) return;
+                        ctx.fillStyle = UTF8ToString($1);
+                    }, id.c_str(), color.c_str());
+                }
+
+                void Canvas2D::setStroke(const std::string& color) {
+                    EM_ASM({
+                        const ctx = document.getElementById(UTF8ToString($0))?.getContext("2d");
+                        if (!ctx) return;
+                        ctx.strokeStyle = UTF8ToString($1);
+                    }, id.c_str(), color.c_str());
+                }
+
+                void Canvas2D::lineWidth(size_t w) {
+                    EM_ASM({
+                        const ctx = document.getElementById(UTF8ToString($0))?.getContext("2d");
+                        if (!ctx) return;
+                        ctx.lineWidth = $1;
+                    }, id.c_str(), w);
+                }
+
+                void Canvas2D::alpha(double a) {
+                    EM_ASM({
+                        const ctx = document.getElementById(UTF8ToString($0))?.getContext("2d");
+                        if (!ctx) return;
+                        ctx.globalAlpha = $1;
+                    }, id.c_str(), a);
+                }
+
+                void Canvas2D::rect(size_t x, size_t y, size_t w, size_t h) {
+                    EM_ASM({
+                        const ctx = document.getElementById(UTF8ToString($0))?.getContext("2d");
+                        if (!ctx) return;
+                        ctx.fillRect($1, $2, $3, $4);
+                    }, id.c_str(), x, y, w, h);
+                }
+
+                void Canvas2D::strokeRect(size_t x, size_t y, size_t w, size_t h) {
+                    EM_ASM({
+                        const ctx = document.getElementById(UTF8ToString($0))?.getContext("2d");
+                        if (!ctx) return;
+                        ctx.strokeRect($1, $2, $3, $4);
+                    }, id.c_str(), x, y, w, h);
+                }
+
+                void Canvas2D::line(size_t x1, size_t y1, size_t x2, size_t y2) {
+                    EM_ASM({
+                        const ctx = document.getElementById(UTF8ToString($0))?.getContext("2d");
+                        if (!ctx) return;
+                        ctx.beginPath();
+                        ctx.moveTo($1, $2);
+                        ctx.lineTo($3, $4);
+                        ctx.stroke();
+                    }, id.c_str(), x1, y1, x2, y2);
+                }
+
+                void Canvas2D::circle(size_t x, size_t y, size_t r) {
+                    EM_ASM({
+                        const ctx = document.getElementById(UTF8ToString($0))?.getContext("2d");
+                        if (!ctx) return;
+                        ctx.beginPath();
+                        ctx.arc($1, $2, $3, 0, Math.PI * 2);
+                        ctx.fill();
+                    }, id.c_str(), x, y, r);
+                }
+
+                void Canvas2D::strokeCircle(size_t x, size_t y, size_t r) {
+                    EM_ASM({
+                        const ctx = document.getElementById(UTF8ToString($0))?.getContext("2d");
+                        if (!ctx) return;
+                        ctx.beginPath();
+                        ctx.arc($1, $2, $3, 0, Math.PI * 2);
+                        ctx.stroke();
+                    }, id.c_str(), x, y, r);
+                }
+
+                void Canvas2D::font(const std::string& f) {
+                    EM_ASM({
+                        const ctx = document.getElementById(UTF8ToString($0))?.getContext("2d");
+                        if (!ctx) return;
+                        ctx.font = UTF8ToString($1);
+                    }, id.c_str(), f.c_str());
+                }
+
+                void Canvas2D::text(const std::string& t, size_t x, size_t y) {
+                    EM_ASM({
+                        const ctx = document.getElementById(UTF8ToString($0))?.getContext("2d");
+                        if (!ctx) return;
+                        ctx.fillText(UTF8ToString($1), $2, $3);
+                    }, id.c_str(), t.c_str(), x, y);
+                }
+
+                void Canvas2D::move(size_t x, size_t y) {
+                    EM_ASM({
+                        const ctx = document.getElementById(UTF8ToString($0))?.getContext("2d");
+                        if (!ctx) return;
+                        ctx.translate($1, $2);
+                    }, id.c_str(), x, y);
+                }
+
+                void Canvas2D::rotate(double r) {
+                    EM_ASM({
+                        const ctx = document.getElementById(UTF8ToString($0))?.getContext("2d");
+                        if (!ctx) return;
+                        ctx.rotate($1);
+                    }, id.c_str(), r);
+                }
+
+                void Canvas2D::scale(double x, double y) {
+                    EM_ASM({
+                        const ctx = document.getElementById(UTF8ToString($0))?.getContext("2d");
+                        if (!ctx) return;
+                        ctx.scale($1, $2);
+                    }, id.c_str(), x, y);
+                }
+
+                // -------------------- Platform --------------------
+                int Platform::height() {
+                    return EM_ASM_INT({
+                        return window.innerHeight || document.documentElement.clientHeight || document.body.clientHeight;
+                    });
+                }
+
+                int Platform::width() {
+                    return EM_ASM_INT({
+                        return window.innerWidth || document.documentElement.clientWidth || document.body.clientWidth;
+                    });
+                }
+
+                // -------------------- Router --------------------
+                void Router::add(const std::string& path, Handler handler) {
+                    routes()[path] = handler;
+                }
+
+                void Router::navigate(const std::string& path) {
+                    auto it = routes().find(path);
+                    if (it != routes().end() && it->second) {
+                        currentPath() = path;
+                        it->second->render();
+                    } else {
+                        get404()->render();
                     }
-                };
+                }
+
+                void Router::go(const std::string& path, bool push) {
+                    auto it = routes().find(path);
+                    if (it != routes().end()) {
+                        currentPath() = path;
+                        GlobalState::setCurrentPage(&(*(it->second)));
+                        it->second->render(); 
+
+                        if (push) {
+                            EM_ASM({
+                                history.pushState({}, "", UTF8ToString($0));
+                            }, path.c_str());
+                        }
+                    } else {
+                        get404()->rebuild();
+                    }
+                }
+
+                std::string Router::getCurrentPath() {
+                    return currentPath();
+                }
+
+                std::unordered_map<std::string, Router::Handler>& Router::routes() {
+                    static std::unordered_map<std::string, Handler> r;
+                    return r;
+                }
+
+                std::string& Router::currentPath() {
+                    static std::string p;
+                    return p;
+                }
+
+                Router::Handler Router::get404() {
+                    static Handler notfound;
+                    std::string notfound_path = "/notfound";
+                    auto it = routes().find(notfound_path);
+                    if (it != routes().end() && it->second) {
+                        notfound = [it]() {
+            
+                            return it->second;
+                        }();
+                    } else {
+                        notfound = []() {
+                            auto page = std::make_shared<VPage>();
+                            page->setTitle("Page Not Found");
+                            page->addChild(VNode("p", "Page not found"));
+                            return page;
+                        }();
+                    }
+    
+                    return notfound;
+                }
 
                 // -------------------- JavaScript Interop --------------------
                 extern "C" {
@@ -681,7 +882,7 @@ void Core::generateFiles(const vector<string>& targets, const string& pname) {
                             }, key, val);
                         }
                     }
-                    
+
                     EMSCRIPTEN_KEEPALIVE
                     char* allocateString(const char* str) {
                         size_t len = strlen(str) + 1;
@@ -689,7 +890,7 @@ void Core::generateFiles(const vector<string>& targets, const string& pname) {
                         strcpy(buffer, str);
                         return buffer;
                     }
-                    
+
                     EMSCRIPTEN_KEEPALIVE
                     void freeString(char* str) {
                         free(str);
@@ -711,7 +912,7 @@ void Core::generateFiles(const vector<string>& targets, const string& pname) {
                     }
 
                     EMSCRIPTEN_KEEPALIVE
-                    void js_reqfps() { 
+                    void js_reqfps() {
                         EM_ASM({
                             function rafLoop() {
                                 Module._animatefps();
@@ -741,7 +942,8 @@ void Core::generateFiles(const vector<string>& targets, const string& pname) {
                 }
 
                 // -------------------- Render VNode to HTML --------------------
-                inline std::string renderToHTML(const VNode& node) {
+                std::string renderToHTML(const VNode& node) {
+                    if (node.markup) return node.markup;
                     std::ostringstream oss;
                     if (node.type == VNodeType::CANVAS) {
                         oss << "<canvas"
@@ -771,14 +973,16 @@ void Core::generateFiles(const vector<string>& targets, const string& pname) {
 
                     oss << ">";
                     if(!node.text.empty()) oss << node.text;
-                    for(const auto& child : node.children)
-                        oss << renderToHTML(child);
+                    for(const auto& child : node.children) {
+                        if (child.markup) oss << child.markup;
+                        else oss << renderToHTML(child);
+                    }
                     oss << "</" << node.tag << ">";
                     return oss.str();
                 }
 
                 // -------------------- Bind onclick --------------------
-                inline void bindOnClick(VNode& node) {
+                void bindOnClick(VNode& node) {
                     if(node.onclick) {
                         node.callback_id = CallbackRegistry::registerCallback(node.onclick);
                     }
@@ -787,19 +991,25 @@ void Core::generateFiles(const vector<string>& targets, const string& pname) {
                 }
 
                 // -------------------- Render Page --------------------
-                inline void renderPage(VPage& page) {
+                void renderPage(VPage& page) {
                     // Set as current page for callbacks to access
                     GlobalState::setCurrentPage(&page);
-                    
+    
                     std::ostringstream html;
                     std::unordered_map<std::string, std::string> canvas_list;
-                    for(auto& node : page.children) {
-                        bindOnClick(node);
+                    page.html.resize(page.children.size());
+                    for(size_t i = 0; i < page.children.size(); i++) {
+                        VNode& node = page.children[i];
+                        // sections the last rebuild kept are bound and rendered already
+                        if (page.html[i].empty()) {
+                            bindOnClick(node);
+                            page.html[i] = renderToHTML(node);
+                        }
                         if (node.type == VNodeType::CANVAS) {
-                            canvas_list[node.canvasid] = renderToHTML(node);
+                            canvas_list[node.canvasid] = page.html[i];
                             continue;
                         }
-                        html << renderToHTML(node);
+                        html << page.html[i];
                     }
 
                     js_insertHTML(html.str().c_str());
@@ -841,43 +1051,236 @@ void Core::generateFiles(const vector<string>& targets, const string& pname) {
 }
 
 
-void Core::builder() {
-    ifstream sourcefile("index.ink");
-    stringstream buffer;
-    char temp;
-    while (sourcefile.get(temp))
-    {
-    buffer << temp; 
-    } 
-    buffer << ' '; // EOF marker
-    string sourcecode = buffer.str();
-    
-    Lexer lexer(sourcecode);
-    vector<Token *> tokens = lexer.tokenize();
-    Parser parser(tokens);
-    AST_NODE * root = parser.parse();
+static const string COMPILE_FLAGS = "-Iweb -Iweb/gen -w";
+static const string LINK_FLAGS =
+    "-sEXPORTED_FUNCTIONS=\"['_main','_invokeVNodeCallback','_js_insertHTML','_js_setTitle','_malloc','_free', '_handleRoute', '_animatefps', '_handleEvent', '_animatefps', '_handleEvent']\" "
+    "-sEXPORTED_RUNTIME_METHODS=\"['ccall','cwrap','stringToUTF8','lengthBytesUTF8']\" "
+    "-sALLOW_MEMORY_GROWTH=1 -sASSERTIONS=1 -w -sDEFAULT_LIBRARY_FUNCS_TO_INCLUDE='$allocateUTF8'";
+
+static SourceHash hashFile(const string& path) {
+    SourceFile file;
+    return file.open(path) ? hashSource(file.text()) : SourceHash{};
+}
+
+// Which em++ a build runs, so an upgraded compiler misses every entry: the
+// first one on PATH and when it was written. Asking em++ for its version would
+// cost more than a cached build.
+static SourceHash compilerStamp() {
+#ifdef _WIN32
+    const char separator = ';';
+    const char* names[] = {"em++.bat", "em++.exe"};
+#else
+    const char separator = ':';
+    const char* names[] = {"em++"};
+#endif
+    const char* path = getenv("PATH");
+    stringstream dirs(path ? path : "");
+    string dir;
+    while (getline(dirs, dir, separator)) {
+        for (const char* name : names) {
+            error_code error;
+            fs::path compiler = fs::path(dir) / name;
+            auto written = fs::last_write_time(compiler, error);
+            if (!error) {
+                string stamp = compiler.string() + "@" + to_string(written.time_since_epoch().count());
+                return hashSource(stamp);
+            }
+        }
+    }
+    return SourceHash{};
+}
+
+// The runtime is the same for every project a given helios creates, so its
+// builds are kept per user rather than per project. `helios clean` leaves them
+// be unless given --runtime.
+static string runtimeCacheDirectory() {
+#ifdef _WIN32
+    const char* home = getenv("USERPROFILE");
+#else
+    const char* home = getenv("HOME");
+#endif
+    return home ? (fs::path(home) / ".helios" / "cache" / "runtime").string() : ".helios/cache/runtime";
+}
+
+// Builds web/vdom.cpp into a library and web/vdom.hpp into a precompiled
+// header, unless this compiler has already built the same runtime text.
+// `library` is left empty for a project made before the runtime was split, whose
+// vdom.hpp still defines everything; `pch` is left empty if the header
+// wouldn't precompile, and units then parse it themselves.
+static bool buildRuntime(SourceHash compiler, string& library, string& pch) {
+    if (!fs::exists("web/vdom.cpp")) {
+        return true;
+    }
+    static const ObjectCache cache(runtimeCacheDirectory());
+    SourceHash sources = combineHashes(hashFile("web/vdom.hpp"), hashFile("web/vdom.cpp"));
+    SourceHash key = combineHashes(combineHashes(compiler, hashSource(COMPILE_FLAGS)), sources);
+    string archive = cache.objectFor(key, ".a");
+    string header = cache.objectFor(key, ".pch");
+
+    future<int> archiving, precompiling;
+    error_code error;
+    // another project may be building the same runtime right now; each build
+    // works under temporaries of its own and the first to finish stores it
+    if (!cache.hasObject(key, ".a")) {
+        string built = cache.temporaryFor(key, ".a");
+        string object = cache.temporaryFor(key);
+        fs::create_directories(fs::path(built).parent_path(), error);
+        string cmd = "em++ -c web/vdom.cpp -o \"" + object + "\" " + COMPILE_FLAGS +
+                     " && emar rcs \"" + built + "\" \"" + object + "\"";
+        cout << "[Helios] Compiling the runtime library\n";
+        archiving = ThreadPool::shared().submit([cmd, object, built, key] {
+            int status = system(cmd.c_str());
+            error_code error;
+            fs::remove(object, error);
+            if (status != 0) {
+                fs::remove(built, error);
+            } else if (!cache.storeObject(key, built, ".a")) {
+                status = -1;
+            }
+            return status;
+        });
+    }
+    if (!cache.hasObject(key, ".pch")) {
+        string built = cache.temporaryFor(key, ".pch");
+        fs::create_directories(fs::path(built).parent_path(), error);
+        string cmd = "em++ -x c++-header web/vdom.hpp -o \"" + built + "\" " + COMPILE_FLAGS;
+        precompiling = ThreadPool::shared().submit([cmd, built, key] {
+            int status = system(cmd.c_str());
+            if (status != 0) {
+                error_code error;
+                fs::remove(built, error);
+            } else if (!cache.storeObject(key, built, ".pch")) {
+                status = -1;
+            }
+            return status;
+        });
+    }
+    if (archiving.valid() && archiving.get() != 0) {
+        cerr << "[Helios] The runtime failed to compile\n";
+        return false;
+    }
+    library = archive;
+    if (precompiling.valid() && precompiling.get() != 0) {
+        cerr << "[Helios] Could not precompile vdom.hpp; units will parse it themselves\n";
+        return true;
+    }
+    pch = header;
+    return true;
+}
+
+// Compiles the generated units into web/main.js, taking every object and the
+// linked app itself from `cache` when it has them. The compiles that do run go
+// on the shared pool, as many at a time as it has workers.
+static bool compileUnits(const vector<string>& units, const ObjectCache& cache) {
+    SourceHash compiler = compilerStamp();
+    string library, pch;
+    if (!buildRuntime(compiler, library, pch)) {
+        return false;
+    }
+    SourceHash headers = combineHashes(hashFile("web/gen/app.hpp"), hashFile("web/vdom.hpp"));
+    SourceHash common = combineHashes(combineHashes(compiler, hashSource(COMPILE_FLAGS)), headers);
+    // the library's name is its key, so it stands for the runtime in the link's
+    SourceHash program = combineHashes(combineHashes(compiler, hashSource(LINK_FLAGS)), hashSource(library));
+    vector<string> objects;
+    vector<future<int>> jobs;
+    for (const string& unit : units) {
+        SourceHash key = combineHashes(common, hashFile(unit));
+        program = combineHashes(program, key);
+        objects.push_back(cache.objectFor(key));
+        if (cache.hasObject(key)) {
+            continue;
+        }
+        string built = cache.temporaryFor(key);
+        error_code error;
+        fs::create_directories(fs::path(built).parent_path(), error);
+        string cmd = "em++ -c " + unit + " -o " + built + " " + COMPILE_FLAGS;
+        if (!pch.empty()) {
+            // the header's key already vouches for it; clang's own check
+            // would compare timestamps with whichever project built it
+            cmd += " -include-pch \"" + pch + "\" -Xclang -fno-validate-pch";
+        }
+        jobs.push_back(ThreadPool::shared().submit([cmd, built, key, &cache] {
+            int status = system(cmd.c_str());
+            if (status != 0) {
+                error_code error;
+                fs::remove(built, error);
+            } else if (!cache.storeObject(key, built)) {
+                status = -1;
+            }
+            return status;
+        }));
+    }
+    cout << "[Helios] Compiling " << jobs.size() << " of " << units.size() << " units\n";
+    size_t failed = 0;
+    for (future<int>& job : jobs) {
+        if (job.get() != 0) {
+            failed++;
+        }
+    }
+    if (failed) {
+        cerr << "[Helios] " << failed << (failed == 1 ? " unit" : " units") << " failed to compile\n";
+        return false;
+    }
+
+    if (cache.restoreLink(program, "web")) {
+        cout << "[Helios] Linked app taken from the build cache\n";
+        return true;
+    }
+    string cmd = "em++";
+    for (const string& object : objects) {
+        cmd += " " + object;
+    }
+    if (!library.empty()) {
+        cmd += " \"" + library + "\"";
+    }
+    cmd += " -o web/main.js " + LINK_FLAGS;
+    if (system(cmd.c_str()) != 0) {
+        return false;
+    }
+    vector<string> linked = {"web/main.js"};
+    if (fs::exists("web/main.wasm")) {
+        linked.push_back("web/main.wasm");
+    }
+    cache.storeLink(program, linked);
+    return true;
+}
+
+bool Core::builder() {
+    // AST nodes and strings for this build; all of it is released when builder() returns
+    CompilationSession session;
+    ModuleGraph modules(sources, &astcache);
+    if (!modules.load("index.ink")) {
+        cerr << "[Helios] Could not read index.ink\n";
+        return false;
+    }
+    modules.analyze();
+
+    // parse errors don't stop analysis, so one build reports everything at once
+    modules.printDiagnostics(cerr);
+    if (modules.hasErrors()) {
+        size_t errors = modules.errorCount();
+        cerr << "[Helios] Build failed with " << errors << (errors == 1 ? " error\n" : " errors\n");
+        return false;
+    }
+    Ast merged = modules.merge(session);
+    // constants folded and dead code dropped before codegen sees the program
+    Ast ast = Optimizer(merged).run(&session.arena);
 
     // std::cout << "\n==== AST Visualization ====\n";
-    // printAST(root);
+    // printAST(ast);
     // std::cout << "\n==== AST Visualization ENDed ====\n";
-    // cout << "Root Node has " << root->SUB_STATEMENTS.size() << " sub-statements." << endl;
-    // cout << "[i] Finished Parsing [i]" << endl;
+    // cout << "Root Node has " << ast.root().subCount() << " sub-statements." << endl;
 
-    SemanticAnalyzer analyzer;
-    analyzer.analyze(root);
-    //cout << "[i] Finished Semantic Analysing [i]" << endl;
     WebEngine gen;
-    if (!gen.gen(root)) {
+    if (!gen.gen(ast)) {
         cerr << "write failed\n";
         exit(1);
     }
     //cout << "[Helios] Compiled Projects Successfully! [Helios]\n";
+    cout << "[Helios] Build used " << (session.bytesUsed() + modules.bytesUsed() + 1023) / 1024 << " KiB of arena memory\n";
 
-    string cmd = "em++ web/generated.cpp -o web/main.js " 
-        "-sEXPORTED_FUNCTIONS=\"['_main','_invokeVNodeCallback','_js_insertHTML','_js_setTitle','_malloc','_free', '_handleRoute', '_animatefps', '_handleEvent', '_animatefps', '_handleEvent']\" "
-        "-sEXPORTED_RUNTIME_METHODS=\"['ccall','cwrap','stringToUTF8','lengthBytesUTF8']\" "
-        "-sALLOW_MEMORY_GROWTH=1 -sASSERTIONS=1 -w -sDEFAULT_LIBRARY_FUNCS_TO_INCLUDE='$allocateUTF8'";
-    system(cmd.c_str());
+    // one unit per page plus app.cpp, each compiled only if the cache hasn't seen its text
+    return compileUnits(gen.units, objectcache);
 }
 
 
@@ -903,7 +1306,10 @@ void Core::devTarget(const vector<string>& targets, const string& pname) {
                     ".ink",
                     [&]() {
                         std::cout << "Hot Reloading (Not done!) -->";
-                        builder();
+                        if (!builder()) {
+                            // keep serving the last good build until the errors are fixed
+                            return;
+                        }
                         std::cout << "Done -->\n";
                         websocket_manager::broadcast("reload");  // send "reload" to all connected WebSocket clients
                     }
@@ -975,7 +1381,9 @@ void Core::runTarget(const vector<string>& targets, const string& pname) {
             if(targets.size() > 1) {
                 string flag = targets.at(1);
                 if(flag == "-b") {
-                    builder();
+                    if (!builder()) {
+                        exit(1);
+                    }
                     cout << "[PRODUCTION][web] Compiling for production... [PRODUCTION]\n";
                 } else {
                     if (flag != "web" && flag != "android" && flag != "ios") {
@@ -1029,7 +1437,9 @@ void Core::buildTarget(const vector<string>& targets, const string& pname) {
 
     for (auto& target : targets) {
         if (target == "web") {
-            builder();
+            if (!builder()) {
+                exit(1);
+            }
             cout << "[web] Compiled Web Engine..... \n";
         } else if (target == "android") {
             cout << "[android] Compiling MainActivity...\n";
@@ -1045,11 +1455,20 @@ void Core::buildTarget(const vector<string>& targets, const string& pname) {
 
 
 // --------------------- Clean ---------------------
-void Core::cleanProject(const string& pname) {
+void Core::cleanProject(const string& pname, bool runtime) {
     string root = getProjectRoot(pname);
-    if (fs::exists("web/generated.cpp")) {
+    if (fs::exists("web/generated.cpp") || fs::exists("web/gen")) {
         fs::remove("web/generated.cpp");
+        fs::remove_all("web/gen");
         cout << "[helios] cleaned project folder: " << root << endl;
     }
+    if (fs::exists(".helios/cache")) {
+        fs::remove_all(".helios/cache");
+    }
+    if (runtime) {
+        error_code error;
+        fs::remove_all(runtimeCacheDirectory(), error);
+        cout << "[helios] cleaned runtime builds: " << runtimeCacheDirectory() << endl;
+    }
 }
 
@@ -0,0 +1,39 @@
+#include "diagnostics.hpp"
+
+void Diagnostics::error(const std::string &kind, const std::string &message, int lineno, int charno, int width)
+{
+    diagnostics.push_back({SEVERITY_ERROR, kind, message, lineno, charno, width});
+    errors++;
+}
+
+void Diagnostics::warning(const std::string &message, int lineno, int charno, int width)
+{
+    diagnostics.push_back({SEVERITY_WARNING, "Warning", message, lineno, charno, width});
+}
+
+void Diagnostics::print(std::ostream &out, const SourceMap &source, const std::string &file) const
+{
+    for (const Diagnostic &diagnostic : diagnostics)
+    {
+        out << "\n" << diagnostic.kind << ": " << diagnostic.message;
+        if (diagnostic.lineno <= 0)
+        {
+            out << (file.empty() ? "" : " (" + file + ")") << "\n";
+            continue;
+        }
+        out << " at line " << diagnostic.lineno << ", column " << diagnostic.charno;
+        if (!file.empty())
+        {
+            out << " of " << file;
+        }
+        out << "\n";
+        std::string number = std::to_string(diagnostic.lineno);
+        out << "  " << number << " | " << source.line(diagnostic.lineno) << "\n";
+        out << "    " << std::string(diagnostic.charno + number.length(), ' ')
+            << std::string(diagnostic.width > 0 ? diagnostic.width : 1, '^') << "\n";
+    }
+    if (!diagnostics.empty())
+    {
+        out << "\n";
+    }
+}
@@ -1,7 +1,9 @@
 #include "lexer.hpp"
+#include "scan.hpp"
+#include "threadpool.hpp"
+#include <memory>
 #include <iostream>
 #include <string>
-#include <sstream>
 #include <cctype>
 #include <vector>
 #include <algorithm>
@@ -69,6 +71,8 @@ std::string typetostring(enum Tokentype TYPE)
         return "COMMA";
     case TOKEN_HASH:
         return "HASH";
+    case TOKEN_ERROR:
+        return "ERROR";
     case TOKEN_EOF:
         return "END_OF_FILE";
     case TOKEN_NEWLINE:
@@ -88,23 +92,149 @@ std::string typetostring(enum Tokentype TYPE)
     }
 }
 
-Lexer::Lexer(std::string sourceCode)
-    : keywords({
-        "if", "else", "while", "for", "return", "class", 
-        "import", "pass", "break", "continue", "def","type",
-        "true", "false","print", "page", "app", "view", "text", 
-        "img", "canvas" , "input", "state", "go", "stylesheet", 
-        "to_int", "to_str", "to_float", "draw", "sin", "sqrt", 
-        "cos", "tan", "pow", "Platform"
-      })
+SourceMap::SourceMap(std::string_view text)
+    : text(text)
+{
+    lineStarts.reserve(std::count(text.begin(), text.end(), '\n') + 1);
+    lineStarts.push_back(0);
+    for (size_t i = text.find('\n'); i != std::string_view::npos; i = text.find('\n', i + 1))
+    {
+        lineStarts.push_back(i + 1);
+    }
+}
+
+std::string_view SourceMap::line(int lineno) const
+{
+    if (lineno < 1 || lineno > (int)lineStarts.size())
+    {
+        return std::string_view();
+    }
+    size_t start = lineStarts[lineno - 1];
+    size_t end = text.find('\n', start);
+    if (end == std::string_view::npos)
+    {
+        end = text.size();
+    }
+    if (end > start && text[end - 1] == '\r')
+    {
+        end--;
+    }
+    return text.substr(start, end - start);
+}
+
+TokenStream::TokenStream(std::string_view source)
+    : source(source)
+{
+}
+
+void TokenStream::reserve(size_t count)
+{
+    types.reserve(count);
+    keywords.reserve(count);
+    symbols.reserve(count);
+    offsets.reserve(count);
+    lengths.reserve(count);
+    lines.reserve(count);
+    columns.reserve(count);
+}
+
+void TokenStream::push(enum Tokentype type, uint32_t offset, uint32_t length, int lineno, int charno, Keyword keyword,
+                       Symbol symbol)
+{
+    types.push_back(type);
+    keywords.push_back(keyword);
+    symbols.push_back(symbol);
+    offsets.push_back(offset);
+    lengths.push_back(length);
+    lines.push_back(lineno);
+    columns.push_back(charno);
+}
+
+void TokenStream::pushLiteral(std::string_view value, uint32_t offset, int lineno, int charno)
+{
+    push(TOKEN_STRING, offset, literalStarts.size() | ESCAPED, lineno, charno);
+    literalStarts.push_back(literals.size());
+    literals.append(value);
+}
+
+void TokenStream::append(const TokenStream &other, size_t begin, size_t end, int offsetShift, int lineShift)
+{
+    types.insert(types.end(), other.types.begin() + begin, other.types.begin() + end);
+    keywords.insert(keywords.end(), other.keywords.begin() + begin, other.keywords.begin() + end);
+    symbols.insert(symbols.end(), other.symbols.begin() + begin, other.symbols.begin() + end);
+    columns.insert(columns.end(), other.columns.begin() + begin, other.columns.begin() + end);
+    for (size_t i = begin; i < end; i++)
+    {
+        offsets.push_back(other.offsets[i] + offsetShift);
+        lines.push_back(other.lines[i] + lineShift);
+        if (other.lengths[i] & ESCAPED)
+        {
+            lengths.push_back(literalStarts.size() | ESCAPED);
+            literalStarts.push_back(literals.size());
+            literals.append(other.value(i));
+        }
+        else
+        {
+            lengths.push_back(other.lengths[i]);
+        }
+    }
+}
+
+size_t TokenStream::lowerBound(uint32_t offset) const
+{
+    return std::lower_bound(offsets.begin(), offsets.end(), offset) - offsets.begin();
+}
+
+std::string_view TokenStream::value(size_t index) const
+{
+    uint32_t length = lengths[index];
+    if (length & ESCAPED)
+    {
+        uint32_t literal = length & ~ESCAPED;
+        uint32_t start = literalStarts[literal];
+        uint32_t end = (literal + 1 < literalStarts.size()) ? literalStarts[literal + 1] : literals.size();
+        return std::string_view(literals).substr(start, end - start);
+    }
+    if (types[index] == TOKEN_EOF)
+    {
+        return "EOF";
+    }
+    return source.substr(offsets[index], length);
+}
+
+Token TokenStream::at(size_t index) const
+{
+    if (index >= size())
+    {
+        int lineno = lines.empty() ? 1 : lines.back();
+        return Token{TOKEN_EOF, "", lineno, 0, KW_NONE, 0};
+    }
+    return Token{type(index), value(index), (int)lines[index], (int)columns[index], (Keyword)keywords[index], symbols[index]};
+}
+
+Lexer::Lexer(std::string_view sourceCode)
 {
     source = sourceCode;
+    sourcemap = SourceMap(source);
     cursor = 0;
-    size = sourceCode.size();
+    size = source.size();
     current = (size > 0) ? source.at(cursor) : '\0';
     linenum = 1;
     charnum = 1;
-    currentLine = std::stringstream();
+    ctrl = false;
+}
+
+// Lexes source[begin, end) as if it started at line 1; the caller shifts lines when stitching.
+Lexer::Lexer(std::string_view sourceCode, int begin, int end)
+{
+    source = sourceCode;
+    tokens = TokenStream(source);
+    tokens.reserve((end - begin) / 4 + 1);
+    cursor = begin;
+    size = end;
+    current = (cursor < size) ? source[cursor] : '\0';
+    linenum = 1;
+    charnum = 1;
     ctrl = false;
 }
 
@@ -113,11 +243,10 @@ char Lexer::advance()
 
     if (cursor < size)
     {
-        currentLine << current;
         char temp = current;
         cursor++;
         charnum++;
-        current = (cursor < size ) ? source.at(cursor) : '\0';
+        current = (cursor < size ) ? source[cursor] : '\0';
         return temp;
     }
     else
@@ -126,83 +255,68 @@ char Lexer::advance()
     }
 }
 
-void Lexer::checkAndSkip()
+void Lexer::skipTo(int position)
 {
-    while (current == ' ' || current == '\t' || current == '\r')
-    {   
-        advance();
-    }
+    // only valid for runs without '\n'; the column moves with the cursor
+    charnum += position - cursor;
+    cursor = position;
+    current = (cursor < size) ? source[cursor] : '\0';
 }
 
+void Lexer::checkAndSkip()
+{
+    skipTo(scanBlanks(source.data(), cursor, size));
+}
 
-Token * Lexer::tokenizeID_KEYWORD() {
-            std::stringstream buffer;
-            buffer << advance();
 
-            while (isalnum(current) || current == '_')
-            {
-                
-                buffer << advance();
+void Lexer::tokenizeID_KEYWORD() {
+            int start = cursor;
+            advance();
+            skipTo(scanIdentifier(source.data(), cursor, size));
+            std::string_view text = slice(start);
+            Keyword keyword = lookupKeyword(text);
+            if (keyword != KW_NONE) {
+                tokens.push(TOKEN_KEYWORD, start, cursor - start, linenum, charnum - (cursor - start), keyword);
+            } else {
+                tokens.push(TOKEN_ID, start, cursor - start, linenum, charnum - (cursor - start), KW_NONE, Symbols::intern(text));
             }
-            Token * newtoken = new Token();
-            newtoken->TYPE = (std::find(keywords.begin(), keywords.end(), buffer.str()) != keywords.end()) ? TOKEN_KEYWORD : TOKEN_ID;
-            newtoken->value = buffer.str();
-            newtoken->lineno = linenum;
-            newtoken->charno = charnum - buffer.str().length();
-            newtoken->sourceLine = currentLine.str();
-            return newtoken;
 }
 
 
 
-Token  * Lexer::tokenizeOP(enum Tokentype Type, char expected) {
-            std::stringstream buffer;
-            buffer << advance();
+void Lexer::tokenizeOP(enum Tokentype Type, char expected) {
+            int start = cursor;
+            advance();
             if (current == expected)
             {
-                buffer << advance();
+                advance();
             }
-            Token * newtoken = new Token();
-            newtoken->TYPE = Type;
-            newtoken->value = buffer.str();
-            newtoken->lineno = linenum;
-            newtoken->charno = charnum - buffer.str().length();
-            newtoken->sourceLine = currentLine.str();
-            return newtoken;
+            emit(Type, start, charnum - (cursor - start));
         }
 
-Token * Lexer::tokenizespecial(enum Tokentype TYPE)
+void Lexer::tokenizespecial(enum Tokentype TYPE)
 {
-    Token * newtoken = new Token();
-    newtoken->TYPE = TYPE;
-    newtoken->value = std::string(1, advance());
-    newtoken->lineno = linenum;
-    newtoken->charno = charnum;
-    newtoken->sourceLine = currentLine.str();
-    return newtoken;
+    int start = cursor;
+    advance();
+    emit(TYPE, start, charnum);
 }
 
-Token * Lexer::tokenizeINT()
+void Lexer::tokenizeINT()
 {
-    Token * newtoken = new Token();
-    newtoken->TYPE = TOKEN_INT;
-    std::stringstream buffer;
+    Tokentype type = TOKEN_INT;
+    int start = cursor;
     bool isfloat = false;
     while (isdigit(current) || (current == '.' && !isfloat))
     {
         if (current == '.' && !isfloat) {
-            newtoken->TYPE = TOKEN_FLOAT;
+            type = TOKEN_FLOAT;
             isfloat = true;
         }
-        buffer << advance();
+        advance();
     }
-    newtoken->value = buffer.str();
-    newtoken->lineno = linenum;
-    newtoken->charno = charnum - buffer.str().length();
-    newtoken->sourceLine = currentLine.str();
-    return newtoken;
+    emit(type, start, charnum - (cursor - start));
 }
-Token * Lexer::tokenizeSTR(enum Tokentype TYPE) 
+void Lexer::tokenizeSTR(enum Tokentype TYPE) 
 {
     // current should be the opening quote (either ' or ")
     char opening = current;
@@ -212,70 +326,158 @@ Token * Lexer::tokenizeSTR(enum Tokentype TYPE)
     // consume opening quote
     advance();
 
-    std::string value;
+    // the literal is a span of the source unless it contains escapes,
+    // in which case it is decoded once into a scratch buffer
+    int start = cursor;
+    bool escaped = false;
     bool closed = false;
+    unescaped.clear();
 
     while (current != '\0' && current != '\n') {
         if (current == '\\') {
+            if (!escaped) {
+                unescaped.assign(slice(start));
+                escaped = true;
+            }
             // escape sequence: consume backslash then interpret next char literally (or common escapes)
             advance();
             if (current == '\0' || current == '\n') break; // unterminated
             char esc = advance();
             switch (esc) {
-                case 'n': value += '\n'; break;
-                case 't': value += '\t'; break;
-                case 'r': value += '\r'; break;
-                case '\\': value += '\\'; break;
-                case '\'': value += '\''; break;
-                case '"': value += '"'; break;
-                default: value += esc; break;
+                case 'n': unescaped += '\n'; break;
+                case 't': unescaped += '\t'; break;
+                case 'r': unescaped += '\r'; break;
+                case '\\': unescaped += '\\'; break;
+                case '\'': unescaped += '\''; break;
+                case '"': unescaped += '"'; break;
+                default: unescaped += esc; break;
             }
             continue;
         }
 
         if (current == opening) {
+            if (escaped) {
+                tokens.pushLiteral(unescaped, start, start_lineno, start_charno);
+            } else {
+                tokens.push(TOKEN_STRING, start, cursor - start, start_lineno, start_charno);
+            }
             // consume closing quote and mark closed
             advance();
             closed = true;
             break;
         }
 
-        // normal character
-        value += advance();
+        // run of ordinary characters up to the next quote, escape or line end
+        int run = scanString(source.data(), cursor, size, opening);
+        if (escaped) {
+            unescaped.append(source.substr(cursor, run - cursor));
+        }
+        skipTo(run);
     }
 
     if (!closed) {
-        std::cerr << "\nParserError: UnTerminated String at line " << start_lineno
-                    << ", column " << start_charno << "\n";
-        std::cerr << "  " << start_lineno << " | " << currentLine.str() << "\n";
-        exit(1);
-    }
-
-    Token * newtoken = new Token();
-    newtoken->TYPE = TOKEN_STRING;
-    newtoken->value = value;
-    newtoken->lineno = start_lineno;
-    newtoken->charno = start_charno;
-    newtoken->sourceLine = currentLine.str();
-    newtoken->extra = std::string(1, opening);
-    return newtoken;
+        // the parser reports it; the token runs from the opening quote to the line end
+        tokens.push(TOKEN_ERROR, start - 1, cursor - (start - 1), start_lineno, start_charno);
+    }
+}
+// String literals never span lines, so any newline is safe, except one right
+// after '-', '!', '<' or '>' - those operators swallow the following character
+// and would skip the newline in the sequential lexer.
+bool isSafeLineBreak(std::string_view text, size_t newline)
+{
+    return newline == 0 || std::string_view("-!<>").find(text[newline - 1]) == std::string_view::npos;
+}
+
+// Start of the next chunk: the first safe line start at or after `from`.
+int Lexer::chunkBoundary(int from) const
+{
+    size_t newline = source.find('\n', from);
+    while (newline != std::string_view::npos && !isSafeLineBreak(source, newline))
+    {
+        newline = source.find('\n', newline + 1);
+    }
+    return (newline == std::string_view::npos || (int)newline + 1 >= size) ? size : newline + 1;
+}
+
+bool Lexer::tokenizeParallel()
+{
+    ThreadPool &pool = ThreadPool::shared();
+    int chunkBytes = std::max<int>(PARALLEL_CHUNK_BYTES, size / pool.size() + 1);
+    std::vector<int> bounds = {0};
+    while (bounds.back() < size)
+    {
+        bounds.push_back(chunkBoundary(bounds.back() + chunkBytes));
+    }
+    if (bounds.size() < 3)
+    {
+        return false;
+    }
+
+    std::vector<std::unique_ptr<Lexer>> chunks;
+    std::vector<std::future<bool>> done;
+    for (size_t i = 0; i + 1 < bounds.size(); i++)
+    {
+        Lexer *chunk = new Lexer(source, bounds[i], bounds[i + 1]);
+        chunks.emplace_back(chunk);
+        done.push_back(pool.submit([chunk] { return chunk->scan(); }));
+    }
+    std::vector<bool> sawEOF;
+    size_t count = 0;
+    for (size_t i = 0; i < chunks.size(); i++)
+    {
+        sawEOF.push_back(done[i].get());
+        count += chunks[i]->tokens.size();
+    }
+
+    tokens = TokenStream(source);
+    tokens.reserve(count + 1);
+    int lineOffset = 0;
+    for (size_t i = 0; i < chunks.size(); i++)
+    {
+        tokens.append(chunks[i]->tokens, 0, chunks[i]->tokens.size(), 0, lineOffset);
+        if (sawEOF[i])
+        {
+            return true;
+        }
+        lineOffset += chunks[i]->linenum - 1;
+    }
+    // lineOffset now counts the last chunk's lines too
+    tokens.push(TOKEN_EOF, size, 0, lineOffset + 1, chunks.back()->charnum);
+    return true;
+}
+
+TokenStream Lexer::tokenize()
+{
+    if (size >= PARALLEL_MIN_BYTES && !ThreadPool::onWorkerThread() && tokenizeParallel())
+    {
+        return std::move(tokens);
+    }
+    tokens = TokenStream(source);
+    tokens.reserve(size / 4 + 1);
+    if (!scan())
+    {
+        // ran off the end of the buffer instead of reading a '\0'
+        tokens.push(TOKEN_EOF, size, 0, linenum, charnum);
+    }
+    return std::move(tokens);
 }
-std::vector<Token *> Lexer::tokenize()
+
+// Main loop over [cursor, size). Returns true if it stopped on a '\0'.
+bool Lexer::scan()
 {
-    std::vector<Token *> tokens;
     bool noteof = true;
     while (cursor < size && noteof)
     {
         checkAndSkip();
         if(isalpha(current) || current == '_')
         {
-            tokens.push_back(tokenizeID_KEYWORD());
+            tokenizeID_KEYWORD();
             continue;
         }
 
         if (isdigit(current))
         {
-            tokens.push_back(tokenizeINT());
+            tokenizeINT();
             continue;
         }
         
@@ -284,43 +486,43 @@ std::vector<Token *> Lexer::tokenize()
             case '=':
                 {
                         if (peak(1) == '=') {
-                            tokens.push_back(tokenizeOP(TOKEN_EQOP, '='));
+                            tokenizeOP(TOKEN_EQOP, '=');
                             break;
                             continue;
                         } else {
-                            tokens.push_back(tokenizespecial(TOKEN_EQ));
+                            tokenizespecial(TOKEN_EQ);
                         
                         }
                         break;
                     } 
             
                 case '(':
-                {tokens.push_back(tokenizespecial(TOKEN_LPAREN));
+                {tokenizespecial(TOKEN_LPAREN);
                 break;}
 
                 case ')':
-                {tokens.push_back(tokenizespecial(TOKEN_RPAREN));
+                {tokenizespecial(TOKEN_RPAREN);
                 break;}
             case '.':
-                    {tokens.push_back(tokenizespecial(TOKEN_DOT));
+                    {tokenizespecial(TOKEN_DOT);
                     break;}
             case '"':
-                    {tokens.push_back(tokenizeSTR(TOKEN_QUOTE));
+                    {tokenizeSTR(TOKEN_QUOTE);
                     break;}
             case '\'':
-                    {tokens.push_back(tokenizeSTR(TOKEN_SINGLEQUOTE));
+                    {tokenizeSTR(TOKEN_SINGLEQUOTE);
                     break;}
             case '&':
-                    {tokens.push_back(tokenizespecial(TOKEN_ANDSYM));
+                    {tokenizespecial(TOKEN_ANDSYM);
                     break;}
             case '+':
                     {
                         if (peak(1) == '+') {
-                            tokens.push_back(tokenizeOP(TOKEN_INCREMENT, '+'));
+                            tokenizeOP(TOKEN_INCREMENT, '+');
                             break;
                             continue;
                         } else {
-                            tokens.push_back(tokenizespecial(TOKEN_PLUSOP));
+                            tokenizespecial(TOKEN_PLUSOP);
 
                         }
                         break;
@@ -328,38 +530,38 @@ std::vector<Token *> Lexer::tokenize()
             case '-':
                     {
                         if (peak(1) == '=') {
-                            tokens.push_back(tokenizeOP(TOKEN_DECREMENT, '-'));
+                            tokenizeOP(TOKEN_DECREMENT, '-');
                             break;
                             continue;
                         } else {
-                            tokens.push_back(tokenizespecial(TOKEN_MINUSOP));
+                            tokenizespecial(TOKEN_MINUSOP);
                             advance(); // consume '='
                         }
                         break;
                     }
             case '*':
-                    {tokens.push_back(tokenizespecial(TOKEN_MULOP));
+                    {tokenizespecial(TOKEN_MULOP);
                     break;}
             case '/':
-                    {tokens.push_back(tokenizespecial(TOKEN_DIVOP));
+                    {tokenizespecial(TOKEN_DIVOP);
                     break;}
             case '\\':
-                    {tokens.push_back(tokenizeSTR(TOKEN_BACKLASH));
+                    {tokenizeSTR(TOKEN_BACKLASH);
                     break;}
             case '#':
-                    {tokens.push_back(tokenizespecial(TOKEN_HASH));
+                    {tokenizespecial(TOKEN_HASH);
                     break;}
             case '@':
-                    {tokens.push_back(tokenizespecial(TOKEN_ATSYM)); 
+                    {tokenizespecial(TOKEN_ATSYM); 
                     break;}
             case '!':
                     {
                         if (peak(1) == '=') {
-                            tokens.push_back(tokenizeOP(TOKEN_NEQOP, '='));
+                            tokenizeOP(TOKEN_NEQOP, '=');
                             break;
                             continue;
                         } else {
-                            tokens.push_back(tokenizespecial(TOKEN_NOTOP));
+                            tokenizespecial(TOKEN_NOTOP);
                             advance(); // consume '='
                         }
                         break;
@@ -367,11 +569,11 @@ std::vector<Token *> Lexer::tokenize()
             case '>':
                     {
                         if (peak(1) == '=') {
-                            tokens.push_back(tokenizeOP(TOKEN_GTE, '='));
+                            tokenizeOP(TOKEN_GTE, '=');
                             break;
                             continue;
                         } else {
-                            tokens.push_back(tokenizespecial(TOKEN_GT));
+                            tokenizespecial(TOKEN_GT);
                             advance(); // consume '='
                         }
                         break;
@@ -379,79 +581,60 @@ std::vector<Token *> Lexer::tokenize()
             case '<':
                     {
                         if (peak(1) == '=') {
-                            tokens.push_back(tokenizeOP(TOKEN_LTE, '='));
+                            tokenizeOP(TOKEN_LTE, '=');
                             break;
                             continue;
                         } else {
-                            tokens.push_back(tokenizespecial(TOKEN_LT));
+                            tokenizespecial(TOKEN_LT);
                             advance(); // consume '='
                         }
                         break;
                     }
             case '{':
-                    {tokens.push_back(tokenizespecial(TOKEN_LBRACE));
+                    {tokenizespecial(TOKEN_LBRACE);
                     break;}
             case '}':
-                    {tokens.push_back(tokenizespecial(TOKEN_RBRACE));
+                    {tokenizespecial(TOKEN_RBRACE);
                     break;}
             case '[':
-                    {tokens.push_back(tokenizespecial(TOKEN_LBRACKET));
+                    {tokenizespecial(TOKEN_LBRACKET);
                     break;}
             case ']':
-                    {tokens.push_back(tokenizespecial(TOKEN_RBRACKET));
+                    {tokenizespecial(TOKEN_RBRACKET);
                     break;}
             case ',':
-                    {tokens.push_back(tokenizespecial(TOKEN_COMMA));
+                    {tokenizespecial(TOKEN_COMMA);
                     break;}
             case ':':
-                    {tokens.push_back(tokenizespecial(TOKEN_COLON));
+                    {tokenizespecial(TOKEN_COLON);
                     break;}
             case '\n':
                     {
-                        tokens.push_back(tokenizespecial(TOKEN_NEWLINE));
+                        tokenizespecial(TOKEN_NEWLINE);
                         linenum++;
                         charnum = 1;
-                        
-                        currentLine = std::stringstream();
-                        
                         break;
                     }
             case '\0':
                     {
-                        Token * newtoken = new Token();
-                        newtoken->TYPE = TOKEN_EOF;
-                        newtoken->value = "EOF";
-                        newtoken->lineno = linenum;
-                        newtoken->sourceLine = currentLine.str();
-                        newtoken->charno = charnum;
-                        tokens.push_back(newtoken);
+                        tokens.push(TOKEN_EOF, cursor, 0, linenum, charnum);
                         noteof = false;
                         break;}
             
             default:
                 {
-                currentLine << current;
-                charnum++;
-                std::cerr << "\nParserError: " << "Unknown character: "
-                << " at line " << linenum
-                << ", column " << charnum << "\n";
-
-                // show the entire line from the source
-                std::cerr << "  " << linenum << " | " << currentLine.str() << "\n";
-
-                // pointer to the error character
-                std::cerr << "    ";
-                for (int i = 1; i < charnum; ++i)
-                    std::cerr << " ";
-                std::cerr << " ^\n\n";
-                std::cout << "Unknown character: " << current << std::endl;
-                std::cout << "at line: " << linenum << " char: " << charnum << std::endl;
-                exit(1);
+                // unknown character, with the rest of its UTF-8 sequence; the parser reports it
+                int start = cursor;
+                advance();
+                while (((unsigned char)current & 0xC0) == 0x80) {
+                    advance();
+                }
+                emit(TOKEN_ERROR, start, charnum - (cursor - start));
             }
         }
         
     }
-    return tokens;
+    return !noteof;
 }
 char Lexer::peak(int offset)
 {
@@ -463,4 +646,104 @@ char Lexer::peak(int offset)
     {
         return '\0'; // Out of bounds
     }
-}
\ No newline at end of file
+}
+
+const TokenStream &IncrementalLexer::relexAll(std::string_view text)
+{
+    previous.assign(text);
+    Lexer lexer(previous);
+    tokens = lexer.tokenize();
+    primed = true;
+    relexed = previous.size();
+    return tokens;
+}
+
+const TokenStream &IncrementalLexer::update(std::string_view text)
+{
+    // a stream cut short by a '\0' has no tail to reuse
+    if (!primed || tokens.size() == 0 || tokens.offsets.back() != previous.size())
+    {
+        return relexAll(text);
+    }
+
+    size_t oldSize = previous.size();
+    size_t newSize = text.size();
+    size_t common = std::min(oldSize, newSize);
+    size_t prefix = std::mismatch(previous.begin(), previous.begin() + common, text.begin()).first - previous.begin();
+    if (prefix == oldSize && prefix == newSize)
+    {
+        relexed = 0;
+        return tokens;
+    }
+    size_t suffix = 0;
+    while (suffix < common - prefix && previous[oldSize - 1 - suffix] == text[newSize - 1 - suffix])
+    {
+        suffix++;
+    }
+    int shift = (int)newSize - (int)oldSize;
+
+    // restart at the first safe line start before the edit; that newline lies in
+    // the shared prefix, so it is safe in both texts
+    size_t start = prefix;
+    while (start > 0)
+    {
+        size_t newline = previous.rfind('\n', start - 1);
+        if (newline == std::string::npos)
+        {
+            start = 0;
+        }
+        else if (isSafeLineBreak(previous, newline))
+        {
+            start = newline + 1;
+            break;
+        }
+        else
+        {
+            start = newline;
+        }
+    }
+
+    // and stop after the first newline past the edit that is safe in both texts
+    size_t end = oldSize;
+    for (size_t newline = previous.find('\n', oldSize - suffix); newline != std::string::npos;
+         newline = previous.find('\n', newline + 1))
+    {
+        if (isSafeLineBreak(previous, newline) && isSafeLineBreak(text, newline + shift))
+        {
+            end = newline + 1;
+            break;
+        }
+    }
+    size_t newEnd = (end == oldSize) ? newSize : end + shift;
+
+    Lexer chunk(text, start, newEnd);
+    if (chunk.scan())
+    {
+        // a '\0' in the edit: the full lexer decides what happens
+        return relexAll(text);
+    }
+
+    size_t head = tokens.lowerBound(start);
+    size_t tail = (end == oldSize) ? tokens.size() : tokens.lowerBound(end);
+    int startLine = (head > 0) ? tokens.lines[head - 1] + 1 : 1;
+    int endLine = startLine + chunk.linenum - 1;
+
+    TokenStream next(text);
+    next.reserve(head + chunk.tokens.size() + (tokens.size() - tail) + 1);
+    next.append(tokens, 0, head, 0, 0);
+    next.append(chunk.tokens, 0, chunk.tokens.size(), 0, startLine - 1);
+    if (end == oldSize)
+    {
+        next.push(TOKEN_EOF, newSize, 0, endLine, chunk.charnum);
+    }
+    else
+    {
+        next.append(tokens, tail, tokens.size(), shift, endLine - (int)tokens.lines[tail]);
+    }
+
+    previous.assign(text);
+    next.source = previous;
+    tokens = std::move(next);
+    relexed = newEnd - start;
+    return tokens;
+}
@@ -0,0 +1,276 @@
+#include "module.hpp"
+#include "sourcefile.hpp"
+#include "threadpool.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <future>
+
+namespace fs = std::filesystem;
+
+// Run `job` on each module, on the shared pool when there is more than one.
+template <typename F>
+static void forEach(const std::vector<Module *> &batch, F job)
+{
+    if (batch.size() < 2 || ThreadPool::onWorkerThread())
+    {
+        for (Module *module : batch)
+        {
+            job(*module);
+        }
+        return;
+    }
+    std::vector<std::future<void>> done;
+    for (Module *module : batch)
+    {
+        done.push_back(ThreadPool::shared().submit([&job, module] { job(*module); }));
+    }
+    for (std::future<void> &result : done)
+    {
+        result.get();
+    }
+}
+
+static std::string normalize(const fs::path &path)
+{
+    return path.lexically_normal().generic_string();
+}
+
+bool ModuleGraph::load(const std::string &entry)
+{
+    std::vector<Module *> wave = {add(normalize(entry))};
+    while (!wave.empty())
+    {
+        forEach(wave, [this](Module &module) { parse(module); });
+        std::vector<Module *> discovered;
+        for (Module *module : wave)
+        {
+            resolveImports(*module, discovered);
+        }
+        wave.swap(discovered);
+    }
+    sort();
+    return modules.front()->ast != nullptr;
+}
+
+Module *ModuleGraph::add(const std::string &path)
+{
+    modules.push_back(std::make_unique<Module>());
+    Module *module = modules.back().get();
+    module->path = path;
+    module->state = &(*states)[path];
+    byPath[path] = module;
+    return module;
+}
+
+void ModuleGraph::parse(Module &module)
+{
+    if (!module.source.open(module.path))
+    {
+        module.session->diagnostics.error("ImportError", "Could not read " + module.path);
+        return;
+    }
+    module.hash = hashSource(module.source.text());
+    if (cache && (module.ast = cache->load(module.path, module.hash, *module.session)))
+    {
+        module.cached = true;
+        module.sourcemap = SourceMap(module.source.text());
+        return;
+    }
+    const TokenStream &tokens = module.state->lexer.update(module.source.text());
+    module.sourcemap = SourceMap(module.state->lexer.text());
+    module.source.close();
+    AST_NODE *root = module.state->parser.parse(tokens, module.sourcemap, module.session);
+    module.ast = std::make_unique<Ast>(root, &module.session->arena);
+}
+
+// Imports name files relative to the importing file.
+void ModuleGraph::resolveImports(Module &module, std::vector<Module *> &discovered)
+{
+    if (!module.ast)
+    {
+        return;
+    }
+    for (AstNode statement : module.ast->root().subs())
+    {
+        if (!statement || statement.type() != NODE_IMPORT)
+        {
+            continue;
+        }
+        std::string path = normalize(fs::path(module.path).parent_path() / statement.value());
+        auto known = byPath.find(path);
+        Module *imported = nullptr;
+        if (known != byPath.end())
+        {
+            imported = known->second;
+        }
+        else if (fs::is_regular_file(path))
+        {
+            imported = add(path);
+            discovered.push_back(imported);
+        }
+        else
+        {
+            module.session->diagnostics.error("ImportError", "Cannot find module '" + statement.value() + "' (looked for " + path + ")",
+                                             statement.lineno(), statement.charno(), statement.value().size() + 2);
+            continue;
+        }
+        module.imports.push_back({statement, imported});
+    }
+}
+
+void ModuleGraph::sort()
+{
+    std::unordered_map<Module *, int> state; // 1 while on the stack, 2 once sorted
+    std::vector<Module *> stack;
+    sorted.clear();
+    visit(*modules.front(), state, stack);
+}
+
+// Depth-first, so every module lands in `sorted` after all it imports. An import
+// that closes a cycle is reported and dropped, which keeps the rest orderable.
+void ModuleGraph::visit(Module &module, std::unordered_map<Module *, int> &state, std::vector<Module *> &stack)
+{
+    state[&module] = 1;
+    stack.push_back(&module);
+    for (auto import = module.imports.begin(); import != module.imports.end();)
+    {
+        Module *imported = import->module;
+        if (state[imported] == 1)
+        {
+            std::string cycle;
+            for (auto at = std::find(stack.begin(), stack.end(), imported); at != stack.end(); ++at)
+            {
+                cycle += (*at)->path + " -> ";
+            }
+            module.session->diagnostics.error("ImportError", "Import cycle: " + cycle + imported->path,
+                                             import->node.lineno(), import->node.charno(), import->node.value().size() + 2);
+            import = module.imports.erase(import);
+            continue;
+        }
+        if (state[imported] == 0)
+        {
+            visit(*imported, state, stack);
+        }
+        module.level = std::max(module.level, imported->level + 1);
+        ++import;
+    }
+    stack.pop_back();
+    state[&module] = 2;
+    sorted.push_back(&module);
+}
+
+void ModuleGraph::analyze()
+{
+    SourceHash program = programHash();
+    bool unchanged = cache && !hasErrors() &&
+                     std::all_of(sorted.begin(), sorted.end(), [](const Module *module) { return module->cached; });
+    if (unchanged && cache->isChecked(program))
+    {
+        return;
+    }
+
+    int levels = 0;
+    for (Module *module : sorted)
+    {
+        levels = std::max(levels, module->level + 1);
+    }
+    for (int level = 0; level < levels; level++)
+    {
+        std::vector<Module *> batch;
+        for (Module *module : sorted)
+        {
+            if (module->level == level && module->ast)
+            {
+                batch.push_back(module);
+            }
+        }
+        forEach(batch, [](Module &module) {
+            module.analyzer = std::make_unique<SemanticAnalyzer>(module.session->diagnostics);
+            for (const ModuleImport &import : module.imports)
+            {
+                if (import.module->analyzer)
+                {
+                    module.analyzer->importFrom(*import.module->analyzer);
+                }
+            }
+            module.analyzer->analyze(*module.ast);
+        });
+    }
+    // Entries are only written here, annotated, so every entry of a checked
+    // program comes from the analysis that checked it.
+    if (cache && isClean())
+    {
+        forEach(sorted, [this](Module &module) { cache->store(module.path, module.hash, *module.ast); });
+        cache->markChecked(program);
+    }
+}
+
+// Every module's path and contents, in build order.
+SourceHash ModuleGraph::programHash() const
+{
+    SourceHash program;
+    for (const Module *module : sorted)
+    {
+        program = combineHashes(program, hashSource(module->path));
+        program = combineHashes(program, module->hash);
+    }
+    return program;
+}
+
+bool ModuleGraph::isClean() const
+{
+    for (const std::unique_ptr<Module> &module : modules)
+    {
+        if (!module->session->diagnostics.all().empty())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+Ast ModuleGraph::merge(CompilationSession &session) const
+{
+    std::vector<const Ast *> parts;
+    for (const Module *module : sorted)
+    {
+        if (module->ast)
+        {
+            parts.push_back(module->ast.get());
+        }
+    }
+    return Ast(parts, &session.arena);
+}
+
+bool ModuleGraph::hasErrors() const
+{
+    return errorCount() > 0;
+}
+
+size_t ModuleGraph::errorCount() const
+{
+    size_t errors = 0;
+    for (const std::unique_ptr<Module> &module : modules)
+    {
+        errors += module->session->diagnostics.errorCount();
+    }
+    return errors;
+}
+
+void ModuleGraph::printDiagnostics(std::ostream &out) const
+{
+    for (const std::unique_ptr<Module> &module : modules)
+    {
+        module->session->diagnostics.print(out, module->sourcemap, modules.size() > 1 ? module->path : "");
+    }
+}
+
+size_t ModuleGraph::bytesUsed() const
+{
+    size_t bytes = 0;
+    for (const std::unique_ptr<Module> &module : modules)
+    {
+        bytes += module->session->bytesUsed();
+    }
+    return bytes;
+}
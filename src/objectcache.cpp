@@ -0,0 +1,103 @@
+#include "objectcache.hpp"
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+// The process and a count of the temporaries it has named, so neither another
+// build sharing the directory nor another thread of this one picks it too.
+static std::string uniqueSuffix()
+{
+    static std::atomic<unsigned> next{0};
+    return "." + std::to_string(getpid()) + "." + std::to_string(next++) + ".part";
+}
+
+std::string ObjectCache::entryFor(SourceHash key, const char *suffix) const
+{
+    char name[48];
+    std::snprintf(name, sizeof name, "%016llx%016llx%s", (unsigned long long)key.high, (unsigned long long)key.low, suffix);
+    return (fs::path(directory) / name).string();
+}
+
+std::string ObjectCache::objectFor(SourceHash key, const char *suffix) const
+{
+    return entryFor(key, suffix);
+}
+
+std::string ObjectCache::temporaryFor(SourceHash key, const char *suffix) const
+{
+    return objectFor(key, suffix) + uniqueSuffix();
+}
+
+bool ObjectCache::hasObject(SourceHash key, const char *suffix) const
+{
+    std::error_code error;
+    return fs::is_regular_file(objectFor(key, suffix), error);
+}
+
+bool ObjectCache::storeObject(SourceHash key, const std::string &built, const char *suffix) const
+{
+    std::error_code error;
+    fs::create_directories(directory, error);
+    fs::rename(built, objectFor(key, suffix), error);
+    if (error)
+    {
+        fs::remove(built, error);
+        return false;
+    }
+    return true;
+}
+
+bool ObjectCache::restoreLink(SourceHash key, const std::string &into) const
+{
+    std::error_code error;
+    fs::directory_iterator entry(entryFor(key, ".link"), error);
+    if (error)
+    {
+        return false;
+    }
+    fs::create_directories(into, error);
+    for (; entry != fs::directory_iterator(); entry.increment(error))
+    {
+        fs::copy_file(entry->path(), fs::path(into) / entry->path().filename(), fs::copy_options::overwrite_existing, error);
+        if (error)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Copied into a directory of its own, which is then renamed into place whole.
+bool ObjectCache::storeLink(SourceHash key, const std::vector<std::string> &files) const
+{
+    std::error_code error;
+    std::string entry = entryFor(key, ".link");
+    std::string temporary = entry + uniqueSuffix();
+    fs::create_directories(temporary, error);
+    for (const std::string &file : files)
+    {
+        fs::copy_file(file, fs::path(temporary) / fs::path(file).filename(), fs::copy_options::overwrite_existing, error);
+        if (error)
+        {
+            fs::remove_all(temporary, error);
+            return false;
+        }
+    }
+    fs::rename(temporary, entry, error);
+    if (error)
+    {
+        // a build racing this one may have stored the same link first
+        std::error_code ignored;
+        fs::remove_all(temporary, ignored);
+        return fs::is_directory(entry, ignored);
+    }
+    return true;
+}
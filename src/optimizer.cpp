@@ -0,0 +1,655 @@
+#include "optimizer.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <utility>
+
+// The generated C++ holds Helios ints in `int`.
+static bool fitsInt(int64_t value)
+{
+    return value >= INT32_MIN && value <= INT32_MAX;
+}
+
+static Constant integerConstant(int64_t value)
+{
+    Constant constant{NODE_INT};
+    constant.integer = value;
+    constant.text = std::to_string(value);
+    return constant;
+}
+
+// Printed with enough digits to read back as the same double, and always with
+// a '.' or exponent so the literal stays floating point.
+static std::optional<Constant> realConstant(double value)
+{
+    if (!std::isfinite(value))
+    {
+        return std::nullopt;
+    }
+    char buffer[32];
+    std::snprintf(buffer, sizeof buffer, "%.17g", value);
+    Constant constant{NODE_FLOAT};
+    constant.real = value;
+    constant.text = buffer;
+    if (constant.text.find_first_of(".e") == std::string::npos)
+    {
+        constant.text += ".0";
+    }
+    return constant;
+}
+
+static Constant stringConstant(std::string value)
+{
+    Constant constant{NODE_STRING};
+    constant.text = std::move(value);
+    return constant;
+}
+
+static Constant boolConstant(bool value)
+{
+    Constant constant{NODE_BOOL};
+    constant.truth = value;
+    constant.text = value ? "true" : "false";
+    return constant;
+}
+
+static const Constant always = boolConstant(true);
+
+static bool numeric(const Constant &constant)
+{
+    return constant.kind == NODE_INT || constant.kind == NODE_FLOAT;
+}
+
+static double real(const Constant &constant)
+{
+    return constant.kind == NODE_INT ? constant.integer : constant.real;
+}
+
+template <typename T>
+static std::optional<Constant> compare(const std::string &op, const T &lhs, const T &rhs)
+{
+    if (op == "==") return boolConstant(lhs == rhs);
+    if (op == "!=") return boolConstant(lhs != rhs);
+    if (op == "<") return boolConstant(lhs < rhs);
+    if (op == ">") return boolConstant(lhs > rhs);
+    if (op == "<=") return boolConstant(lhs <= rhs);
+    if (op == ">=") return boolConstant(lhs >= rhs);
+    return std::nullopt;
+}
+
+static std::optional<Constant> binary(const std::string &op, const Constant &lhs, const Constant &rhs)
+{
+    if (lhs.kind == NODE_INT && rhs.kind == NODE_INT)
+    {
+        if (!fitsInt(lhs.integer) || !fitsInt(rhs.integer))
+        {
+            return std::nullopt;
+        }
+        int64_t result;
+        if (op == "+") result = lhs.integer + rhs.integer;
+        else if (op == "-") result = lhs.integer - rhs.integer;
+        else if (op == "*") result = lhs.integer * rhs.integer;
+        else if (op == "/" && rhs.integer != 0) result = lhs.integer / rhs.integer;
+        else return compare(op, lhs.integer, rhs.integer);
+        return fitsInt(result) ? std::optional<Constant>(integerConstant(result)) : std::nullopt;
+    }
+    if (numeric(lhs) && numeric(rhs))
+    {
+        double left = real(lhs), right = real(rhs);
+        if (op == "+") return realConstant(left + right);
+        if (op == "-") return realConstant(left - right);
+        if (op == "*") return realConstant(left * right);
+        if (op == "/") return realConstant(left / right);
+        return compare(op, left, right);
+    }
+    if (lhs.kind == NODE_STRING && rhs.kind == NODE_STRING)
+    {
+        if (op == "+") return stringConstant(lhs.text + rhs.text);
+        return compare(op, lhs.text, rhs.text);
+    }
+    if (lhs.kind == NODE_BOOL && rhs.kind == NODE_BOOL && (op == "==" || op == "!="))
+    {
+        return compare(op, lhs.truth, rhs.truth);
+    }
+    return std::nullopt;
+}
+
+static bool isLiteral(AstNode node)
+{
+    switch (node.type())
+    {
+        case NODE_INT:
+        case NODE_FLOAT:
+        case NODE_STRING:
+            return true;
+        case NODE_BOOL:
+            return node.subCount() == 0;
+        default:
+            return false;
+    }
+}
+
+// Nodes whose SUB_STATEMENTS are statements run in order, rather than operands
+// or UI children.
+static bool holdsStatements(uint8_t kind)
+{
+    switch (kind)
+    {
+        case NODE_ROOT:
+        case NODE_FUNCTION_DECL:
+        case NODE_WHILE:
+        case NODE_FOR:
+        case NODE_page:
+        case NODE_ELSE_IF:
+        case NODE_ELSE:
+            return true;
+        default:
+            return false;
+    }
+}
+
+Optimizer::Optimizer(const Ast &program)
+    : program(program), constants(program.size()), folded(program.size()), removed(program.size())
+{
+}
+
+Ast Optimizer::run(std::pmr::memory_resource *arena)
+{
+    // dropping one assignment can leave what it read unread in turn
+    Plan root = plain(program.root());
+    while (sweep(root))
+    {
+        root = plain(program.root());
+    }
+    Ast out(arena);
+    out.reserve(program.size());
+    layout(out, root, allocate(out, root));
+    return out;
+}
+
+const Constant *Optimizer::fold(AstNode node)
+{
+    if (!node)
+    {
+        return nullptr;
+    }
+    uint32_t id = node.id();
+    if (!folded[id])
+    {
+        folded[id] = true;
+        constants[id] = evaluate(node);
+    }
+    return constants[id] ? &*constants[id] : nullptr;
+}
+
+std::optional<Constant> Optimizer::evaluate(AstNode node)
+{
+    switch (node.type())
+    {
+        case NODE_INT: {
+            Constant constant = integerConstant(node.intValue());
+            constant.text = node.value();
+            return constant;
+        }
+        case NODE_FLOAT: {
+            Constant constant{NODE_FLOAT};
+            constant.real = node.floatValue();
+            constant.text = node.value();
+            return constant;
+        }
+        case NODE_STRING:
+            return stringConstant(node.value());
+        case NODE_BOOL:
+            if (node.subCount() == 0)
+            {
+                if (node.value() != "true" && node.value() != "false")
+                {
+                    return std::nullopt;
+                }
+                return boolConstant(node.value() == "true");
+            }
+            [[fallthrough]];
+        case NODE_BINARY_OP: {
+            if (node.subCount() != 2)
+            {
+                return std::nullopt;
+            }
+            const Constant *lhs = fold(node.sub(0));
+            const Constant *rhs = fold(node.sub(1));
+            if (!lhs || !rhs)
+            {
+                return std::nullopt;
+            }
+            return binary(node.value(), *lhs, *rhs);
+        }
+        case NODE_MATH_SQRT: {
+            // correctly rounded everywhere, unlike sin/cos/tan
+            const Constant *operand = fold(node.child());
+            if (!operand || !numeric(*operand) || real(*operand) < 0)
+            {
+                return std::nullopt;
+            }
+            return realConstant(std::sqrt(real(*operand)));
+        }
+        case NODE_MATH_POW: {
+            // pow(x) is emitted as pow(x, x)
+            const Constant *base = fold(node.child() ? node.child() : node.sub(0));
+            const Constant *exponent = fold(node.child() ? node.child() : node.sub(1));
+            if (!base || !exponent || base->kind != NODE_INT || exponent->kind != NODE_INT || exponent->integer < 0)
+            {
+                return std::nullopt;
+            }
+            int64_t b = base->integer, e = exponent->integer;
+            if (b == 0 || b == 1 || b == -1)
+            {
+                return realConstant(e == 0 ? 1.0 : b == -1 ? (e % 2 ? -1.0 : 1.0) : double(b));
+            }
+            // only while every step is an exact double
+            const int64_t exact = int64_t(1) << 53;
+            int64_t result = 1;
+            for (int64_t i = 0; i < e; i++)
+            {
+                if (std::abs(result) > exact / std::abs(b))
+                {
+                    return std::nullopt;
+                }
+                result *= b;
+            }
+            return realConstant(double(result));
+        }
+        case NODE_TOSTR: {
+            const Constant *operand = fold(node.child());
+            if (operand && operand->kind == NODE_INT && fitsInt(operand->integer))
+            {
+                return stringConstant(std::to_string(operand->integer));
+            }
+            if (operand && operand->kind == NODE_FLOAT)
+            {
+                return stringConstant(std::to_string(operand->real));
+            }
+            return std::nullopt;
+        }
+        case NODE_TOINT: {
+            // stoi, on a string that is nothing but an int
+            const Constant *operand = fold(node.child());
+            if (!operand || operand->kind != NODE_STRING)
+            {
+                return std::nullopt;
+            }
+            const std::string &text = operand->text;
+            const char *begin = text.data() + (!text.empty() && text[0] == '+');
+            int64_t value;
+            auto [end, error] = std::from_chars(begin, text.data() + text.size(), value);
+            if (error != std::errc() || end != text.data() + text.size() || begin == end || !fitsInt(value))
+            {
+                return std::nullopt;
+            }
+            return integerConstant(value);
+        }
+        case NODE_TOFLOAT: {
+            // stof rounds to float; only fold what a float holds exactly
+            const Constant *operand = fold(node.child());
+            if (!operand || operand->kind != NODE_STRING)
+            {
+                return std::nullopt;
+            }
+            const std::string &text = operand->text;
+            double value;
+            auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value, std::chars_format::fixed);
+            if (error != std::errc() || end != text.data() + text.size() || double(float(value)) != value)
+            {
+                return std::nullopt;
+            }
+            return realConstant(value);
+        }
+        default:
+            return std::nullopt;
+    }
+}
+
+// Whether evaluating `node` could be skipped without the program noticing.
+bool Optimizer::pure(AstNode node)
+{
+    if (!node || fold(node))
+    {
+        return true;
+    }
+    switch (node.type())
+    {
+        case NODE_VARIABLE:
+            return !node.child();
+        case NODE_BOOL:
+        case NODE_BINARY_OP:
+        case NODE_MATH_SIN:
+        case NODE_MATH_COS:
+        case NODE_MATH_TAN:
+        case NODE_MATH_SQRT:
+        case NODE_MATH_POW:
+        case NODE_TOSTR:
+            if (!pure(node.child()))
+            {
+                return false;
+            }
+            for (AstNode sub : node.subs())
+            {
+                if (!pure(sub))
+                {
+                    return false;
+                }
+            }
+            return true;
+        default:
+            return false;
+    }
+}
+
+Optimizer::Plan Optimizer::expression(AstNode node)
+{
+    const Constant *constant = fold(node);
+    if (constant && !isLiteral(node))
+    {
+        return Plan{node.id(), uint8_t(constant->kind), constant};
+    }
+    return plain(node);
+}
+
+Optimizer::Plan Optimizer::plain(AstNode node)
+{
+    Plan plan{node.id(), uint8_t(node.type())};
+    if (node.child())
+    {
+        plan.child = std::make_unique<Plan>(expression(node.child()));
+    }
+    if (holdsStatements(plan.kind))
+    {
+        body(node, plan.subs);
+        return plan;
+    }
+    uint32_t first = program.firstChild[node.id()];
+    for (uint32_t i = 0; i < node.subCount(); i++)
+    {
+        AstNode sub = program.node(first + i);
+        plan.subs.push_back(sub ? expression(sub) : Plan{first + i, Ast::EMPTY});
+    }
+    return plan;
+}
+
+// The statements of `block`; for an if, those before its else-ifs and else.
+void Optimizer::body(AstNode block, std::vector<Plan> &out)
+{
+    uint32_t first = program.firstChild[block.id()];
+    for (uint32_t i = 0; i < block.subCount(); i++)
+    {
+        AstNode sub = program.node(first + i);
+        if (!sub)
+        {
+            out.push_back(Plan{first + i, Ast::EMPTY});
+            continue;
+        }
+        if (block.type() == NODE_IF && (sub.type() == NODE_ELSE_IF || sub.type() == NODE_ELSE))
+        {
+            continue;
+        }
+        statement(sub, out);
+    }
+}
+
+void Optimizer::statement(AstNode node, std::vector<Plan> &out)
+{
+    if (removed[node.id()])
+    {
+        return;
+    }
+    if (node.type() == NODE_IF)
+    {
+        branch(node, out);
+        return;
+    }
+    if (node.type() == NODE_WHILE)
+    {
+        const Constant *condition = fold(node.child());
+        if (condition && condition->kind == NODE_BOOL && !condition->truth)
+        {
+            return;
+        }
+    }
+    out.push_back(plain(node));
+}
+
+// An if/else-if/else chain without the clauses a constant condition rules out.
+// Once the clause that runs is known, its statements replace the chain, unless
+// they declare something.
+void Optimizer::branch(AstNode node, std::vector<Plan> &out)
+{
+    std::vector<AstNode> clauses = {node};
+    for (AstNode sub : node.subs())
+    {
+        if (sub && (sub.type() == NODE_ELSE_IF || sub.type() == NODE_ELSE))
+        {
+            clauses.push_back(sub);
+        }
+    }
+
+    std::vector<AstNode> kept;
+    bool settled = false; // the last kept clause is sure to run
+    for (AstNode clause : clauses)
+    {
+        const Constant *condition = clause.type() == NODE_ELSE ? nullptr : fold(clause.child());
+        bool known = condition && condition->kind == NODE_BOOL;
+        if (known && !condition->truth)
+        {
+            continue;
+        }
+        kept.push_back(clause);
+        if (known || clause.type() == NODE_ELSE)
+        {
+            settled = true;
+            break;
+        }
+    }
+    if (kept.empty())
+    {
+        return;
+    }
+
+    std::vector<Plan> statements;
+    body(kept[0], statements);
+    // the generated C++ declares a variable at each assignment, which would
+    // clash with the enclosing block's once moved out of the clause's own
+    bool declaring = std::any_of(statements.begin(), statements.end(), [](const Plan &statement) {
+        return (statement.kind == NODE_VARIABLE && statement.child) || statement.kind == NODE_SETSTATE ||
+               statement.kind == NODE_FUNCTION_DECL;
+    });
+    if (settled && kept.size() == 1 && !declaring)
+    {
+        for (Plan &statement : statements)
+        {
+            out.push_back(std::move(statement));
+        }
+        return;
+    }
+
+    Plan chain{kept[0].id(), NODE_IF};
+    chain.child = std::make_unique<Plan>(kept[0].type() == NODE_ELSE ? Plan{kept[0].id(), NODE_BOOL, &always}
+                                                                     : expression(kept[0].child()));
+    chain.subs = std::move(statements);
+    for (size_t i = 1; i < kept.size(); i++)
+    {
+        bool last = settled && i + 1 == kept.size();
+        Plan clause{kept[i].id(), uint8_t(last ? NODE_ELSE : NODE_ELSE_IF)};
+        if (!last)
+        {
+            clause.child = std::make_unique<Plan>(expression(kept[i].child()));
+        }
+        body(kept[i], clause.subs);
+        chain.subs.push_back(std::move(clause));
+    }
+    out.push_back(std::move(chain));
+}
+
+// Marks the statements nothing reads; false once there are no new ones.
+bool Optimizer::sweep(const Plan &root)
+{
+    reads.clear();
+    collectReads(root);
+    return mark(root);
+}
+
+// Every name the plan uses, other than the ones it assigns or declares.
+void Optimizer::collectReads(const Plan &plan)
+{
+    if (plan.literal || plan.kind == Ast::EMPTY)
+    {
+        return;
+    }
+    bool reading;
+    switch (plan.kind)
+    {
+        case NODE_VARIABLE:
+            reading = !plan.child;
+            break;
+        case NODE_SETSTATE:
+        case NODE_FUNCTION_DECL:
+        case NODE_INT:
+        case NODE_FLOAT:
+        case NODE_STRING:
+        case NODE_BOOL:
+        case NODE_BINARY_OP:
+        case NODE_UNARY_OP:
+            reading = false;
+            break;
+        default:
+            reading = true;
+    }
+    if (reading && program.symbols[plan.source])
+    {
+        reads.insert(program.symbols[plan.source]);
+    }
+    if (plan.child)
+    {
+        collectReads(*plan.child);
+    }
+    for (const Plan &sub : plan.subs)
+    {
+        collectReads(sub);
+    }
+}
+
+bool Optimizer::mark(const Plan &plan)
+{
+    bool marked = false;
+    if (holdsStatements(plan.kind) || plan.kind == NODE_IF)
+    {
+        for (const Plan &sub : plan.subs)
+        {
+            if (!sub.literal && !removed[sub.source] && unused(sub, plan.kind == NODE_ROOT))
+            {
+                removed[sub.source] = true;
+                marked = true;
+            }
+        }
+    }
+    if (plan.child)
+    {
+        marked |= mark(*plan.child);
+    }
+    for (const Plan &sub : plan.subs)
+    {
+        marked |= mark(sub);
+    }
+    return marked;
+}
+
+bool Optimizer::unused(const Plan &statement, bool topLevel)
+{
+    AstNode node = program.node(statement.source);
+    if (!node)
+    {
+        return false;
+    }
+    switch (statement.kind)
+    {
+        case NODE_VARIABLE:
+            // state is never dropped: assigning it re-renders the page
+            return statement.child && !node.isState() && !reads.contains(node.symbol()) && pure(node.child());
+        case NODE_FUNCTION_DECL:
+            return topLevel && !reads.contains(node.symbol());
+        case NODE_BOOL:
+        case NODE_BINARY_OP:
+        case NODE_MATH_SIN:
+        case NODE_MATH_COS:
+        case NODE_MATH_TAN:
+        case NODE_MATH_SQRT:
+        case NODE_MATH_POW:
+            // a value nothing uses
+            return pure(node);
+        default:
+            return false;
+    }
+}
+
+uint32_t Optimizer::allocate(Ast &out, const Plan &plan) const
+{
+    if (!plan.literal)
+    {
+        uint32_t id = out.copy(program, plan.source);
+        out.kinds[id] = plan.kind;
+        return id;
+    }
+    const Constant &constant = *plan.literal;
+    NumericValue number{0};
+    if (constant.kind == NODE_INT)
+    {
+        number.integer = constant.integer;
+    }
+    else if (constant.kind == NODE_FLOAT)
+    {
+        number.real = constant.real;
+    }
+    uint32_t source = plan.source;
+    uint32_t id = out.push(plan.kind, Symbols::intern(constant.text), number, program.lines[source], program.columns[source],
+                           program.offsets[source], program.lengths[source]);
+    switch (constant.kind)
+    {
+        case NODE_INT: out.types[id] = TYPE_INT; break;
+        case NODE_FLOAT: out.types[id] = TYPE_FLOAT; break;
+        case NODE_STRING: out.types[id] = TYPE_STRING; break;
+        default: out.types[id] = TYPE_BOOL; break;
+    }
+    return id;
+}
+
+// Same order as Ast::layout: a node's CHILD and SUB_STATEMENTS block get their
+// slots before any of them is laid out.
+void Optimizer::layout(Ast &out, const Plan &plan, uint32_t id) const
+{
+    if (plan.child)
+    {
+        out.children[id] = allocate(out, *plan.child);
+    }
+    uint32_t count = plan.subs.size();
+    uint32_t first = out.kinds.size();
+    for (uint32_t i = 0; i < count; i++)
+    {
+        allocate(out, plan.subs[i]);
+        if (i + 1 < count)
+        {
+            out.nextSibling[first + i] = first + i + 1;
+        }
+    }
+    if (count)
+    {
+        out.firstChild[id] = first;
+        out.childCounts[id] = count;
+    }
+
+    if (plan.child)
+    {
+        layout(out, *plan.child, out.children[id]);
+    }
+    for (uint32_t i = 0; i < count; i++)
+    {
+        layout(out, plan.subs[i], first + i);
+    }
+}
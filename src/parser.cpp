@@ -3,7 +3,9 @@
 #include <vector>
 #include <string>
 #include <cctype>
-#include <regex>
+#include <array>
+#include <charconv>
+#include <algorithm>
 
 
 string nodetostr(enum NODE_TYPE tYPE) {
@@ -56,160 +58,218 @@ string nodetostr(enum NODE_TYPE tYPE) {
         case NODE_MATH_SQRT: return "MATH_SQRT"; break;
         case NODE_MATH_TAN: return "MATH_TAN"; break;
         case NODE_PLATFORM_CLS: return "PLATFORM_CLASS"; break;
+        case NODE_IMPORT: return "IMPORT"; break;
         default: return "UNKNOWN"; break;
     }
 }
 
 
-Parser::Parser(vector<Token *> tokens) 
+Parser::Parser(const TokenStream &tokens, const SourceMap &sourcemap, CompilationSession &compilation) 
 {
-    parserTokens = tokens,
-    limit = parserTokens.size(),
+    session = &compilation,
+    source = &sourcemap,
+    parserTokens = &tokens,
+    limit = parserTokens->size(),
     index = 0,
-    current = parserTokens.at(index),
-    defined_keywords = { "true", "false", "null" },
-    loop_keywords = { "continue", "break", "pass" };
+    current = parserTokens->at(index);
 }
 
 
     // ---------- Error Handler ----------
+    // Reports the error and unwinds to the innermost statement loop, which skips
+    // ahead to the next statement and carries on.
     void Parser::parserError(const std::string &message) {
-        std::cerr << "\nParserError: " << message
-                  << " at line " << current->lineno
-                  << ", column " << current->charno << "\n";
-        std::cerr << "  " << current->lineno << " | " << current->sourceLine << "\n";
-        std::cerr << "    ";
-        for (int i = 1; i < (current->charno+to_string(current->lineno).length()+1); ++i)
-            std::cerr << " ";
-        for (int i = 0; i < current->value.length() + 2; i++)
-        {
-            std::cerr << "^";
-        }
-        std::cerr << "\n\n";
-        std::exit(1);
+        session->diagnostics.error("ParserError", current.TYPE == TOKEN_ERROR ? lexicalError(current) : message,
+                                   current.lineno, current.charno, current.value.length() + 2);
+        throw RecoverableError();
     }
 
      // ---------- Error Handler ----------
     void Parser::parserWarning(const std::string &message) {
-        std::cerr << "\nWarning: " << message
-                  << " at line " << current->lineno
-                  << ", column " << current->charno << "\n";
-        std::cerr << "  " << current->lineno << " | " << current->sourceLine << "\n";
-        std::cerr << "    ";
-        for (int i = 1; i < (current->charno+to_string(current->lineno).length()+1); ++i)
-            std::cerr << " ";
-        for (int i = 0; i < current->value.length() + 2; i++)
-        {
-            std::cerr << "^";
+        session->diagnostics.warning(message, current.lineno, current.charno, current.value.length() + 2);
+    }
+
+    string Parser::lexicalError(const Token &token) {
+        if (!token.value.empty() && (token.value[0] == '"' || token.value[0] == '\'')) {
+            return "UnTerminated String";
         }
-        std::cerr << "\n\n";
+        return "Unknown character: '" + string(token.value) + "'";
+    }
+
+    AST_NODE *Parser::parseBlockStatement(bool ispage) {
+        int start = index;
+        try {
+            AST_NODE *statement = parseStatement(ispage);
+            // a statement that read nothing would be parsed again forever
+            if (index == start && current.TYPE != TOKEN_EOF) {
+                parserError("Unexpected Token: " + string(current.value));
+            }
+            return statement;
+        } catch (const RecoverableError &) {
+            synchronize(start);
+            return nullptr;
+        }
+    }
+
+    // Skip the rest of the statement that began at token `start`: up to the first
+    // newline outside any bracket it opened, or to a '}' closing the enclosing
+    // block, which is left for the block's own loop to consume. A '(' or '['
+    // left open only holds out until a line that starts at or left of the
+    // statement's own column, so one missing ')' doesn't swallow the file.
+    bool Parser::startsStatementLine(int newline, int column) const {
+        int next = newline + 1;
+        while (next < limit && parserTokens->type(next) == TOKEN_NEWLINE) next++;
+        if (next >= limit) return true;
+        Tokentype type = parserTokens->type(next);
+        return (type == TOKEN_ID || type == TOKEN_KEYWORD || type == TOKEN_EOF) && (int)parserTokens->columns[next] <= column;
+    }
+
+    void Parser::synchronize(int start) {
+        int failedAt = index;
+        int column = parserTokens->columns[start];
+        int braces = 0;
+        int brackets = 0;
+        int i = start;
+        for (; i < limit; i++) {
+            Tokentype type = parserTokens->type(i);
+            if (type == TOKEN_EOF) break;
+            if (type == TOKEN_LBRACE) {
+                braces++;
+            } else if (type == TOKEN_LPAREN || type == TOKEN_LBRACKET) {
+                brackets++;
+            } else if (type == TOKEN_RPAREN || type == TOKEN_RBRACKET) {
+                if (brackets > 0) brackets--;
+            } else if (type == TOKEN_RBRACE) {
+                if (braces > 0) {
+                    braces--;
+                } else if (i >= failedAt) {
+                    break;
+                }
+            } else if (type == TOKEN_NEWLINE && braces == 0 && i >= failedAt) {
+                if (brackets == 0 || startsStatementLine(i, column)) break;
+            } else if (type == TOKEN_ERROR && i > failedAt) {
+                // lexical errors in skipped text still get reported
+                Token skipped = parserTokens->at(i);
+                session->diagnostics.error("ParserError", lexicalError(skipped), skipped.lineno, skipped.charno, skipped.value.length() + 2);
+            }
+        }
+        // a stray '}' the enclosing loop won't take, e.g. at the top level
+        if (i == start) i++;
+        index = i;
+        current = parserTokens->at(index);
     }
 
     // ---------- Token Consumption ----------
-    Token *Parser::proceed(enum Tokentype Tokentype) {
-        if (current->TYPE != Tokentype) {
-            if (current->TYPE == TOKEN_NEWLINE) {
+    const Token &Parser::proceed(enum Tokentype Tokentype) {
+        if (current.TYPE != Tokentype) {
+            if (current.TYPE == TOKEN_NEWLINE) {
                 parserError("Unexpected NewLine (expected " + typetostring(Tokentype) + ")");
             } 
-            parserError("Unexpected Token: " + current->value + " (expected " + typetostring(Tokentype) + ")");
+            parserError("Unexpected Token: " + string(current.value) + " (expected " + typetostring(Tokentype) + ")");
         }
         index++;
-        if (index < parserTokens.size()) {
-            current = parserTokens.at(index);
+        current = parserTokens->at(index);
+        return current;
+    }
+
+    // Token values are views into the lexer's buffer; the AST keeps its own copy.
+    NodeText Parser::tokenText() {
+        return NodeText(session->text(current.value), current.symbol);
+    }
+
+    // Nodes and their child lists both live in the session arena, so nothing
+    // needs destroying: the arena drops them all at once when the build ends.
+    AST_NODE *Parser::newNode() {
+        void *memory = session->arena.allocate(sizeof(AST_NODE), alignof(AST_NODE));
+        AST_NODE *node = new (memory) AST_NODE(&session->arena);
+        if (index < limit && current.TYPE != TOKEN_EOF) {
+            node->offset = parserTokens->offsets[index];
+            node->length = current.value.size();
         } else {
-            Token *eofToken = new Token();
-            eofToken->TYPE = TOKEN_EOF;
-            eofToken->value = "\0";
-            current = eofToken;
+            node->offset = parserTokens->source.size();
         }
-        return current;
+        return node;
     }
 
     // ---------- Atomic Parsing ----------
     AST_NODE *Parser::parseINT() {
-        if (current->TYPE != TOKEN_INT) {
+        if (current.TYPE != TOKEN_INT) {
             parserError("Expected integer literal");
         }
-        AST_NODE *node = new AST_NODE();
+        AST_NODE *node = newNode();
         node->TYPE = NODE_INT;
-        node->value = &current->value;
-        node->charno = current->charno;
-        node->lineno = current->lineno;
-        node->sourceLine = current->sourceLine;
-        node->extra = current->extra;
+        node->value = tokenText();
+        auto [end, error] = from_chars(current.value.data(), current.value.data() + current.value.size(), node->number.integer);
+        if (error != errc() || end != current.value.data() + current.value.size()) {
+            parserError("Integer literal out of range '" + string(current.value) + "'");
+        }
+        node->charno = current.charno;
+        node->lineno = current.lineno;
         proceed(TOKEN_INT);
         return node;
     }
 
     AST_NODE *Parser::parseID() {
-        string *buffer = &current->value;
+        NodeText buffer = tokenText();
         proceed(TOKEN_ID);
 
-        if (current->TYPE == TOKEN_NEWLINE || current->TYPE == TOKEN_EOF)
+        if (current.TYPE == TOKEN_NEWLINE || current.TYPE == TOKEN_EOF)
         {
-            AST_NODE *node = new AST_NODE();
+            AST_NODE *node = newNode();
         node->TYPE = NODE_VARIABLE;
         node->value = buffer;
-            node->lineno = current->lineno;
-            node->sourceLine = current->sourceLine;
-            node->extra = current->extra;
-            node->charno = current->charno;
+            node->lineno = current.lineno;
+            node->charno = current.charno;
         return node;
         }
         
-        if (current->TYPE == TOKEN_INCREMENT || current->TYPE == TOKEN_DECREMENT) {
+        if (current.TYPE == TOKEN_INCREMENT || current.TYPE == TOKEN_DECREMENT) {
             // Handle postfix i++ or i--
-            string op = current->value;
-            proceed(current->TYPE);
+            string op(current.value);
+            proceed(current.TYPE);
 
-            AST_NODE *node = new AST_NODE();
+            AST_NODE *node = newNode();
             node->TYPE = NODE_UNARY_OP;
-            node->value = new string(op);
+            node->value = session->text(op);
 
-            AST_NODE *varNode = new AST_NODE();
+            AST_NODE *varNode = newNode();
             varNode->TYPE = NODE_VARIABLE;
             varNode->value = buffer;
 
             node->CHILD = varNode;
-            node->charno = current->charno;
-            node->lineno = current->lineno;
-            node->sourceLine = current->sourceLine;
-            node->extra = current->extra;
+            node->charno = current.charno;
+            node->lineno = current.lineno;
             return node;
         }
 
-        if (current->TYPE == TOKEN_LPAREN)
+        if (current.TYPE == TOKEN_LPAREN)
         {
             return parseFunctionCall(buffer);
         }
-        if(current->TYPE == TOKEN_DOT) {
+        if(current.TYPE == TOKEN_DOT) {
             return parseInstancecall(buffer);
         }
 
-        // if (current->TYPE == TOKEN_PLUSOP || current->TYPE == TOKEN_MINUSOP || current->TYPE == TOKEN_DIVOP || current->TYPE == TOKEN_MULOP) {
+        // if (current.TYPE == TOKEN_PLUSOP || current.TYPE == TOKEN_MINUSOP || current.TYPE == TOKEN_DIVOP || current.TYPE == TOKEN_MULOP) {
 
         // }
         // Otherwise assignment
         proceed(TOKEN_EQ);
-        AST_NODE *node = new AST_NODE();
+        AST_NODE *node = newNode();
         node->TYPE = NODE_VARIABLE;
         node->value = buffer;
         node->CHILD = parseComparison();
-        node->lineno = current->lineno;
-        node->sourceLine = current->sourceLine;
-        node->extra = current->extra;
-        node->charno = current->charno;
+        node->lineno = current.lineno;
+        node->charno = current.charno;
         return node;
     }
 
-    AST_NODE *Parser::parseInstancecall(string *buffer) {
-        AST_NODE *node =  new AST_NODE();;
+    AST_NODE *Parser::parseInstancecall(NodeText buffer) {
+        AST_NODE *node =  newNode();;
         node->TYPE = NODE_INSTANCE;
         node->value = buffer;
-        node->lineno = current->lineno;
-        node->sourceLine = current->sourceLine;
-        node->extra = current->extra;
-        node->charno = current->charno;
+        node->lineno = current.lineno;
+        node->charno = current.charno;
         proceed(TOKEN_DOT);
         node->CHILD = parseExpression();
         return node;
@@ -217,18 +277,16 @@ Parser::Parser(vector<Token *> tokens)
 
     //parse list
     AST_NODE *Parser::parseList() {
-        AST_NODE *listNode = new AST_NODE();
+        AST_NODE *listNode = newNode();
         // consume '['
         proceed(TOKEN_LBRACKET);
 
         // empty list case: []
-        if (current->TYPE == TOKEN_RBRACKET) {
+        if (current.TYPE == TOKEN_RBRACKET) {
             proceed(TOKEN_RBRACKET);
             listNode->TYPE = NODE_LIST;
-        listNode->lineno = current->lineno;
-                listNode->sourceLine = current->sourceLine;
-                listNode->extra = current->extra;
-                listNode->charno = current->charno;
+        listNode->lineno = current.lineno;
+                listNode->charno = current.charno;
             return listNode;
         }
 
@@ -236,7 +294,7 @@ Parser::Parser(vector<Token *> tokens)
         listNode->SUB_STATEMENTS.push_back(parseExpression());
 
         // parse remaining elements separated by commas
-        while (current->TYPE == TOKEN_COMMA) {
+        while (current.TYPE == TOKEN_COMMA) {
             proceed(TOKEN_COMMA);
             listNode->SUB_STATEMENTS.push_back(parseExpression());
         }
@@ -244,49 +302,45 @@ Parser::Parser(vector<Token *> tokens)
         // closing bracket
         proceed(TOKEN_RBRACKET);
         listNode->TYPE = NODE_LIST;
-        listNode->lineno = current->lineno;
-                listNode->sourceLine = current->sourceLine;
-                listNode->extra = current->extra;
-                listNode->charno = current->charno;
+        listNode->lineno = current.lineno;
+                listNode->charno = current.charno;
         return listNode;
 }
 
     AST_NODE *Parser::parseDict(bool styleparse) {
-        AST_NODE* objNode = new AST_NODE();
+        AST_NODE* objNode = newNode();
             objNode->TYPE = NODE_DICT;
-            objNode->charno = current->charno;
-            objNode->lineno = current->lineno;
-            objNode->sourceLine = current->sourceLine;
-            objNode->extra = current->extra;
-            if (current->TYPE == TOKEN_HASH)
+            objNode->charno = current.charno;
+            objNode->lineno = current.lineno;
+            if (current.TYPE == TOKEN_HASH)
             {
-                objNode->value = &(current->value);
+                objNode->value = tokenText();
                 proceed(TOKEN_HASH);
             }
             
             proceed(TOKEN_LBRACE);
-            while (current->TYPE == TOKEN_NEWLINE)
+            while (current.TYPE == TOKEN_NEWLINE)
             {
                 proceed(TOKEN_NEWLINE);
             }
-            if(current->TYPE != TOKEN_RBRACE ) 
+            if(current.TYPE != TOKEN_RBRACE ) 
             {   
-                if(current->TYPE != TOKEN_RBRACE) 
+                if(current.TYPE != TOKEN_RBRACE) 
                 {   
-                    if (current->TYPE == TOKEN_NEWLINE)
+                    if (current.TYPE == TOKEN_NEWLINE)
                         {
                             proceed(TOKEN_NEWLINE);
                         }
 
-                    AST_NODE* keyNode = new AST_NODE();
-                    if (current->TYPE == TOKEN_ID)
+                    AST_NODE* keyNode = newNode();
+                    if (current.TYPE == TOKEN_ID)
                     {
                         keyNode->TYPE = NODE_VARIABLE;
-                        keyNode->value = &(current->value);
+                        keyNode->value = tokenText();
                         proceed(TOKEN_ID); // move past key
                     } else {
                        keyNode->TYPE = NODE_STRING;
-                        keyNode->value = &(current->value);
+                        keyNode->value = tokenText();
                         proceed(TOKEN_STRING); // move past key
                     }
                     // Expect colon
@@ -294,26 +348,26 @@ Parser::Parser(vector<Token *> tokens)
                     // Parse value (can be expression, string, int, or even nested object)
                     AST_NODE* valueNode = parseExpression();
                     // Make a key–value pair node
-                    AST_NODE* pairNode = new AST_NODE();
+                    AST_NODE* pairNode = newNode();
                     pairNode->TYPE = NODE_KEYVALUE;
                     pairNode->SUB_STATEMENTS = { keyNode, valueNode };
                     // Add to object node
                     objNode->SUB_STATEMENTS.push_back(pairNode);
-                    while (current->TYPE == TOKEN_COMMA) {
+                    while (current.TYPE == TOKEN_COMMA) {
                         proceed(TOKEN_COMMA);
-                        if (current->TYPE == TOKEN_NEWLINE)
+                        if (current.TYPE == TOKEN_NEWLINE)
                         {
                             proceed(TOKEN_NEWLINE);
                         }
-                            AST_NODE* keyNode = new AST_NODE();
-                            if (current->TYPE == TOKEN_ID)
+                            AST_NODE* keyNode = newNode();
+                            if (current.TYPE == TOKEN_ID)
                             {
                                 keyNode->TYPE = NODE_VARIABLE;
-                                keyNode->value = &(current->value);
+                                keyNode->value = tokenText();
                                 proceed(TOKEN_ID); // move past key
                             } else {
                             keyNode->TYPE = NODE_STRING;
-                                keyNode->value = &(current->value);
+                                keyNode->value = tokenText();
                                 proceed(TOKEN_STRING); // move past key
                             }
                         // Expect colon
@@ -325,63 +379,64 @@ Parser::Parser(vector<Token *> tokens)
                         
                         
                         // Make a key–value pair node
-                        AST_NODE* pairNode = new AST_NODE();
+                        AST_NODE* pairNode = newNode();
                         pairNode->TYPE = NODE_KEYVALUE;
                         pairNode->SUB_STATEMENTS = { keyNode, valueNode };
                         // Add to object node
                         objNode->SUB_STATEMENTS.push_back(pairNode);
                     }
                 }
-                while (current->TYPE == TOKEN_NEWLINE)
+                while (current.TYPE == TOKEN_NEWLINE)
                 {
                     proceed(TOKEN_NEWLINE);
                 }
                 proceed(TOKEN_RBRACE);
                 objNode->TYPE = NODE_DICT;
-        objNode->lineno = current->lineno;
-            objNode->sourceLine = current->sourceLine;
-            objNode->extra = current->extra;
-                objNode->charno = current->charno;
+        objNode->lineno = current.lineno;
+                objNode->charno = current.charno;
                 return objNode;
             } else
             {
                 proceed(TOKEN_RBRACE);
                 objNode->TYPE = NODE_DICT;
-        objNode->lineno = current->lineno;
-            objNode->sourceLine = current->sourceLine;
-            objNode->extra = current->extra;
-            objNode->charno = current->charno;
+        objNode->lineno = current.lineno;
+            objNode->charno = current.charno;
                 return objNode;
             }
                  
     }
 
+    // Plain decimal: digits with at most one '.', not leading. No sign, exponent,
+    // inf or nan, which from_chars would otherwise take.
+    static bool parseNumber(string_view text, double &number) {
+        if (text.empty() || !isdigit((unsigned char)text[0])) return false;
+        auto [end, error] = from_chars(text.data(), text.data() + text.size(), number, chars_format::fixed);
+        return error == errc() && end == text.data() + text.size();
+    }
+
     AST_NODE *Parser::parseConversions(NODE_TYPE nodetype) {
         proceed(TOKEN_KEYWORD);
-        AST_NODE *node = new AST_NODE();
+        AST_NODE *node = newNode();
         node->TYPE = nodetype;
-        node->charno = current->charno;
-        node->lineno = current->lineno;
-        node->sourceLine = current->sourceLine;
-        node->extra = current->extra;
+        node->charno = current.charno;
+        node->lineno = current.lineno;
         proceed(TOKEN_LPAREN);
         // node->CHILD = parseComparison();
         switch (nodetype) {
             case NODE_TOSTR: {
-                if (current->TYPE != TOKEN_INT || current->TYPE != TOKEN_FLOAT) {
+                if (current.TYPE != TOKEN_INT || current.TYPE != TOKEN_FLOAT) {
                     parserError("Can Only Convert Number str");
                 }
             }
             case NODE_TOFLOAT:
             case NODE_TOINT: {
-                if (current->TYPE != TOKEN_STRING) {
-                    parserError("Can onnly convert str to number '"+ current->value + "'");
+                if (current.TYPE != TOKEN_STRING) {
+                    parserError("Can onnly convert str to number '"+ string(current.value) + "'");
                 }
-                if (current->TYPE == TOKEN_STRING) {
-                    const regex pattern("^[0-9]*\\.?[0-9]+$|^[0-9]+\\.?[0-9]*$");
-
-                    if (!regex_match(current->value, pattern) || current->value[0] == '.') {
-                        parserError("String Doesnt Contain Number '"+ current->value + "'");
+                if (current.TYPE == TOKEN_STRING) {
+                    double number;
+                    if (!parseNumber(current.value, number)) {
+                        parserError("String Doesnt Contain Number '"+ string(current.value) + "'");
                     }
                 }   
             }
@@ -397,264 +452,243 @@ Parser::Parser(vector<Token *> tokens)
 
     // ---------- Factor ----------
     AST_NODE *Parser::parseFactor() {
-        if (current->TYPE == TOKEN_LBRACE || current->TYPE == TOKEN_HASH) {
+        if (current.TYPE == TOKEN_LBRACE || current.TYPE == TOKEN_HASH) {
             AST_NODE *node = parseDict();
             node->TYPE = NODE_DICT;
-        node->lineno = current->lineno;
-            node->sourceLine = current->sourceLine;
-            node->extra = current->extra;
-            node->charno = current->charno;
+        node->lineno = current.lineno;
+            node->charno = current.charno;
             return node;
         }
         
 
-        if (current->TYPE == TOKEN_LBRACKET)
+        if (current.TYPE == TOKEN_LBRACKET)
         {
            AST_NODE *node = parseList();
-           proceed(current->TYPE);
-           node->lineno = current->lineno;
-            node->sourceLine = current->sourceLine;
-            node->extra = current->extra;
-            node->charno = current->charno;
+           proceed(current.TYPE);
+           node->lineno = current.lineno;
+            node->charno = current.charno;
            return node;
         }
         
         // prefix ++ / --
-        if (current->TYPE == TOKEN_INCREMENT || current->TYPE == TOKEN_DECREMENT) {
-            string op = current->value;
-            proceed(current->TYPE);
+        if (current.TYPE == TOKEN_INCREMENT || current.TYPE == TOKEN_DECREMENT) {
+            string op(current.value);
+            proceed(current.TYPE);
 
-            if (current->TYPE != TOKEN_ID)
+            if (current.TYPE != TOKEN_ID)
                 parserError("Expected identifier after unary operator");
 
-            AST_NODE *node = new AST_NODE();
+            AST_NODE *node = newNode();
             node->TYPE = NODE_UNARY_OP;
-            node->value = new string(op);
+            node->value = session->text(op);
 
-            AST_NODE *varNode = new AST_NODE();
+            AST_NODE *varNode = newNode();
             varNode->TYPE = NODE_VARIABLE;
-            varNode->value = &current->value;
+            varNode->value = tokenText();
             proceed(TOKEN_ID);
 
             node->CHILD = varNode;
-            node->lineno = current->lineno;
-            node->sourceLine = current->sourceLine;
-            node->extra = current->extra;
-            node->charno = current->charno;
+            node->lineno = current.lineno;
+            node->charno = current.charno;
             return node;
         }
 
-        if (current->TYPE == TOKEN_INT) return parseINT();
+        if (current.TYPE == TOKEN_INT) return parseINT();
 
-        if (current->TYPE == TOKEN_FLOAT) {
-            AST_NODE *node = new AST_NODE();
+        if (current.TYPE == TOKEN_FLOAT) {
+            AST_NODE *node = newNode();
             node->TYPE = NODE_FLOAT;
-            node->value = &current->value;
-            node->lineno = current->lineno;
-            node->sourceLine = current->sourceLine;
-            node->extra = current->extra;
-            node->charno = current->charno;
+            node->value = tokenText();
+            if (!parseNumber(current.value, node->number.real)) {
+                parserError("Malformed float literal '" + string(current.value) + "'");
+            }
+            node->lineno = current.lineno;
+            node->charno = current.charno;
             proceed(TOKEN_FLOAT);
             return node;
         }
 
-        if (current->TYPE == TOKEN_STRING) {
-            AST_NODE *node = new AST_NODE();
+        if (current.TYPE == TOKEN_STRING) {
+            AST_NODE *node = newNode();
             node->TYPE = NODE_STRING;
-            node->value = &current->value;
+            node->value = tokenText();
             proceed(TOKEN_STRING);
-            node->lineno = current->lineno;
-            node->sourceLine = current->sourceLine;
-            node->extra = current->extra;
-            node->charno = current->charno;
+            node->lineno = current.lineno;
+            node->charno = current.charno;
             return node;
         }
 
-        if (current->TYPE == TOKEN_KEYWORD)
+        if (current.TYPE == TOKEN_KEYWORD)
         {
-            if (current->value == "page") {
-                return parsepage();
-            } else if (current->value == "view") {
-                return parseView(NODE_VIEW);
-            } else if (current->value == "text") {
-                return parseView(NODE_TEXT);
-            } else if (current->value == "true" || current->value == "false") {
-                AST_NODE *node = parseBOOL(NODE_BOOL);
-                proceed(current->TYPE);
-                node->lineno = current->lineno;
-                node->sourceLine = current->sourceLine;
-                node->extra = current->extra;
-                node->charno = current->charno;
-                return node;
-            } else if (current->value == "img") {
-                return parseView(NODE_IMAGE);
-            } else if (current->value == "input") {
-                return parseView(NODE_INPUT);
-            } else if (current->value == "canvas") {
-                return parseView(NODE_CANVAS);
-            } else if (current->value == "to_int") {
-                return parseConversions(NODE_TOINT);
-            } else if (current->value == "to_str") {
-                return parseConversions(NODE_TOSTR);
-            } else if (current->value == "to_float") {
-                return parseConversions(NODE_TOFLOAT);
-            } else if (current->value == "draw") {
-                return parseCtx();
-            } else if (current->value == "Platform") {
-                return parsePlatform();
+            switch (current.keyword) {
+                case KW_PAGE:
+                    return parsepage();
+                case KW_VIEW:
+                    return parseView(NODE_VIEW);
+                case KW_TEXT:
+                    return parseView(NODE_TEXT);
+                case KW_TRUE:
+                case KW_FALSE: {
+                    AST_NODE *node = parseBOOL(NODE_BOOL);
+                    proceed(current.TYPE);
+                    node->lineno = current.lineno;
+                    node->charno = current.charno;
+                    return node;
+                }
+                case KW_IMG:
+                    return parseView(NODE_IMAGE);
+                case KW_INPUT:
+                    return parseView(NODE_INPUT);
+                case KW_CANVAS:
+                    return parseView(NODE_CANVAS);
+                case KW_TO_INT:
+                    return parseConversions(NODE_TOINT);
+                case KW_TO_STR:
+                    return parseConversions(NODE_TOSTR);
+                case KW_TO_FLOAT:
+                    return parseConversions(NODE_TOFLOAT);
+                case KW_DRAW:
+                    return parseCtx();
+                case KW_PLATFORM:
+                    return parsePlatform();
+                default:
+                    break;
             }
         }
 
-        if (current->TYPE == TOKEN_ID) {
-            string *varName = &current->value;
+        if (current.TYPE == TOKEN_ID) {
+            NodeText varName = tokenText();
             proceed(TOKEN_ID);
 
             // check for postfix i++ or i--
-            if (current->TYPE == TOKEN_INCREMENT || current->TYPE == TOKEN_DECREMENT) {
-                string op = current->value;
-                proceed(current->TYPE);
+            if (current.TYPE == TOKEN_INCREMENT || current.TYPE == TOKEN_DECREMENT) {
+                string op(current.value);
+                proceed(current.TYPE);
 
-                AST_NODE *node = new AST_NODE();
+                AST_NODE *node = newNode();
                 node->TYPE = NODE_UNARY_OP;
-                node->value = new string(op);
+                node->value = session->text(op);
 
-                AST_NODE *varNode = new AST_NODE();
+                AST_NODE *varNode = newNode();
                 varNode->TYPE = NODE_VARIABLE;
                 varNode->value = varName;
                 node->CHILD = varNode;
-                node->lineno = current->lineno;
-            node->sourceLine = current->sourceLine;
-            node->extra = current->extra;
-            node->charno = current->charno;
+                node->lineno = current.lineno;
+            node->charno = current.charno;
                 return node;
             }
 
-            if (current->TYPE == TOKEN_LPAREN)
+            if (current.TYPE == TOKEN_LPAREN)
             {
                 return parseFunctionCall(varName);
             }
             
 
-            AST_NODE *node = new AST_NODE();
+            AST_NODE *node = newNode();
             node->TYPE = NODE_VARIABLE;
             node->value = varName;
-            node->lineno = current->lineno;
-            node->sourceLine = current->sourceLine;
-            node->extra = current->extra;
-            node->charno = current->charno;
+            node->lineno = current.lineno;
+            node->charno = current.charno;
             return node;
         }
         
 
-        if (current->TYPE == TOKEN_LPAREN) {
+        if (current.TYPE == TOKEN_LPAREN) {
             proceed(TOKEN_LPAREN);
             AST_NODE *expr = parseExpression();
             proceed(TOKEN_RPAREN);
             return expr;
         }
 
-        parserError("Unexpected token in factor: " + current->value);
+        parserError("Unexpected token in factor: " + string(current.value));
         return nullptr;
     }
 
-    AST_NODE *Parser::parseTerm() {
+    // Binary operators by token type. Every tier is left-associative, so a chain of
+    // one tier is built in a single loop and only a tighter operator recurses.
+    struct BinaryOperator {
+        Precedence precedence;
+        NODE_TYPE node;
+    };
+
+    static constexpr array<BinaryOperator, TOKEN_EOF + 1> binaryOperators = [] {
+        array<BinaryOperator, TOKEN_EOF + 1> table{};
+        for (BinaryOperator &op : table) op = {PREC_NONE, NODE_BINARY_OP};
+        table[TOKEN_EQOP] = table[TOKEN_NEQOP] = table[TOKEN_NOTOP] = {PREC_COMPARISON, NODE_BOOL};
+        table[TOKEN_GT] = table[TOKEN_LT] = table[TOKEN_GTE] = table[TOKEN_LTE] = {PREC_COMPARISON, NODE_BOOL};
+        table[TOKEN_PLUSOP] = table[TOKEN_MINUSOP] = {PREC_ADDITIVE, NODE_BINARY_OP};
+        table[TOKEN_MULOP] = table[TOKEN_DIVOP] = {PREC_MULTIPLICATIVE, NODE_BINARY_OP};
+        return table;
+    }();
+
+    AST_NODE *Parser::parseBinary(Precedence minPrecedence) {
         AST_NODE *node = parseFactor();
-        while (current->value == "*" || current->value == "/") {
-            string op = current->value;
-            proceed(current->TYPE);
-            AST_NODE *right = parseFactor();
-            AST_NODE *newNode = new AST_NODE();
-            newNode->TYPE = NODE_BINARY_OP;
-            newNode->value = new string(op);
-            newNode->SUB_STATEMENTS = {node, right};
-            node = newNode;
+        for (;;) {
+            const BinaryOperator &op = binaryOperators[current.TYPE];
+            if (op.precedence == PREC_NONE || op.precedence < minPrecedence) break;
+
+            NodeText opText = tokenText();
+            proceed(current.TYPE);
+            // the tightest tier takes bare factors; anything else climbs one tier up
+            AST_NODE *right = op.precedence == PREC_MULTIPLICATIVE
+                ? parseFactor()
+                : parseBinary(Precedence(op.precedence + 1));
+            AST_NODE *opNode = newNode();
+            opNode->TYPE = op.node;
+            opNode->value = opText;
+            opNode->SUB_STATEMENTS = {node, right};
+            node = opNode;
         }
-        node->lineno = current->lineno;
-            node->sourceLine = current->sourceLine;
-            node->extra = current->extra;
-            node->charno = current->charno;
+        node->lineno = current.lineno;
+        node->charno = current.charno;
         return node;
     }
 
+    AST_NODE *Parser::parseTerm() {
+        return parseBinary(PREC_MULTIPLICATIVE);
+    }
+
     AST_NODE *Parser::parseExpression() {
-        AST_NODE *node = parseTerm();
-        while (current->value == "+" || current->value == "-") {
-            string op = current->value;
-            proceed(current->TYPE);
-            AST_NODE *right = parseTerm();
-            AST_NODE *newNode = new AST_NODE();
-            newNode->TYPE = NODE_BINARY_OP;
-            newNode->value = new string(op);
-            newNode->SUB_STATEMENTS = {node, right};
-            node = newNode;
-        }
-        node->lineno = current->lineno;
-            node->sourceLine = current->sourceLine;
-            node->extra = current->extra;
-            node->charno = current->charno;
-        return node;
+        return parseBinary(PREC_ADDITIVE);
     }
 
     AST_NODE *Parser::parseComparison() {
-        AST_NODE *node = parseExpression();
-        while (
-            current->TYPE == TOKEN_EQOP || current->TYPE == TOKEN_NEQOP ||
-            current->TYPE == TOKEN_GT || current->TYPE == TOKEN_LT ||
-            current->TYPE == TOKEN_GTE || current->TYPE == TOKEN_LTE ||
-            current->TYPE == TOKEN_NOTOP) {
-            string op = current->value;
-            proceed(current->TYPE);
-            AST_NODE *right = parseExpression();
-            AST_NODE *newNode = new AST_NODE();
-            newNode->TYPE = NODE_BOOL;
-            newNode->value = new string(op);
-            newNode->SUB_STATEMENTS = {node, right};
-            node = newNode;
-        }
-        node->lineno = current->lineno;
-            node->sourceLine = current->sourceLine;
-            node->extra = current->extra;
-            node->charno = current->charno;
-        return node;
+        return parseBinary(PREC_COMPARISON);
     }
 
     // ---------- NEW: Parse Increment ----------
     AST_NODE *Parser::parseIncrement() {
-        if (current->TYPE != TOKEN_ID)
+        if (current.TYPE != TOKEN_ID)
             parserError("Expected identifier in increment section");
 
-        string *idName = &current->value;
+        NodeText idName = tokenText();
         proceed(TOKEN_ID);
 
-        AST_NODE *node = new AST_NODE();
+        AST_NODE *node = newNode();
 
-        if (current->TYPE == TOKEN_INCREMENT || current->TYPE == TOKEN_DECREMENT) {
-            string op = current->value;
-            proceed(current->TYPE);
+        if (current.TYPE == TOKEN_INCREMENT || current.TYPE == TOKEN_DECREMENT) {
+            string op(current.value);
+            proceed(current.TYPE);
             node->TYPE = NODE_UNARY_OP;
-            node->value = new string(op);
+            node->value = session->text(op);
 
-            AST_NODE *varNode = new AST_NODE();
+            AST_NODE *varNode = newNode();
             varNode->TYPE = NODE_VARIABLE;
             varNode->value = idName;
             node->CHILD = varNode;
-            node->lineno = current->lineno;
-            node->sourceLine = current->sourceLine;
-            node->extra = current->extra;
-            node->charno = current->charno;
+            node->lineno = current.lineno;
+            node->charno = current.charno;
             return node;
         }
 
-        if (current->TYPE == TOKEN_EQ) {
+        if (current.TYPE == TOKEN_EQ) {
             proceed(TOKEN_EQ);
             AST_NODE *expr = parseComparison();
             node->TYPE = NODE_VARIABLE;
             node->value = idName;
             node->CHILD = expr;
-            node->lineno = current->lineno;
-            node->sourceLine = current->sourceLine;
-            node->extra = current->extra;
-            node->charno = current->charno;
+            node->lineno = current.lineno;
+            node->charno = current.charno;
             return node;
         }
 
@@ -664,29 +698,31 @@ Parser::Parser(vector<Token *> tokens)
 
     // ---------- IF ----------
     AST_NODE *Parser::parseIF() {
-        AST_NODE *ifNode = new AST_NODE();
+        AST_NODE *ifNode = newNode();
         ifNode->TYPE = NODE_IF;
 
-        if (current->TYPE == TOKEN_LPAREN)
+        if (current.TYPE == TOKEN_LPAREN)
             proceed(TOKEN_LPAREN);
 
         ifNode->CHILD = parseComparison();
 
-        if (current->TYPE == TOKEN_RPAREN)
+        if (current.TYPE == TOKEN_RPAREN)
             proceed(TOKEN_RPAREN);
 
         proceed(TOKEN_LBRACE);
 
-        while (current->TYPE != TOKEN_RBRACE && current->TYPE != TOKEN_EOF) {
-            while (current->TYPE == TOKEN_NEWLINE)
+        while (current.TYPE != TOKEN_RBRACE && current.TYPE != TOKEN_EOF) {
+            while (current.TYPE == TOKEN_NEWLINE)
                 proceed(TOKEN_NEWLINE);
 
-            if (current->TYPE == TOKEN_RBRACE)
+            if (current.TYPE == TOKEN_RBRACE)
                 break;
 
-            ifNode->SUB_STATEMENTS.push_back(parseStatement());
+            if (AST_NODE *statement = parseBlockStatement()) {
+                ifNode->SUB_STATEMENTS.push_back(statement);
+            }
 
-            while (current->TYPE == TOKEN_NEWLINE)
+            while (current.TYPE == TOKEN_NEWLINE)
                 proceed(TOKEN_NEWLINE);
         }
         proceed(TOKEN_RBRACE);
@@ -694,56 +730,60 @@ Parser::Parser(vector<Token *> tokens)
             bool endof = false;
             while (endof != true)
             {
-                if (current->value == "else") {
+                if (current.keyword == KW_ELSE) {
                     proceed(TOKEN_KEYWORD);
-                    if (current->value == "if") {
-                        AST_NODE *elseIfNode = new AST_NODE();
+                    if (current.keyword == KW_IF) {
+                        AST_NODE *elseIfNode = newNode();
                         elseIfNode->TYPE = NODE_ELSE_IF;
-                        proceed(current->TYPE);
+                        proceed(current.TYPE);
 
-                        if (current->TYPE == TOKEN_LPAREN) {proceed(TOKEN_LPAREN);}
+                        if (current.TYPE == TOKEN_LPAREN) {proceed(TOKEN_LPAREN);}
                             elseIfNode->CHILD = parseComparison();
-                        if (current->TYPE == TOKEN_RPAREN) { proceed(TOKEN_RPAREN);}
+                        if (current.TYPE == TOKEN_RPAREN) { proceed(TOKEN_RPAREN);}
 
                         proceed(TOKEN_LBRACE);
 
-                        while (current->TYPE != TOKEN_RBRACE && current->TYPE != TOKEN_EOF) {
-                            while (current->TYPE == TOKEN_NEWLINE)
+                        while (current.TYPE != TOKEN_RBRACE && current.TYPE != TOKEN_EOF) {
+                            while (current.TYPE == TOKEN_NEWLINE)
                                 proceed(TOKEN_NEWLINE);
 
-                            if (current->TYPE == TOKEN_RBRACE)
+                            if (current.TYPE == TOKEN_RBRACE)
                                 break;
 
-                            elseIfNode->SUB_STATEMENTS.push_back(parseStatement());
+                            if (AST_NODE *statement = parseBlockStatement()) {
+                                elseIfNode->SUB_STATEMENTS.push_back(statement);
+                            }
 
-                            while (current->TYPE == TOKEN_NEWLINE)
+                            while (current.TYPE == TOKEN_NEWLINE)
                                 proceed(TOKEN_NEWLINE);
                         }
                         proceed(TOKEN_RBRACE);
                         ifNode->SUB_STATEMENTS.push_back(elseIfNode);
 
-                        while (current->TYPE == TOKEN_NEWLINE)
+                        while (current.TYPE == TOKEN_NEWLINE)
                         {
-                            proceed(current->TYPE);
+                            proceed(current.TYPE);
                         }
-                        if (current->value != "else")
+                        if (current.value != "else")
                         {
                         endof = true;
                         }
                     } else {
-                        AST_NODE *elseNode = new AST_NODE();
+                        AST_NODE *elseNode = newNode();
                         elseNode->TYPE = NODE_ELSE;
                         proceed(TOKEN_LBRACE);
-                        while (current->TYPE != TOKEN_RBRACE && current->TYPE != TOKEN_EOF) {   
-                            if (current->TYPE == TOKEN_NEWLINE) {
+                        while (current.TYPE != TOKEN_RBRACE && current.TYPE != TOKEN_EOF) {   
+                            if (current.TYPE == TOKEN_NEWLINE) {
                                 proceed(TOKEN_NEWLINE);
                             }
-                            if (current->TYPE == TOKEN_RBRACE) {
+                            if (current.TYPE == TOKEN_RBRACE) {
                                 proceed(TOKEN_RBRACE);
                                 break;
                             }
 
-                            elseNode->SUB_STATEMENTS.push_back(parseStatement());
+                            if (AST_NODE *statement = parseBlockStatement()) {
+                                elseNode->SUB_STATEMENTS.push_back(statement);
+                            }
                         }
                         ifNode->SUB_STATEMENTS.push_back(elseNode);
                         endof = true;
@@ -754,10 +794,8 @@ Parser::Parser(vector<Token *> tokens)
             }
         
 
-        ifNode->lineno = current->lineno;
-            ifNode->sourceLine = current->sourceLine;
-            ifNode->extra = current->extra;
-            ifNode->charno = current->charno;
+        ifNode->lineno = current.lineno;
+            ifNode->charno = current.charno;
         return ifNode;
     }
 
@@ -768,33 +806,33 @@ Parser::Parser(vector<Token *> tokens)
 
     // ---------- WHILE ----------
     AST_NODE *Parser::parseWhile() {
-        AST_NODE *whileNode = new AST_NODE();
+        AST_NODE *whileNode = newNode();
         whileNode->TYPE = NODE_WHILE;
-        whileNode->charno = current->charno;
-        whileNode->lineno = current->lineno;
-        whileNode->sourceLine = current->sourceLine;
-        whileNode->extra = current->extra;
+        whileNode->charno = current.charno;
+        whileNode->lineno = current.lineno;
         proceed(TOKEN_KEYWORD);
 
-        if (current->TYPE == TOKEN_LPAREN)
+        if (current.TYPE == TOKEN_LPAREN)
             proceed(TOKEN_LPAREN);
 
         whileNode->CHILD = parseComparison();
 
-        if (current->TYPE == TOKEN_RPAREN)
+        if (current.TYPE == TOKEN_RPAREN)
             proceed(TOKEN_RPAREN);
 
         proceed(TOKEN_LBRACE);
-        while (current->TYPE != TOKEN_RBRACE && current->TYPE != TOKEN_EOF) {        
-            while (current->TYPE == TOKEN_NEWLINE)
+        while (current.TYPE != TOKEN_RBRACE && current.TYPE != TOKEN_EOF) {        
+            while (current.TYPE == TOKEN_NEWLINE)
                 proceed(TOKEN_NEWLINE);
 
-            if (current->TYPE == TOKEN_RBRACE)
+            if (current.TYPE == TOKEN_RBRACE)
                 break;
 
-            whileNode->SUB_STATEMENTS.push_back(parseStatement());
+            if (AST_NODE *statement = parseBlockStatement()) {
+                whileNode->SUB_STATEMENTS.push_back(statement);
+            }
 
-            while (current->TYPE == TOKEN_NEWLINE)
+            while (current.TYPE == TOKEN_NEWLINE)
                 proceed(TOKEN_NEWLINE);
         }
         proceed(TOKEN_RBRACE);
@@ -804,30 +842,26 @@ Parser::Parser(vector<Token *> tokens)
 
     // ---------- FOR ----------
     AST_NODE *Parser::parseFor() {
-        AST_NODE *forNode = new AST_NODE();
+        AST_NODE *forNode = newNode();
         forNode->TYPE = NODE_FOR;
-        forNode->charno = current->charno;
-        forNode->lineno = current->lineno;
-        forNode->sourceLine = current->sourceLine;
-        forNode->extra = current->extra;
+        forNode->charno = current.charno;
+        forNode->lineno = current.lineno;
 
         proceed(TOKEN_KEYWORD);
 
         bool paran = false;
 
-        if (current->TYPE == TOKEN_LPAREN)
+        if (current.TYPE == TOKEN_LPAREN)
             paran = true;
             proceed(TOKEN_LPAREN);
 
-        AST_NODE *argsNode = new AST_NODE;
+        AST_NODE *argsNode = newNode();
         argsNode->TYPE = NODE_ARGS;
-        argsNode->charno = current->charno;
-        argsNode->extra = current->extra;
-        argsNode->lineno = current->lineno;
-        argsNode->sourceLine = current->sourceLine;
+        argsNode->charno = current.charno;
+        argsNode->lineno = current.lineno;
         // init
-        AST_NODE *initNode = new AST_NODE;
-        if (current->TYPE == TOKEN_ID)
+        AST_NODE *initNode = newNode();
+        if (current.TYPE == TOKEN_ID)
             initNode = parseID();
         else
             parserError("Expected initialization in for-loop");
@@ -852,16 +886,18 @@ Parser::Parser(vector<Token *> tokens)
 
         // body
         proceed(TOKEN_LBRACE);
-        while (current->TYPE != TOKEN_RBRACE && current->TYPE != TOKEN_EOF) {
-            while (current->TYPE == TOKEN_NEWLINE)
+        while (current.TYPE != TOKEN_RBRACE && current.TYPE != TOKEN_EOF) {
+            while (current.TYPE == TOKEN_NEWLINE)
                 proceed(TOKEN_NEWLINE);
 
-            if (current->TYPE == TOKEN_RBRACE)
+            if (current.TYPE == TOKEN_RBRACE)
                 break;
 
-            forNode->SUB_STATEMENTS.push_back(parseStatement());
+            if (AST_NODE *statement = parseBlockStatement()) {
+                forNode->SUB_STATEMENTS.push_back(statement);
+            }
 
-            while (current->TYPE == TOKEN_NEWLINE)
+            while (current.TYPE == TOKEN_NEWLINE)
                 proceed(TOKEN_NEWLINE);
         }
         proceed(TOKEN_RBRACE);
@@ -870,31 +906,27 @@ Parser::Parser(vector<Token *> tokens)
     }
 
     AST_NODE *Parser::parseBOOL(enum NODE_TYPE Tokentype) {
-        AST_NODE *node = new AST_NODE();
+        AST_NODE *node = newNode();
             node->TYPE = Tokentype;
-            node->value = new string(current->value);
-            node->charno = current->charno;
-            node->charno = current->charno;
-            node->lineno = current->lineno;
-            node->sourceLine = current->sourceLine;
-            node->extra = current->extra;
+            node->value = session->text(current.value);
+            node->charno = current.charno;
+            node->charno = current.charno;
+            node->lineno = current.lineno;
             return node;
     }
 
 
      // ---------- FUNCTION CALL ----------
-    AST_NODE *Parser::parseFunctionCall(string *funcName, NODE_TYPE tyPE) {
-        AST_NODE *callNode = new AST_NODE();
+    AST_NODE *Parser::parseFunctionCall(NodeText funcName, NODE_TYPE tyPE) {
+        AST_NODE *callNode = newNode();
         callNode->TYPE = tyPE;
         callNode->value = funcName;
-        callNode->lineno = current->lineno;
-        callNode->sourceLine = current->sourceLine;
-        callNode->extra = current->extra;
-        callNode->charno = current->charno;
+        callNode->lineno = current.lineno;
+        callNode->charno = current.charno;
         proceed(TOKEN_LPAREN);
-        if (current->TYPE != TOKEN_RPAREN) {
+        if (current.TYPE != TOKEN_RPAREN) {
             callNode->SUB_STATEMENTS.push_back(parseExpression());
-            while (current->TYPE == TOKEN_COMMA) {
+            while (current.TYPE == TOKEN_COMMA) {
                 proceed(TOKEN_COMMA);
                 callNode->SUB_STATEMENTS.push_back(parseExpression());
             }
@@ -904,53 +936,47 @@ Parser::Parser(vector<Token *> tokens)
     }
     
     // ---------- FUNCTION DECLARATION ----------
-    AST_NODE *Parser::parseFunctionDecl(bool callback, string *funcname, int *noargs) {
-       AST_NODE *funcNode = new AST_NODE();
+    AST_NODE *Parser::parseFunctionDecl(bool callback, NodeText funcname, int *noargs) {
+       AST_NODE *funcNode = newNode();
        funcNode->TYPE = NODE_FUNCTION_DECL;
         if (!callback) {
              proceed(TOKEN_KEYWORD); // "def"
-            if (current->TYPE != TOKEN_ID) {
+            if (current.TYPE != TOKEN_ID) {
                 parserError("Expected function name after 'def'"); 
             }
-            string *funcName = &current->value;
+            NodeText funcName = tokenText();
             proceed(TOKEN_ID);  
             funcNode->value = funcName;
         } else {
         funcNode->value = funcname;
-        funcNode->lineno = current->lineno;
-            funcNode->sourceLine = current->sourceLine;
-            funcNode->extra = current->extra;
-            funcNode->charno = current->charno; 
+        funcNode->lineno = current.lineno;
+            funcNode->charno = current.charno; 
         }        
 
         proceed(TOKEN_LPAREN);
-        AST_NODE *args = new AST_NODE();
+        AST_NODE *args = newNode();
         args->TYPE = NODE_ARGS;
 
         int foundargs = 0;
-        if (current->TYPE != TOKEN_RPAREN) {
-            if (*(noargs) == 0) {
+        if (current.TYPE != TOKEN_RPAREN) {
+            if (noargs != NULL && *(noargs) == 0) {
                 parserError("Function '" + *(funcname) + "' doesnt require args");
             }
-            AST_NODE *param = new AST_NODE();
+            AST_NODE *param = newNode();
             param->TYPE = NODE_VARIABLE;
-            param->value = &current->value;
-            param->lineno = current->lineno;
-            param->sourceLine = current->sourceLine;
-            param->extra = current->extra;
-            param->charno = current->charno;
+            param->value = tokenText();
+            param->lineno = current.lineno;
+            param->charno = current.charno;
             proceed(TOKEN_ID);
             args->SUB_STATEMENTS.push_back(param);
             foundargs += 1;
-            while (current->TYPE == TOKEN_COMMA) {
+            while (current.TYPE == TOKEN_COMMA) {
                 proceed(TOKEN_COMMA);
-                AST_NODE *param = new AST_NODE();
+                AST_NODE *param = newNode();
                 param->TYPE = NODE_VARIABLE;
-                param->value = &current->value;
-                param->lineno = current->lineno;
-                param->sourceLine = current->sourceLine;
-                param->extra = current->extra;
-                param->charno = current->charno;
+                param->value = tokenText();
+                param->lineno = current.lineno;
+                param->charno = current.charno;
                 proceed(TOKEN_ID);
                 args->SUB_STATEMENTS.push_back(param);
                 foundargs += 1;
@@ -967,28 +993,28 @@ Parser::Parser(vector<Token *> tokens)
         // Parse function body
         proceed(TOKEN_LBRACE);
         
-        while (current->TYPE != TOKEN_RBRACE && current->TYPE != TOKEN_EOF) {
-            while (current->TYPE == TOKEN_NEWLINE)
+        while (current.TYPE != TOKEN_RBRACE && current.TYPE != TOKEN_EOF) {
+            while (current.TYPE == TOKEN_NEWLINE)
                 proceed(TOKEN_NEWLINE);
 
-            if (current->TYPE == TOKEN_RBRACE)
+            if (current.TYPE == TOKEN_RBRACE)
                 break;
             
-            if (current->TYPE == TOKEN_KEYWORD) {
-                // || current->value != "true" || current->value != "false"
-                if (current->value == "continue")
+            if (current.TYPE == TOKEN_KEYWORD) {
+                // || current.value != "true" || current.value != "false"
+                if (current.keyword == KW_CONTINUE)
                 {
-                    parserError("Unexpected Keyword in Function declaration : "+ current->value);
+                    parserError("Unexpected Keyword in Function declaration : "+ string(current.value));
                 }
-                if (current->value == "return")
+                if (current.keyword == KW_RETURN)
                 {
                     if (callback) {
                         parserError("Callbacks cannot have 'return' statements.");
                     }
                     funcNode->SUB_STATEMENTS.push_back(parseKEYWORDS());
-                    while (current->TYPE == TOKEN_NEWLINE)
+                    while (current.TYPE == TOKEN_NEWLINE)
                         proceed(TOKEN_NEWLINE);
-                    if (current->TYPE != TOKEN_RBRACE && current->TYPE != TOKEN_EOF && current->TYPE != TOKEN_NEWLINE)
+                    if (current.TYPE != TOKEN_RBRACE && current.TYPE != TOKEN_EOF && current.TYPE != TOKEN_NEWLINE)
                     {
                         parserError("'return' statement found in function '" + *funcNode->value + "'. All code after 'return' is unreachable.");
                     } else {
@@ -997,9 +1023,11 @@ Parser::Parser(vector<Token *> tokens)
                    
                 }
             }
-            funcNode->SUB_STATEMENTS.push_back(parseStatement());
+            if (AST_NODE *statement = parseBlockStatement()) {
+                funcNode->SUB_STATEMENTS.push_back(statement);
+            }
 
-            while (current->TYPE == TOKEN_NEWLINE)
+            while (current.TYPE == TOKEN_NEWLINE)
                 proceed(TOKEN_NEWLINE);
         }
         proceed(TOKEN_RBRACE);
@@ -1009,23 +1037,21 @@ Parser::Parser(vector<Token *> tokens)
 
     AST_NODE *Parser::parsePageParam() {
         // Allowed parameters
-                if (current->value != "style" &&
-                    current->value != "route" &&
-                    current->value != "id" &&
-                    current->value != "cls") 
+                if (current.value != "style" &&
+                    current.value != "route" &&
+                    current.value != "id" &&
+                    current.value != "cls") 
                 {
-                    parserError("Expecting one of: 'id', 'cls', 'style', 'route' but got: " + current->value);
+                    parserError("Expecting one of: 'id', 'cls', 'style', 'route' but got: " + string(current.value));
                 }
 
-                AST_NODE *param = new AST_NODE();
+                AST_NODE *param = newNode();
                 param->TYPE = NODE_VARIABLE;
-                param->value = &current->value;
-                param->lineno = current->lineno;
-                param->sourceLine = current->sourceLine;
-                param->extra = current->extra;
-                param->charno = current->charno;
+                param->value = tokenText();
+                param->lineno = current.lineno;
+                param->charno = current.charno;
 
-                std::string paramName = current->value;
+                std::string paramName(current.value);
                 proceed(TOKEN_ID);
                 proceed(TOKEN_EQ);
 
@@ -1039,56 +1065,50 @@ Parser::Parser(vector<Token *> tokens)
                 }
                 else if (paramName == "route") {
                     // route must be string only
-                    for (unsigned char ch : current->value) {
+                    for (unsigned char ch : current.value) {
                         if (isspace(ch)) {
-                            parserError("Spaces not allowed in route: " + current->value);
+                            parserError("Spaces not allowed in route: " + string(current.value));
                         }
                     }
-                    if (current->TYPE != TOKEN_STRING) {
+                    if (current.TYPE != TOKEN_STRING) {
                         parserError("Route expects a string literal");
                     }
-                    if (current->value.empty()) {
+                    if (current.value.empty()) {
                         parserError("Route cannot be an empty string");
                     }
 
-                    string fixroute = current->value;
+                    NodeText fixroute = tokenText();
                     char fwdr = '/';
-                    if(current->value[0] != fwdr) {
+                    if((*fixroute)[0] != fwdr) {
                         
                         std::string charToString(1, fwdr);
-                        current->value = charToString+current->value;
+                        *fixroute = charToString+*fixroute;
                     }
-                    AST_NODE *routeNode = new AST_NODE();
+                    AST_NODE *routeNode = newNode();
                     routeNode->TYPE = NODE_STRING;
-                    routeNode->value = &current->value;
-                    routeNode->lineno = current->lineno;
-                    routeNode->sourceLine = current->sourceLine;
-                    routeNode->extra = current->extra;
-                    routeNode->charno = current->charno;
+                    routeNode->value = fixroute;
+                    routeNode->lineno = current.lineno;
+                    routeNode->charno = current.charno;
                     param->CHILD = routeNode;
                     proceed(TOKEN_STRING);
                 }
                 else if (paramName == "id" || paramName == "cls") {
                     // id or cls can be identifier or string
-                    AST_NODE *valNode = new AST_NODE();
+                    AST_NODE *valNode = newNode();
 
-                    if (current->TYPE == TOKEN_ID) {
+                    if (current.TYPE == TOKEN_ID) {
                         valNode->TYPE = NODE_VARIABLE;
-                        valNode->value = &current->value;
-                        valNode->lineno = current->lineno;
-                        valNode->sourceLine = current->sourceLine;
-                        valNode->extra = current->extra;
-                        valNode->charno = current->charno;
+                        valNode->value = tokenText();
+                        valNode->lineno = current.lineno;
+                        valNode->charno = current.charno;
                         param->CHILD = valNode;
                         proceed(TOKEN_ID);
                     }
-                    else if (current->TYPE == TOKEN_STRING) {
+                    else if (current.TYPE == TOKEN_STRING) {
                         valNode->TYPE = NODE_STRING;
-                        valNode->value = &current->value;
-                        valNode->lineno = current->lineno;
-                        valNode->sourceLine = current->sourceLine;
-                        valNode->extra = current->extra;
-                        valNode->charno = current->charno;
+                        valNode->value = tokenText();
+                        valNode->lineno = current.lineno;
+                        valNode->charno = current.charno;
                         param->CHILD = valNode;
                         proceed(TOKEN_STRING);
                     }
@@ -1099,61 +1119,55 @@ Parser::Parser(vector<Token *> tokens)
         return param;
     }
     AST_NODE *Parser::parsepage() {
-        string *funcName = &current->value;
+        NodeText funcName = tokenText();
         proceed(TOKEN_KEYWORD); // "page"
         
-        AST_NODE *funcNode = new AST_NODE();
+        AST_NODE *funcNode = newNode();
         funcNode->TYPE = NODE_page;
         funcNode->value = funcName;
 
         proceed(TOKEN_LPAREN);
-        if (current->TYPE != TOKEN_RPAREN) {
-            AST_NODE *args = new AST_NODE();
+        if (current.TYPE != TOKEN_RPAREN) {
+            AST_NODE *args = newNode();
             args->TYPE = NODE_ARGS;
 
-            AST_NODE *param = new AST_NODE();
-            if (current->TYPE == TOKEN_STRING || current->TYPE == TOKEN_ID)
+            AST_NODE *param = newNode();
+            if (current.TYPE == TOKEN_STRING || current.TYPE == TOKEN_ID)
             {
-                if (current->TYPE == TOKEN_STRING)
+                if (current.TYPE == TOKEN_STRING)
                 {
                     param->TYPE = NODE_STRING;
-                    param->value = &current->value;
-                    param->lineno = current->lineno;
-                    param->sourceLine = current->sourceLine;
-                    param->extra = current->extra;
-                    param->charno = current->charno;
+                    param->value = tokenText();
+                    param->lineno = current.lineno;
+                    param->charno = current.charno;
                     proceed(TOKEN_STRING);
                     args->SUB_STATEMENTS.push_back(param);
                 }
-                if (current->TYPE == TOKEN_ID)
+                if (current.TYPE == TOKEN_ID)
                 {
-                    if (current->value == "style" || current->value == "route" || current->value == "id" || current->value == "cls") {
+                    if (current.value == "style" || current.value == "route" || current.value == "id" || current.value == "cls") {
                         param->TYPE = NODE_STRING;
-                        param->value = new string("Create Helios App");
-                        param->lineno = current->lineno;
-                        param->sourceLine = current->sourceLine;
-                        param->extra = current->extra;
-                        param->charno = current->charno;
+                        param->value = session->text("Create Helios App");
+                        param->lineno = current.lineno;
+                        param->charno = current.charno;
                         AST_NODE *pageparam = parsePageParam();
                         args->SUB_STATEMENTS.push_back(param);
                         args->SUB_STATEMENTS.push_back(pageparam);
                     } else {
                         param->TYPE = NODE_VARIABLE;
-                        param->value = &current->value;
-                        param->lineno = current->lineno;
-                        param->sourceLine = current->sourceLine;
-                        param->extra = current->extra;
-                        param->charno = current->charno;
+                        param->value = tokenText();
+                        param->lineno = current.lineno;
+                        param->charno = current.charno;
                         proceed(TOKEN_ID);
                         args->SUB_STATEMENTS.push_back(param);
                     }   
                 }
             } else {
-                parserError("Unexpected in page Call : "+ current->value);
+                parserError("Unexpected in page Call : "+ string(current.value));
             }
             
 
-           while (current->TYPE == TOKEN_COMMA) {
+           while (current.TYPE == TOKEN_COMMA) {
                 proceed(TOKEN_COMMA);
 
                 AST_NODE *param = parsePageParam();
@@ -1169,71 +1183,65 @@ Parser::Parser(vector<Token *> tokens)
 
         // Parse function body
         proceed(TOKEN_LBRACE);
-        while (current->TYPE != TOKEN_RBRACE && current->TYPE != TOKEN_EOF) {
-            while (current->TYPE == TOKEN_NEWLINE)
+        while (current.TYPE != TOKEN_RBRACE && current.TYPE != TOKEN_EOF) {
+            while (current.TYPE == TOKEN_NEWLINE)
                 proceed(TOKEN_NEWLINE);
 
-            if (current->TYPE == TOKEN_RBRACE)
+            if (current.TYPE == TOKEN_RBRACE)
                 break;
-            funcNode->SUB_STATEMENTS.push_back(parseStatement(true));
+            if (AST_NODE *statement = parseBlockStatement(true)) {
+                funcNode->SUB_STATEMENTS.push_back(statement);
+            }
 
-            while (current->TYPE == TOKEN_NEWLINE)
+            while (current.TYPE == TOKEN_NEWLINE)
                 proceed(TOKEN_NEWLINE);
         }
         proceed(TOKEN_RBRACE);
-        funcNode->lineno = current->lineno;
-            funcNode->sourceLine = current->sourceLine;
-           funcNode->extra = current->extra;
-            funcNode->charno = current->charno;
+        funcNode->lineno = current.lineno;
+            funcNode->charno = current.charno;
         return funcNode;
     }
 
     AST_NODE *Parser::parseView(enum NODE_TYPE typw) {
-        string *funcName = &current->value;
+        NodeText funcName = tokenText();
         proceed(TOKEN_KEYWORD); // "View"
         
-        AST_NODE *funcNode = new AST_NODE();
+        AST_NODE *funcNode = newNode();
         funcNode->TYPE = typw;
         funcNode->value = funcName;
-        funcNode->lineno = current->lineno;
-            funcNode->sourceLine = current->sourceLine;
-           funcNode->extra = current->extra;
-            funcNode->charno = current->charno;
+        funcNode->lineno = current.lineno;
+            funcNode->charno = current.charno;
 
         proceed(TOKEN_LPAREN);
-        if (current->TYPE == TOKEN_RPAREN) {
+        if (current.TYPE == TOKEN_RPAREN) {
             parserError("One Argument Required!");
         }
-        if (current->TYPE != TOKEN_RPAREN) {
-            AST_NODE *args = new AST_NODE();
+        if (current.TYPE != TOKEN_RPAREN) {
+            AST_NODE *args = newNode();
             args->TYPE = NODE_ARGS;
 
-            AST_NODE *param = new AST_NODE();
-            if (current->TYPE == TOKEN_STRING || current->TYPE == TOKEN_ID)
+            AST_NODE *param = newNode();
+            if (current.TYPE == TOKEN_STRING || current.TYPE == TOKEN_ID)
             {
-                if (current->TYPE == TOKEN_STRING)
+                if (current.TYPE == TOKEN_STRING)
                 {
                     param->TYPE = NODE_STRING;
-                    param->value = &current->value;
-                    param->lineno = current->lineno;
-            param->sourceLine = current->sourceLine;
-           param->extra = current->extra;
-            param->charno = current->charno;
+                    param->value = tokenText();
+                    param->lineno = current.lineno;
+            param->charno = current.charno;
                     proceed(TOKEN_STRING);
                 }
-                if (current->TYPE == TOKEN_ID)
+                if (current.TYPE == TOKEN_ID)
                 {
                     param->TYPE = NODE_VARIABLE;
-                    param->value = &current->value;
-                    param->lineno = current->lineno;
-            param->sourceLine = current->sourceLine;
-           param->extra = current->extra;
-            param->charno = current->charno;
+                    param->value = tokenText();
+                    param->lineno = current.lineno;
+            param->charno = current.charno;
                     proceed(TOKEN_ID);
                 }
                 
             } else {
-                parserError("Unexpected in" + nodetostr(typw) +"() : "+ current->value);
+                parserError("Unexpected in" + nodetostr(typw) +"() : "+ string(current.value));
             }
 
 
@@ -1241,36 +1249,32 @@ Parser::Parser(vector<Token *> tokens)
             bool h = false;
             bool w = false;
 
-           while (current->TYPE == TOKEN_COMMA) {
+           while (current.TYPE == TOKEN_COMMA) {
                 proceed(TOKEN_COMMA);
 
                 // Only allow certain parameter names
-                std::string paramName = current->value;
-                string* parammem = &current->value;
+                std::string paramName(current.value);
+                NodeText parammem = tokenText();
                 if (paramName != "style" && paramName != "cls" && paramName != "onclick" && paramName != "onlongpress" && paramName != "id" && paramName != "height" && paramName != "width") {
                     parserError("Unexpected parameter: " + paramName);
                 }
-                AST_NODE *param = new AST_NODE();
+                AST_NODE *param = newNode();
                 param->TYPE = NODE_VARIABLE;
-                param->value = &current->value;
-                param->lineno = current->lineno;
-                param->sourceLine = current->sourceLine;
-                param->extra = current->extra;
-                param->charno = current->charno;
+                param->value = tokenText();
+                param->lineno = current.lineno;
+                param->charno = current.charno;
 
                 proceed(TOKEN_ID);
                 proceed(TOKEN_EQ);
 
                 if (paramName == "style") {
                     // style can be a dict or identifier
-                    if (current->TYPE == TOKEN_ID) {
-                        AST_NODE *idnode = new AST_NODE();
+                    if (current.TYPE == TOKEN_ID) {
+                        AST_NODE *idnode = newNode();
                         idnode->TYPE = NODE_VARIABLE;
-                        idnode->value = &current->value;
-                        idnode->lineno = current->lineno;
-                        idnode->sourceLine = current->sourceLine;
-                        idnode->extra = current->extra;
-                        idnode->charno = current->charno;
+                        idnode->value = tokenText();
+                        idnode->lineno = current.lineno;
+                        idnode->charno = current.charno;
                         param->CHILD = idnode;
                         proceed(TOKEN_ID);
                     } else {
@@ -1279,22 +1283,20 @@ Parser::Parser(vector<Token *> tokens)
                 } 
                 else if (paramName == "cls") {
                     // cls can be string or identifier
-                    AST_NODE *clsNode = new AST_NODE();
-                    if (current->TYPE == TOKEN_STRING) {
+                    AST_NODE *clsNode = newNode();
+                    if (current.TYPE == TOKEN_STRING) {
                         clsNode->TYPE = NODE_STRING;
-                        clsNode->value = &current->value;
+                        clsNode->value = tokenText();
                         proceed(TOKEN_STRING);
-                    } else if (current->TYPE == TOKEN_ID) {
+                    } else if (current.TYPE == TOKEN_ID) {
                         clsNode->TYPE = NODE_VARIABLE;
-                        clsNode->value = &current->value;
+                        clsNode->value = tokenText();
                         proceed(TOKEN_ID);
                     } else {
                         parserError("cls must be a string or identifier");
                     }
-                    clsNode->lineno = current->lineno;
-                    clsNode->sourceLine = current->sourceLine;
-                    clsNode->extra = current->extra;
-                    clsNode->charno = current->charno;
+                    clsNode->lineno = current.lineno;
+                    clsNode->charno = current.charno;
                     param->CHILD = clsNode;
                 }else if (paramName == "id") {
                     if (typw == NODE_VIEW)
@@ -1303,68 +1305,60 @@ Parser::Parser(vector<Token *> tokens)
                     }
                     
                     // cls can be string or identifier
-                    AST_NODE *clsNode = new AST_NODE();
-                    if (current->TYPE == TOKEN_STRING) {
+                    AST_NODE *clsNode = newNode();
+                    if (current.TYPE == TOKEN_STRING) {
                         clsNode->TYPE = NODE_STRING;
-                        clsNode->value = &current->value;
+                        clsNode->value = tokenText();
                         proceed(TOKEN_STRING);
-                    } else if (current->TYPE == TOKEN_ID) {
+                    } else if (current.TYPE == TOKEN_ID) {
                         clsNode->TYPE = NODE_VARIABLE;
-                        clsNode->value = &current->value;
+                        clsNode->value = tokenText();
                         proceed(TOKEN_ID);
                     } else {
                         parserError("Id must be a string or identifier");
                     }
-                    clsNode->lineno = current->lineno;
-                    clsNode->sourceLine = current->sourceLine;
-                    clsNode->extra = current->extra;
-                    clsNode->charno = current->charno;
+                    clsNode->lineno = current.lineno;
+                    clsNode->charno = current.charno;
                     param->CHILD = clsNode;
                 }  else if (paramName == "onclick" || paramName == "onlongpress") {
                     // onclick / onlongpress can be function identifier or inline function
-                    if (current->TYPE == TOKEN_ID) {
+                    if (current.TYPE == TOKEN_ID) {
                         // function call
-                        string *funcIdent = &current->value;
-                        proceed(current->TYPE);
+                        NodeText funcIdent = tokenText();
+                        proceed(current.TYPE);
                         param->CHILD = parseFunctionCall(funcIdent);
-                    } else if (current->TYPE == TOKEN_KEYWORD && current->value == "def") {
+                    } else if (current.keyword == KW_DEF) {
                         // inline function
                         param->CHILD = parseFunctionDecl();
-                    } else if (current->TYPE == TOKEN_LPAREN) {
+                    } else if (current.TYPE == TOKEN_LPAREN) {
                         // arrow function / anonymous function like () { ... }
-                            AST_NODE * funcNode = new AST_NODE();
+                            AST_NODE * funcNode = newNode();
                             funcNode->TYPE = NODE_FUNCTION_DECL;    
                             funcNode->value = parammem;
-                            funcNode->lineno = current->lineno;
-                            funcNode->sourceLine = current->sourceLine;
-                            funcNode->extra = current->extra;
-                            funcNode->charno = current->charno;
+                            funcNode->lineno = current.lineno;
+                            funcNode->charno = current.charno;
                         
                             proceed(TOKEN_LPAREN);
-                            if (current->TYPE != TOKEN_RPAREN) {
-                                AST_NODE *param = new AST_NODE();
+                            if (current.TYPE != TOKEN_RPAREN) {
+                                AST_NODE *param = newNode();
                                 param->TYPE = NODE_VARIABLE;
-                                param->value = &current->value;
-                                AST_NODE * args = new AST_NODE();
+                                param->value = tokenText();
+                                AST_NODE * args = newNode();
                                 args->TYPE = NODE_ARGS;
-                                args->lineno = current->lineno;
-                                args->sourceLine = current->sourceLine;
-                                args->extra = current->extra;
-                                args->value = &current->value;
-                                args->charno = current->charno;
+                                args->lineno = current.lineno;
+                                args->value = tokenText();
+                                args->charno = current.charno;
                                 funcNode->CHILD = args;
                                 proceed(TOKEN_ID);
                                 funcNode->CHILD->SUB_STATEMENTS.push_back(param);
 
-                                while (current->TYPE == TOKEN_COMMA) {
+                                while (current.TYPE == TOKEN_COMMA) {
                                     proceed(TOKEN_COMMA);
-                                    AST_NODE *param = new AST_NODE();
+                                    AST_NODE *param = newNode();
                                     param->TYPE = NODE_VARIABLE;
-                                    param->value = &current->value;
-                                    param->lineno = current->lineno;
-                                    param->sourceLine = current->sourceLine;
-                                    param->extra = current->extra;
-                                    param->charno = current->charno;
+                                    param->value = tokenText();
+                                    param->lineno = current.lineno;
+                                    param->charno = current.charno;
                                     
                                     proceed(TOKEN_ID);
                                     funcNode->CHILD->SUB_STATEMENTS.push_back(param);
@@ -1374,22 +1368,24 @@ Parser::Parser(vector<Token *> tokens)
 
                             // Parse function body
                             proceed(TOKEN_LBRACE);
-                            while (current->TYPE != TOKEN_RBRACE && current->TYPE != TOKEN_EOF) {
-                                while (current->TYPE == TOKEN_NEWLINE)
+                            while (current.TYPE != TOKEN_RBRACE && current.TYPE != TOKEN_EOF) {
+                                while (current.TYPE == TOKEN_NEWLINE)
                                     proceed(TOKEN_NEWLINE);
 
-                                if (current->TYPE == TOKEN_RBRACE)
+                                if (current.TYPE == TOKEN_RBRACE)
                                     break;
                                 
-                                if (current->TYPE == TOKEN_KEYWORD)
-                                    // || current->value != "true" || current->value != "false"
-                                    if (current->value == "continue")
+                                if (current.TYPE == TOKEN_KEYWORD)
+                                    // || current.value != "true" || current.value != "false"
+                                    if (current.keyword == KW_CONTINUE)
                                     {
-                                        parserError("Unexpected Keyword in Function declaration : "+ current->value);
+                                        parserError("Unexpected Keyword in Function declaration : "+ string(current.value));
                                     }
-                                funcNode->SUB_STATEMENTS.push_back(parseStatement());
+                                if (AST_NODE *statement = parseBlockStatement()) {
+                                    funcNode->SUB_STATEMENTS.push_back(statement);
+                                }
 
-                                while (current->TYPE == TOKEN_NEWLINE)
+                                while (current.TYPE == TOKEN_NEWLINE)
                                     proceed(TOKEN_NEWLINE);
                             }
                             proceed(TOKEN_RBRACE);
@@ -1401,42 +1397,38 @@ Parser::Parser(vector<Token *> tokens)
                 if(nodetostr(typw) == "CANVAS") {
                     if (paramName == "height") {
                         h = true;
-                        AST_NODE *heightNode = new AST_NODE();
-                        if (current->TYPE == TOKEN_INT) {
+                        AST_NODE *heightNode = newNode();
+                        if (current.TYPE == TOKEN_INT) {
                             heightNode->TYPE = NODE_INT;
-                            heightNode->value = &current->value;
+                            heightNode->value = tokenText();
                             proceed(TOKEN_INT);
-                        } else if (current->TYPE == TOKEN_ID) {
+                        } else if (current.TYPE == TOKEN_ID) {
                             heightNode->TYPE = NODE_VARIABLE;
-                            heightNode->value = &current->value;
+                            heightNode->value = tokenText();
                             proceed(TOKEN_ID);
                         } else {
                             parserError("Height must be a Number or identifier");
                         }
-                        heightNode->lineno = current->lineno;
-                        heightNode->sourceLine = current->sourceLine;
-                        heightNode->extra = current->extra;
-                        heightNode->charno = current->charno;
+                        heightNode->lineno = current.lineno;
+                        heightNode->charno = current.charno;
                         param->CHILD = heightNode;
                     }
                     if (paramName == "width") {
                         w = true;
-                        AST_NODE *widthNode = new AST_NODE();
-                        if (current->TYPE == TOKEN_INT) {
+                        AST_NODE *widthNode = newNode();
+                        if (current.TYPE == TOKEN_INT) {
                             widthNode->TYPE = NODE_INT;
-                            widthNode->value = &current->value;
+                            widthNode->value = tokenText();
                             proceed(TOKEN_INT);
-                        } else if (current->TYPE == TOKEN_ID) {
+                        } else if (current.TYPE == TOKEN_ID) {
                             widthNode->TYPE = NODE_VARIABLE;
-                            widthNode->value = &current->value;
+                            widthNode->value = tokenText();
                             proceed(TOKEN_ID);
                         } else {
                             parserError("width must be a Number or identifier");
                         }
-                        widthNode->lineno = current->lineno;
-                        widthNode->sourceLine = current->sourceLine;
-                        widthNode->extra = current->extra;
-                        widthNode->charno = current->charno;
+                        widthNode->lineno = current.lineno;
+                        widthNode->charno = current.charno;
                         param->CHILD = widthNode;
                     }
                 }
@@ -1454,110 +1446,104 @@ Parser::Parser(vector<Token *> tokens)
         proceed(TOKEN_RPAREN);
 
         // Parse function body
-        if(current->TYPE == TOKEN_LBRACE)
+        if(current.TYPE == TOKEN_LBRACE)
         {
             proceed(TOKEN_LBRACE);
-            while (current->TYPE != TOKEN_RBRACE && current->TYPE != TOKEN_EOF) {
-                while (current->TYPE == TOKEN_NEWLINE)
+            while (current.TYPE != TOKEN_RBRACE && current.TYPE != TOKEN_EOF) {
+                while (current.TYPE == TOKEN_NEWLINE)
                     proceed(TOKEN_NEWLINE);
 
-                if (current->TYPE == TOKEN_RBRACE)
+                if (current.TYPE == TOKEN_RBRACE)
                     break;
 
-                funcNode->SUB_STATEMENTS.push_back(parseStatement());
+                if (AST_NODE *statement = parseBlockStatement()) {
+                    funcNode->SUB_STATEMENTS.push_back(statement);
+                }
 
-                while (current->TYPE == TOKEN_NEWLINE)
+                while (current.TYPE == TOKEN_NEWLINE)
                     proceed(TOKEN_NEWLINE);
             }
             proceed(TOKEN_RBRACE);
         } else {
                 proceed(TOKEN_NEWLINE);
         }
-        funcNode->lineno = current->lineno;
-            funcNode->sourceLine = current->sourceLine;
-           funcNode->extra = current->extra;
-            funcNode->charno = current->charno;
+        funcNode->lineno = current.lineno;
+            funcNode->charno = current.charno;
         return funcNode;
     }
 
 
     AST_NODE* Parser::parseStylesheet() {
-        AST_NODE* styleNode = new AST_NODE();
+        AST_NODE* styleNode = newNode();
         styleNode->TYPE = NODE_STYLESHEET;
 
         proceed(TOKEN_KEYWORD); // "stylesheet"
-        if (current->TYPE == TOKEN_ANDSYM) {
-            styleNode->CHILD = new AST_NODE();
+        if (current.TYPE == TOKEN_ANDSYM) {
+            styleNode->CHILD = newNode();
             styleNode->CHILD->TYPE = NODE_BOOL;
-            styleNode->CHILD->value = new string("true");
-            styleNode->CHILD->lineno = current->lineno;
-                styleNode->CHILD->sourceLine = current->sourceLine;
-            styleNode->CHILD->extra = current->extra;
-                styleNode->CHILD->charno = current->charno;
+            styleNode->CHILD->value = session->text("true");
+            styleNode->CHILD->lineno = current.lineno;
+                styleNode->CHILD->charno = current.charno;
             proceed(TOKEN_ANDSYM);
         }
-        if (current->TYPE != TOKEN_ID) {
+        if (current.TYPE != TOKEN_ID) {
             parserError("Expected stylesheet name after 'stylesheet'");
         }
-        styleNode->value = &current->value;
+        styleNode->value = tokenText();
         proceed(TOKEN_ID);
         
         proceed(TOKEN_LBRACE);
 
-        while (current->TYPE != TOKEN_RBRACE && current->TYPE != TOKEN_EOF) {
+        while (current.TYPE != TOKEN_RBRACE && current.TYPE != TOKEN_EOF) {
             // Skip newlines
-            while (current->TYPE == TOKEN_NEWLINE)
+            while (current.TYPE == TOKEN_NEWLINE)
                 proceed(TOKEN_NEWLINE);
 
-            if (current->TYPE == TOKEN_RBRACE)
+            if (current.TYPE == TOKEN_RBRACE)
                 break;
 
             // Top-level identifier
-            if (current->TYPE == TOKEN_ID) {
-                string selector = current->value;
+            if (current.TYPE == TOKEN_ID) {
+                string selector(current.value);
             
 
                 if (selector == "media") {
                     // Media query node
                     proceed(TOKEN_ID);
-                    AST_NODE* mediaNode = new AST_NODE();
+                    AST_NODE* mediaNode = newNode();
                     mediaNode->TYPE = NODE_MEDIA_QUERY;
-                    mediaNode->lineno = current->lineno;
-                    mediaNode->sourceLine = current->sourceLine;
-                    mediaNode->extra = current->extra;
-                    mediaNode->charno = current->charno;
+                    mediaNode->lineno = current.lineno;
+                    mediaNode->charno = current.charno;
 
                     proceed(TOKEN_LPAREN);
                     mediaNode->CHILD = parseComparison(); // the query string
                     proceed(TOKEN_RPAREN);
 
                     proceed(TOKEN_LBRACE);
-                    while (current->TYPE != TOKEN_RBRACE && current->TYPE != TOKEN_EOF) {
-                        while (current->TYPE == TOKEN_NEWLINE)
+                    while (current.TYPE != TOKEN_RBRACE && current.TYPE != TOKEN_EOF) {
+                        while (current.TYPE == TOKEN_NEWLINE)
                             proceed(TOKEN_NEWLINE);
                         
-                        if (current->TYPE == TOKEN_RBRACE)
+                        if (current.TYPE == TOKEN_RBRACE)
                             break;
 
-                        if (current->TYPE == TOKEN_ID) {
-                            AST_NODE* selectorNode = new AST_NODE();
+                        if (current.TYPE == TOKEN_ID) {
+                            AST_NODE* selectorNode = newNode();
                             selectorNode->TYPE = NODE_CLS;
-                            selectorNode->value = &current->value;
-                            selectorNode->lineno = current->lineno;
-                            selectorNode->sourceLine = current->sourceLine;
-                            selectorNode->extra = current->extra;
-                            selectorNode->charno = current->charno;
+                            selectorNode->value = tokenText();
+                            selectorNode->lineno = current.lineno;
+                            selectorNode->charno = current.charno;
 
-                            string innerSelector = current->value;
+                            string innerSelector(current.value);
                             proceed(TOKEN_ID);
                             selectorNode->CHILD = parseDict(true);
 
                             mediaNode->SUB_STATEMENTS.push_back(selectorNode);
                         } else {
-                            parserError("Expected selector identifier inside media query, got: " + current->value);
+                            parserError("Expected selector identifier inside media query, got: " + string(current.value));
                         }
 
-                        while (current->TYPE == TOKEN_NEWLINE)
+                        while (current.TYPE == TOKEN_NEWLINE)
                             proceed(TOKEN_NEWLINE);
                     }
                     proceed(TOKEN_RBRACE);
@@ -1565,27 +1551,25 @@ Parser::Parser(vector<Token *> tokens)
 
                 } else {
                     // Normal selector
-                    AST_NODE* selectorNode = new AST_NODE();
+                    AST_NODE* selectorNode = newNode();
                     selectorNode->TYPE = NODE_CLS;
-                    selectorNode->value = &current->value;
-                    selectorNode->lineno = current->lineno;
-                    selectorNode->sourceLine = current->sourceLine;
-                    selectorNode->extra = current->extra;
-                    selectorNode->charno = current->charno;
+                    selectorNode->value = tokenText();
+                    selectorNode->lineno = current.lineno;
+                    selectorNode->charno = current.charno;
                     proceed(TOKEN_ID);
                     proceed(TOKEN_EQ);
                     selectorNode->CHILD = parseDict(true);
                     styleNode->SUB_STATEMENTS.push_back(selectorNode);
                 }
             } else {
-                parserError("Expected selector or 'media', got: " + current->value);
+                parserError("Expected selector or 'media', got: " + string(current.value));
             }
 
             // Optional comma between selectors
-            if (current->TYPE == TOKEN_COMMA)
+            if (current.TYPE == TOKEN_COMMA)
                 proceed(TOKEN_COMMA);
 
-            while (current->TYPE == TOKEN_NEWLINE)
+            while (current.TYPE == TOKEN_NEWLINE)
                 proceed(TOKEN_NEWLINE);
         }
 
@@ -1594,49 +1578,43 @@ Parser::Parser(vector<Token *> tokens)
     }
 
     AST_NODE *Parser::parseCtx() {
-        proceed(current->TYPE);
-        AST_NODE * ctx = new AST_NODE;
+        proceed(current.TYPE);
+        AST_NODE * ctx = newNode();
         ctx->TYPE = NODE_DRAW;
-        ctx->charno = current->charno;
-        ctx->lineno = current->lineno;
-        ctx->sourceLine = current->sourceLine;
-        ctx->extra = current->extra;
+        ctx->charno = current.charno;
+        ctx->lineno = current.lineno;
         proceed(TOKEN_LPAREN);
-        if (current->TYPE == TOKEN_RPAREN) {
+        if (current.TYPE == TOKEN_RPAREN) {
             parserError("Please Pass An ID");
         }
-        if (current->TYPE != TOKEN_RPAREN) {
-            AST_NODE *args = new AST_NODE();
+        if (current.TYPE != TOKEN_RPAREN) {
+            AST_NODE *args = newNode();
             args->TYPE = NODE_ARGS;
 
-            AST_NODE *param = new AST_NODE();
-            if (current->TYPE == TOKEN_STRING || current->TYPE == TOKEN_ID)
+            AST_NODE *param = newNode();
+            if (current.TYPE == TOKEN_STRING || current.TYPE == TOKEN_ID)
             {
-                if (current->TYPE == TOKEN_STRING)
+                if (current.TYPE == TOKEN_STRING)
                 {
                     param->TYPE = NODE_STRING;
-                    param->value = &current->value;
-                    param->lineno = current->lineno;
-                    param->sourceLine = current->sourceLine;
-                    param->extra = current->extra;
-                    param->charno = current->charno;
+                    param->value = tokenText();
+                    param->lineno = current.lineno;
+                    param->charno = current.charno;
                     proceed(TOKEN_STRING);
                 }
-                if (current->TYPE == TOKEN_ID)
+                if (current.TYPE == TOKEN_ID)
                 {
                     param->TYPE = NODE_VARIABLE;
-                    param->value = &current->value;
-                    param->lineno = current->lineno;
-                    param->sourceLine = current->sourceLine;
-                    param->extra = current->extra;
-                    param->charno = current->charno;
+                    param->value = tokenText();
+                    param->lineno = current.lineno;
+                    param->charno = current.charno;
                     proceed(TOKEN_ID);
                 }
                 args->SUB_STATEMENTS.push_back(param);
                 ctx->CHILD = args;
 
             } else {
-                parserError("Unexpected in Arg Draw() : "+ current->value);
+                parserError("Unexpected in Arg Draw() : "+ string(current.value));
             }
 
         }
@@ -1646,17 +1624,15 @@ Parser::Parser(vector<Token *> tokens)
     }
 
     AST_NODE *Parser::parsePlatform() {
-        proceed(current->TYPE);
-        AST_NODE * ctx = new AST_NODE;
+        proceed(current.TYPE);
+        AST_NODE * ctx = newNode();
         ctx->TYPE = NODE_PLATFORM_CLS;
-        ctx->charno = current->charno;
-        ctx->lineno = current->lineno;
-        ctx->sourceLine = current->sourceLine;
-        ctx->extra = current->extra;
+        ctx->charno = current.charno;
+        ctx->lineno = current.lineno;
         proceed(TOKEN_LPAREN);
         proceed(TOKEN_RPAREN);
-        if (current->TYPE == TOKEN_DOT) {
-            string* buf = new string("platform");
+        if (current.TYPE == TOKEN_DOT) {
+            string* buf = session->text("platform");
             ctx->CHILD= parseInstancecall(buf);
         }
         
@@ -1667,328 +1643,332 @@ Parser::Parser(vector<Token *> tokens)
    
     // ---------- Keyword Dispatcher ----------
     AST_NODE *Parser::parseKEYWORDS() {
-        if (std::find(defined_keywords.begin(), defined_keywords.end(), current->value) != defined_keywords.end())
-        {   
-            return parseBOOL(NODE_BOOL);
-        } else if (std::find(loop_keywords.begin(), loop_keywords.end(), current->value) != loop_keywords.end()) {
-            AST_NODE * newnode = parseBOOL(NODE_LOOP_CTRL);
-            proceed(TOKEN_KEYWORD);
-            return newnode;
-        }
-        else {
-            if (current->value == "return") {
-            proceed(TOKEN_KEYWORD);
-            AST_NODE *node = new AST_NODE();
-            node->TYPE = NODE_RETURN;
-            node->CHILD = parseComparison();
-            node->charno = current->charno;
-            node->lineno = current->lineno;
-            node->sourceLine = current->sourceLine;
-            node->extra = current->extra;
-            return node;
-            } else if (current->value == "print") {
+        switch (current.keyword) {
+            case KW_TRUE:
+            case KW_FALSE: {
+                AST_NODE * newnode = parseBOOL(NODE_BOOL);
+                proceed(TOKEN_KEYWORD);
+                return newnode;
+            }
+            case KW_CONTINUE:
+            case KW_BREAK:
+            case KW_PASS: {
+                AST_NODE * newnode = parseBOOL(NODE_LOOP_CTRL);
+                proceed(TOKEN_KEYWORD);
+                return newnode;
+            }
+            case KW_RETURN: {
+                proceed(TOKEN_KEYWORD);
+                AST_NODE *node = newNode();
+                node->TYPE = NODE_RETURN;
+                node->CHILD = parseComparison();
+                node->charno = current.charno;
+                node->lineno = current.lineno;
+                return node;
+            }
+            case KW_IMPORT: {
+                // import "path/to/file.ink" | import name  (-> name.ink next to this file)
+                AST_NODE *node = newNode();
+                node->TYPE = NODE_IMPORT;
+                node->lineno = current.lineno;
+                node->charno = current.charno;
+                proceed(TOKEN_KEYWORD);
+                if (current.TYPE == TOKEN_STRING) {
+                    node->value = tokenText();
+                    proceed(TOKEN_STRING);
+                } else {
+                    if (current.TYPE != TOKEN_ID) {
+                        parserError("Expected a module name or path after import");
+                    }
+                    node->value = session->text(string(current.value) + ".ink");
+                    proceed(TOKEN_ID);
+                }
+                return node;
+            }
+            case KW_PRINT: {
                 proceed(TOKEN_KEYWORD);
-                AST_NODE *node = new AST_NODE();
+                AST_NODE *node = newNode();
                 node->TYPE = NODE_PRINT;
                 proceed(TOKEN_LPAREN);
                 node->CHILD = parseComparison();
                 proceed(TOKEN_RPAREN);
-                node->charno = current->charno;
-                node->lineno = current->lineno;
-                node->sourceLine = current->sourceLine;
-                node->extra = current->extra;
+                node->charno = current.charno;
+                node->lineno = current.lineno;
                 return node;
-            } else if (current->value == "to_int") {
+            }
+            case KW_TO_INT: {
                 proceed(TOKEN_KEYWORD);
-                AST_NODE *node = new AST_NODE();
+                AST_NODE *node = newNode();
                 node->TYPE = NODE_TOINT;
                 proceed(TOKEN_LPAREN);
                 node->CHILD = parseComparison();
                 proceed(TOKEN_RPAREN);
-                node->charno = current->charno;
-                node->lineno = current->lineno;
-                node->sourceLine = current->sourceLine;
-                node->extra = current->extra;
+                node->charno = current.charno;
+                node->lineno = current.lineno;
                 return node;
-            } else if (current->value == "to_str") {
+            }
+            case KW_TO_STR: {
                 proceed(TOKEN_KEYWORD);
-                AST_NODE *node = new AST_NODE();
+                AST_NODE *node = newNode();
                 node->TYPE = NODE_TOSTR;
                 proceed(TOKEN_LPAREN);
                 node->CHILD = parseComparison();
                 proceed(TOKEN_RPAREN);
-                node->charno = current->charno;
-                node->lineno = current->lineno;
-                node->sourceLine = current->sourceLine;
-                node->extra = current->extra;
+                node->charno = current.charno;
+                node->lineno = current.lineno;
                 return node;
-            } else if (current->value == "to_float") {
+            }
+            case KW_TO_FLOAT: {
                 proceed(TOKEN_KEYWORD);
-                AST_NODE *node = new AST_NODE();
+                AST_NODE *node = newNode();
                 node->TYPE = NODE_TOFLOAT;
                 proceed(TOKEN_LPAREN);
                 node->CHILD = parseComparison();
                 proceed(TOKEN_RPAREN);
-                node->charno = current->charno;
-                node->lineno = current->lineno;
-                node->sourceLine = current->sourceLine;
-                node->extra = current->extra;
+                node->charno = current.charno;
+                node->lineno = current.lineno;
                 return node;
-            } else if (current->value == "sin") {
+            }
+            case KW_SIN: {
                 proceed(TOKEN_KEYWORD);
-                AST_NODE *node = new AST_NODE();
+                AST_NODE *node = newNode();
                 node->TYPE = NODE_MATH_SIN;
                 proceed(TOKEN_LPAREN);
                 node->CHILD = parseComparison();
                 proceed(TOKEN_RPAREN);
-                node->charno = current->charno;
-                node->lineno = current->lineno;
-                node->sourceLine = current->sourceLine;
-                node->extra = current->extra;
+                node->charno = current.charno;
+                node->lineno = current.lineno;
                 return node;
-            } else if (current->value == "cos") {
+            }
+            case KW_COS: {
                 proceed(TOKEN_KEYWORD);
-                AST_NODE *node = new AST_NODE();
+                AST_NODE *node = newNode();
                 node->TYPE = NODE_MATH_COS;
                 proceed(TOKEN_LPAREN);
                 node->CHILD = parseComparison();
                 proceed(TOKEN_RPAREN);
-                node->charno = current->charno;
-                node->lineno = current->lineno;
-                node->sourceLine = current->sourceLine;
-                node->extra = current->extra;
+                node->charno = current.charno;
+                node->lineno = current.lineno;
                 return node;
-            } else if (current->value == "tan") {
+            }
+            case KW_TAN: {
                 proceed(TOKEN_KEYWORD);
-                AST_NODE *node = new AST_NODE();
+                AST_NODE *node = newNode();
                 node->TYPE = NODE_MATH_TAN;
                 proceed(TOKEN_LPAREN);
                 node->CHILD = parseComparison();
                 proceed(TOKEN_RPAREN);
-                node->charno = current->charno;
-                node->lineno = current->lineno;
-                node->sourceLine = current->sourceLine;
-                node->extra = current->extra;
+                node->charno = current.charno;
+                node->lineno = current.lineno;
                 return node;
-            } else if (current->value == "sqrt") {
+            }
+            case KW_SQRT: {
                 proceed(TOKEN_KEYWORD);
-                AST_NODE *node = new AST_NODE();
+                AST_NODE *node = newNode();
                 node->TYPE = NODE_MATH_SQRT;
                 proceed(TOKEN_LPAREN);
                 node->CHILD = parseComparison();
                 proceed(TOKEN_RPAREN);
-                node->charno = current->charno;
-                node->lineno = current->lineno;
-                node->sourceLine = current->sourceLine;
-                node->extra = current->extra;
+                node->charno = current.charno;
+                node->lineno = current.lineno;
                 return node;
-            } else if (current->value == "pow") {
+            }
+            case KW_POW: {
                 proceed(TOKEN_KEYWORD);
-                AST_NODE *node = new AST_NODE();
+                AST_NODE *node = newNode();
                 node->TYPE = NODE_MATH_POW;
                 proceed(TOKEN_LPAREN);
-                AST_NODE *args = new AST_NODE;
+                AST_NODE *args = newNode();
                 args = parseComparison();
-                if (current->TYPE == TOKEN_COMMA) {
+                if (current.TYPE == TOKEN_COMMA) {
                     proceed(TOKEN_COMMA);
                     AST_NODE *arg2 = parseComparison();
                     proceed(TOKEN_RPAREN);
                     node->SUB_STATEMENTS.push_back(args);
                     node->SUB_STATEMENTS.push_back(arg2);
-                    node->charno = current->charno;
-                    node->lineno = current->lineno;
-                    node->sourceLine = current->sourceLine;
-                    node->extra = current->extra;
+                    node->charno = current.charno;
+                    node->lineno = current.lineno;
                     return node;
                 }
                 proceed(TOKEN_RPAREN);
                 node->CHILD = args;
-                node->charno = current->charno;
-                node->lineno = current->lineno;
-                node->sourceLine = current->sourceLine;
-                node->extra = current->extra;
+                node->charno = current.charno;
+                node->lineno = current.lineno;
                 return node;
-            } else if (current->value == "img") {
+            }
+            case KW_IMG:
                 return parseView(NODE_IMAGE);
-            }else if (current->value == "if") {
+            case KW_IF:
                 return parseConditional();
-            } else if (current->value == "while") {
+            case KW_WHILE:
                 return parseWhile();
-            } else if (current->value == "for") {
+            case KW_FOR:
                 return parseFor();
-            } else if (current->value == "type") {
+            case KW_TYPE: {
                 proceed(TOKEN_KEYWORD);
-                AST_NODE *node = new AST_NODE();
+                AST_NODE *node = newNode();
                 node->TYPE = NODE_TYPE_CHECK;
                 proceed(TOKEN_LPAREN);
                 node->CHILD = parseFactor();
                 proceed(TOKEN_RPAREN);
-                node->charno = current->charno;
-                node->lineno = current->lineno;
-                node->sourceLine = current->sourceLine;
-                node->extra = current->extra;
+                node->charno = current.charno;
+                node->lineno = current.lineno;
                 return node;
-            }  else if (current->value == "def") {
+            }
+            case KW_DEF:
                 return parseFunctionDecl();
-            } else if (current->value == "page") {
+            case KW_PAGE:
                 return parsepage();
-            } else if (current->value == "view") {
+            case KW_VIEW:
                 return parseView(NODE_VIEW);
-            } else if (current->value == "text") {
+            case KW_TEXT:
                 return parseView(NODE_TEXT);
-            } else if (current->value == "draw") {
+            case KW_DRAW:
                 return parseCtx();
-            } else if(current->value == "Platform") {
+            case KW_PLATFORM:
                 return parsePlatform();
-            } else if (current->value == "canvas") {
+            case KW_CANVAS:
                 return parseView(NODE_CANVAS);
-            } else if (current->value == "go") {
-                string *funcIdent = &current->value;
-                proceed(current->TYPE);
+            case KW_GO: {
+                NodeText funcIdent = tokenText();
+                proceed(current.TYPE);
                 return parseFunctionCall(funcIdent, NODE_GO);
-            }else {
-                parserError("Unknown keyword: " + current->value);
             }
+            default:
+                parserError("Unknown keyword: " + string(current.value));
         }
         return nullptr;
     }
 
     AST_NODE * Parser::parseState() {
-        AST_NODE * node = new AST_NODE;
+        AST_NODE * node = newNode();
         
         node->TYPE = NODE_SETSTATE;
-        if (current->TYPE != TOKEN_KEYWORD && current->value != "state") {
+        if (current.TYPE != TOKEN_KEYWORD && current.keyword != KW_STATE) {
             parserError("Expected identifier after 'state'");
         }
-        proceed(current->TYPE);
-        string val = current->value;
+        proceed(current.TYPE);
+        string val(current.value);
          proceed(TOKEN_ID);
-         node->value = new string(val);
+         node->value = session->text(val);
         proceed(TOKEN_COLON);
         node->CHILD = parseComparison();
-        node->charno = current->charno;
-         node->lineno = current->lineno;
-            node->sourceLine = current->sourceLine;
-           node->extra = current->extra;
+        node->charno = current.charno;
+         node->lineno = current.lineno;
         
         
         return node;
     }
 
     AST_NODE * Parser::parseSetState() {
-        AST_NODE * node = new AST_NODE;
+        AST_NODE * node = newNode();
         
         node->TYPE = NODE_GETSTATE;
-        if (current->TYPE != TOKEN_ID) {
+        if (current.TYPE != TOKEN_ID) {
             parserError("Expected identifier after 'state'");
         }
 
-        string val = current->value;
+        string val(current.value);
          proceed(TOKEN_ID);
-         node->value = new string(val);
+         node->value = session->text(val);
         proceed(TOKEN_COLON);
         node->CHILD = parseComparison();
-        node->charno = current->charno;
-        node->lineno = current->lineno;
-        node->sourceLine = current->sourceLine;
-        node->extra = current->extra;
+        node->charno = current.charno;
+        node->lineno = current.lineno;
         
         return node;
     }
 
     AST_NODE * Parser::parseAtSym() {
-        AST_NODE * node = new AST_NODE;
-        proceed(current->TYPE);
-        if (current->TYPE == TOKEN_ID) {
+        AST_NODE * node = newNode();
+        proceed(current.TYPE);
+        if (current.TYPE == TOKEN_ID) {
             node = parseSetState();
         }
-        else if (current->TYPE == TOKEN_KEYWORD)
+        else if (current.TYPE == TOKEN_KEYWORD)
         {
             node = parseState();
         } else {
-            parserError("Expected identifier or 'state' after '@', got: " + current->value );
+            parserError("Expected identifier or 'state' after '@', got: " + string(current.value) );
         }
         return node;
     }
 
     // ---------- Generic Statement ----------
     AST_NODE *Parser::parseStatement(bool ispage) {
-        if (current->TYPE == TOKEN_INT || current->TYPE == TOKEN_FLOAT) {
+        if (current.TYPE == TOKEN_INT || current.TYPE == TOKEN_FLOAT) {
             return parseExpression();
         }
-        else if (current->TYPE == TOKEN_ID) {
-            if(current->value == "onmount") {
-                string *funcname = &current->value;
-                proceed(current->TYPE);
+        else if (current.TYPE == TOKEN_ID) {
+            if(current.value == "onmount") {
+                NodeText funcname = tokenText();
+                proceed(current.TYPE);
                 if(!ispage) {
                     parserError("Onmount life cycle can only be defined in a Page ");
                 }
-                int *n = new int;
-                *n = 0;
+                int *n = session->make<int>(0);
                 return parseFunctionDecl(true, funcname, n);
             }
-            // if(current->value == "onresize") {
-            //     string *funcname = &current->value;
-            //     proceed(current->TYPE);
+            // if(current.value == "onresize") {
+            //     NodeText funcname = tokenText();
+            //     proceed(current.TYPE);
             //     if(!ispage) {
             //         parserError("Onresize life cycle can only be defined in a Page ");
             //     }
             //     return parseFunctionDecl(true, funcname);
             // }
-            if(current->value == "animatefps") {
-                string *funcname = &current->value;
-                proceed(current->TYPE);
+            if(current.value == "animatefps") {
+                NodeText funcname = tokenText();
+                proceed(current.TYPE);
                 if(!ispage) {
                     parserError("Onresize life cycle can only be defined in a Page ");
                 }
-                int *n = new int;
-                *n = 0;
+                int *n = session->make<int>(0);
                 return parseFunctionDecl(true, funcname, n);
             }
-            if(current->value == "listener") {
-                string *funcname = &current->value;
-                proceed(current->TYPE);
+            if(current.value == "listener") {
+                NodeText funcname = tokenText();
+                proceed(current.TYPE);
                 if(!ispage) {
                     parserError("Listener life cycle can only be defined in a Page ");
                 }
-                int *n = new int;
-                *n = 1;
+                int *n = session->make<int>(1);
                 return parseFunctionDecl(true, funcname, n);
             }
             
             return parseID();
         }
-        else if (current->TYPE == TOKEN_ATSYM) {
+        else if (current.TYPE == TOKEN_ATSYM) {
             if(ispage == true) {
                 
                 return parseAtSym();
             } else {
-                proceed(current->TYPE);
-                if (current->value == "state") {
+                proceed(current.TYPE);
+                if (current.keyword == KW_STATE) {
                     parserError("State can only be set inside page() functions");
                 } 
-                if (current->value == "stylesheet") {
+                if (current.keyword == KW_STYLESHEET) {
                     return parseStylesheet();
                 }
                 parserError("@ only allows 'state' or 'stylesheet'");
             }
-        } else if (current->TYPE == TOKEN_HASH)
-            {proceed(current->TYPE);
-            while (current->TYPE != TOKEN_NEWLINE)
+        } else if (current.TYPE == TOKEN_HASH)
+            {proceed(current.TYPE);
+            while (current.TYPE != TOKEN_NEWLINE)
             {
-                proceed(current->TYPE);
+                proceed(current.TYPE);
             }
             return nullptr;}
-        else if (current->TYPE == TOKEN_DIVOP){
-            proceed(current->TYPE);
+        else if (current.TYPE == TOKEN_DIVOP){
+            proceed(current.TYPE);
             proceed(TOKEN_MULOP);
             bool endofcomment = false;
-            while (!endofcomment && current->TYPE != TOKEN_EOF)
+            while (!endofcomment && current.TYPE != TOKEN_EOF)
             {
-                if (current->TYPE == TOKEN_MULOP)
+                if (current.TYPE == TOKEN_MULOP)
                 {
                     proceed(TOKEN_MULOP);
-                    if (current->TYPE == TOKEN_DIVOP)
+                    if (current.TYPE == TOKEN_DIVOP)
                     {
                         endofcomment = true;
                         proceed(TOKEN_DIVOP);
@@ -1996,30 +1976,147 @@ Parser::Parser(vector<Token *> tokens)
                     return nullptr;
                 }
                 
-                proceed(current->TYPE);
+                proceed(current.TYPE);
             }
             return nullptr;
-        }else if (current->TYPE == TOKEN_KEYWORD) {
+        }else if (current.TYPE == TOKEN_KEYWORD) {
             return parseKEYWORDS();
         } else {
-            parserError("Unexpected token in statement : " + current->value);
+            parserError("Unexpected token in statement : " + string(current.value));
         }
         return nullptr;
     }
 
     // ---------- Parse Root ----------
-    AST_NODE *Parser::parse() {
-        AST_NODE *ROOT = new AST_NODE();
+    AST_NODE *Parser::parse(IncrementalParser *previous) {
+        AST_NODE *ROOT = newNode();
         ROOT->TYPE = NODE_ROOT;
 
-        while (current->TYPE != TOKEN_EOF) {
-            if (current->TYPE == TOKEN_NEWLINE) {
+        while (current.TYPE != TOKEN_EOF) {
+            if (current.TYPE == TOKEN_NEWLINE) {
                 proceed(TOKEN_NEWLINE);
                 continue;
             }
-            ROOT->SUB_STATEMENTS.push_back(parseStatement());
-            if (current->TYPE == TOKEN_NEWLINE)
+            int start = index;
+            int end;
+            if (previous) {
+                if (AST_NODE *statement = previous->reuse(*parserTokens, start, end)) {
+                    ROOT->SUB_STATEMENTS.push_back(statement);
+                    index = end;
+                    current = parserTokens->at(index);
+                    if (current.TYPE == TOKEN_NEWLINE)
+                        proceed(TOKEN_NEWLINE);
+                    continue;
+                }
+            }
+            size_t reported = session->diagnostics.all().size();
+            if (AST_NODE *statement = parseBlockStatement()) {
+                ROOT->SUB_STATEMENTS.push_back(statement);
+                // the statement's parse read tokens [start, index]: index is its lookahead
+                if (previous && session->diagnostics.all().size() == reported) {
+                    previous->record(*parserTokens, start, index, statement);
+                }
+            }
+            if (current.TYPE == TOKEN_NEWLINE)
                 proceed(TOKEN_NEWLINE);
         }
         return ROOT;
     }
+
+    // Hash of tokens [begin, end]: types, text and offsets relative to the first
+    // token, so the same statement moved to another line hashes the same.
+    static uint64_t fingerprint(const TokenStream &tokens, int begin, int end) {
+        uint64_t hash = 14695981039346656037ull;
+        auto mix = [&hash](const void *data, size_t size) {
+            for (size_t i = 0; i < size; i++) {
+                hash = (hash ^ ((const unsigned char *)data)[i]) * 1099511628211ull;
+            }
+        };
+        uint32_t base = tokens.offsets[begin];
+        uint32_t column = tokens.columns[begin]; // nodes on the first line keep their columns
+        mix(&column, sizeof(column));
+        for (int i = begin; i <= end; i++) {
+            uint8_t type = tokens.types[i];
+            uint32_t offset = tokens.offsets[i] - base;
+            string_view text = tokens.value(i);
+            uint32_t length = text.size();
+            mix(&type, sizeof(type));
+            mix(&offset, sizeof(offset));
+            mix(&length, sizeof(length));
+            mix(text.data(), text.size());
+        }
+        return hash;
+    }
+
+    // Move a reused subtree to where its statement now starts.
+    static void shift(AST_NODE *node, int lines, int64_t bytes) {
+        if (!node) return;
+        if (node->lineno > 0) node->lineno += lines; // 0: never given a position
+        node->offset += bytes;
+        shift(node->CHILD, lines, bytes);
+        for (AST_NODE *sub : node->SUB_STATEMENTS) {
+            shift(sub, lines, bytes);
+        }
+    }
+
+    AST_NODE *IncrementalParser::parse(const TokenStream &tokens, const SourceMap &sourcemap, const shared_ptr<CompilationSession> &session) {
+        vector<CompilationSession *> generations;
+        for (const Statement &statement : statements) {
+            if (find(generations.begin(), generations.end(), statement.session.get()) == generations.end()) {
+                generations.push_back(statement.session.get());
+            }
+        }
+        if (generations.size() > MAX_GENERATIONS) {
+            // too many old arenas pinned by a few statements each; start over
+            statements.clear();
+        }
+        byFingerprint.clear();
+        for (size_t i = 0; i < statements.size(); i++) {
+            byFingerprint[statements[i].fingerprint] = i;
+        }
+        used.assign(statements.size(), false);
+        expected = 0;
+        reused = parsed = 0;
+        building = session;
+
+        Parser parser(tokens, sourcemap, *session);
+        AST_NODE *root = parser.parse(this);
+
+        statements.swap(next);
+        next.clear();
+        building.reset();
+        return root;
+    }
+
+    // Try the statements that followed the last match first: an edit usually
+    // leaves the rest of the file in order.
+    AST_NODE *IncrementalParser::reuse(const TokenStream &tokens, int start, int &end) {
+        for (size_t i = expected; i < statements.size() && i < expected + LOOKAHEAD; i++) {
+            Statement &statement = statements[i];
+            end = start + statement.tokens - 1;
+            if (used[i] || end >= (int)tokens.size() || fingerprint(tokens, start, end) != statement.fingerprint) {
+                continue;
+            }
+            shift(statement.node, (int)tokens.lines[start] - statement.lineno, (int64_t)tokens.offsets[start] - statement.offset);
+            statement.lineno = tokens.lines[start];
+            statement.offset = tokens.offsets[start];
+            used[i] = true;
+            expected = i + 1;
+            reused++;
+            next.push_back(statement);
+            return statement.node;
+        }
+        return nullptr;
+    }
+
+    void IncrementalParser::record(const TokenStream &tokens, int start, int end, AST_NODE *node) {
+        uint64_t hash = fingerprint(tokens, start, end);
+        next.push_back({hash, (uint32_t)(end - start + 1), tokens.offsets[start], (int)tokens.lines[start], node, building});
+        parsed++;
+        // an unchanged statement that was parsed anyway (the edit was bigger than
+        // LOOKAHEAD statements) puts the search back in step with the old file
+        auto known = byFingerprint.find(hash);
+        if (known != byFingerprint.end()) {
+            expected = known->second + 1;
+        }
+    }
@@ -0,0 +1,156 @@
+#include "scan.hpp"
+#include <bit>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define SCAN_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SCAN_SSE2 1
+#endif
+
+static inline bool isBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline bool isIdentChar(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+static inline bool isStringStop(char c, char quote)
+{
+    return c == quote || c == '\\' || c == '\n' || c == '\0';
+}
+
+#if defined(SCAN_AVX2)
+
+static constexpr size_t WIDTH = 32;
+typedef __m256i chunk;
+
+static inline chunk load(const char *p) { return _mm256_loadu_si256((const __m256i *)p); }
+static inline chunk splat(char c) { return _mm256_set1_epi8(c); }
+static inline chunk eq(chunk a, chunk b) { return _mm256_cmpeq_epi8(a, b); }
+static inline chunk gt(chunk a, chunk b) { return _mm256_cmpgt_epi8(a, b); }
+static inline chunk both(chunk a, chunk b) { return _mm256_and_si256(a, b); }
+static inline chunk either(chunk a, chunk b) { return _mm256_or_si256(a, b); }
+static inline uint32_t hits(chunk m) { return (uint32_t)_mm256_movemask_epi8(m); }
+static inline uint32_t misses(chunk m) { return ~hits(m); }
+
+#elif defined(SCAN_SSE2)
+
+static constexpr size_t WIDTH = 16;
+typedef __m128i chunk;
+
+static inline chunk load(const char *p) { return _mm_loadu_si128((const __m128i *)p); }
+static inline chunk splat(char c) { return _mm_set1_epi8(c); }
+static inline chunk eq(chunk a, chunk b) { return _mm_cmpeq_epi8(a, b); }
+static inline chunk gt(chunk a, chunk b) { return _mm_cmpgt_epi8(a, b); }
+static inline chunk both(chunk a, chunk b) { return _mm_and_si128(a, b); }
+static inline chunk either(chunk a, chunk b) { return _mm_or_si128(a, b); }
+static inline uint32_t hits(chunk m) { return (uint32_t)_mm_movemask_epi8(m); }
+static inline uint32_t misses(chunk m) { return ~hits(m) & 0xFFFF; }
+
+#endif
+
+#if defined(SCAN_AVX2) || defined(SCAN_SSE2)
+
+// cmpgt is signed, so bytes >= 0x80 compare below every bound and never land in a range.
+static inline chunk inRange(chunk x, char lo, char hi)
+{
+    return both(gt(x, splat(lo - 1)), gt(splat(hi + 1), x));
+}
+
+size_t scanBlanks(const char *text, size_t pos, size_t end)
+{
+    const chunk space = splat(' '), tab = splat('\t'), cr = splat('\r');
+    for (; pos + WIDTH <= end; pos += WIDTH)
+    {
+        chunk x = load(text + pos);
+        uint32_t stop = misses(either(either(eq(x, space), eq(x, tab)), eq(x, cr)));
+        if (stop)
+        {
+            return pos + std::countr_zero(stop);
+        }
+    }
+    while (pos < end && isBlank(text[pos]))
+    {
+        pos++;
+    }
+    return pos;
+}
+
+size_t scanIdentifier(const char *text, size_t pos, size_t end)
+{
+    const chunk underscore = splat('_'), caseBit = splat(0x20);
+    for (; pos + WIDTH <= end; pos += WIDTH)
+    {
+        chunk x = load(text + pos);
+        // folding the case bit maps A-Z onto a-z; '@' and '[' fold onto the
+        // neighbours '`' and '{', which sit just outside the range
+        chunk alpha = inRange(either(x, caseBit), 'a', 'z');
+        chunk digit = inRange(x, '0', '9');
+        uint32_t stop = misses(either(either(alpha, digit), eq(x, underscore)));
+        if (stop)
+        {
+            return pos + std::countr_zero(stop);
+        }
+    }
+    while (pos < end && isIdentChar(text[pos]))
+    {
+        pos++;
+    }
+    return pos;
+}
+
+size_t scanString(const char *text, size_t pos, size_t end, char quote)
+{
+    const chunk q = splat(quote), backslash = splat('\\'), newline = splat('\n'), nul = splat('\0');
+    for (; pos + WIDTH <= end; pos += WIDTH)
+    {
+        chunk x = load(text + pos);
+        uint32_t stop = hits(either(either(eq(x, q), eq(x, backslash)), either(eq(x, newline), eq(x, nul))));
+        if (stop)
+        {
+            return pos + std::countr_zero(stop);
+        }
+    }
+    while (pos < end && !isStringStop(text[pos], quote))
+    {
+        pos++;
+    }
+    return pos;
+}
+
+#else
+
+size_t scanBlanks(const char *text, size_t pos, size_t end)
+{
+    while (pos < end && isBlank(text[pos]))
+    {
+        pos++;
+    }
+    return pos;
+}
+
+size_t scanIdentifier(const char *text, size_t pos, size_t end)
+{
+    while (pos < end && isIdentChar(text[pos]))
+    {
+        pos++;
+    }
+    return pos;
+}
+
+size_t scanString(const char *text, size_t pos, size_t end, char quote)
+{
+    while (pos < end && !isStringStop(text[pos], quote))
+    {
+        pos++;
+    }
+    return pos;
+}
+
+#endif
@@ -1,4 +1,5 @@
 #include "semantics.hpp"
+#include <algorithm>
 #include <iostream>
 #include <unordered_map>
 #include <string>
@@ -18,7 +19,49 @@ string vartypestr(VarType type) {
     }
 }
 
-SemanticAnalyzer::SemanticAnalyzer() 
+void ScopeStack::push() {
+    frames.push_back(bindings.size());
+}
+
+void ScopeStack::pop() {
+    bindings.resize(frames.back());
+    frames.pop_back();
+}
+
+VarInfo *ScopeStack::find(Symbol name) {
+    // frames hold a handful of names each, so a backwards scan beats any index
+    for (size_t i = bindings.size(); i-- > 0;) {
+        if (bindings[i].name == name) {
+            return &bindings[i].info;
+        }
+    }
+    return global.find(name);
+}
+
+void ScopeStack::assign(Symbol name, VarInfo info) {
+    if (VarInfo *bound = find(name)) {
+        *bound = info;
+        return;
+    }
+    declare(name, info);
+}
+
+void ScopeStack::declare(Symbol name, VarInfo info) {
+    if (frames.empty()) {
+        global[name] = info;
+        return;
+    }
+    for (size_t i = frames.back(); i < bindings.size(); i++) {
+        if (bindings[i].name == name) {
+            bindings[i].info = info;
+            return;
+        }
+    }
+    bindings.push_back({name, info});
+}
+
+SemanticAnalyzer::SemanticAnalyzer(Diagnostics &diagnostics)
+    : diagnostics(&diagnostics)
 {
      draw_callables = {
         {"clear", {{}, false, true, TYPE_UNKNOWN} },
@@ -47,50 +90,73 @@ SemanticAnalyzer::SemanticAnalyzer()
     };
 }
 
-void SemanticAnalyzer::analyze(AST_NODE *root) {
-        scope.clear();
+void SemanticAnalyzer::analyze(Ast &ast) {
+        // a module from the cache may carry another program's annotations
+        annotated = &ast;
+        std::fill(ast.types.begin(), ast.types.end(), TYPE_UNKNOWN);
+        std::fill(ast.flags.begin(), ast.flags.end(), 0);
+        // globals, declaredFunctions and pagescope may already hold imported names
         statevars.clear();
-        declaredFunctions.clear();
         calledFunctions.clear();
-        pagescope.clear();
         instances.clear();
 
-        instances["platform"] =  {platform_callables, true};
+        static const Symbol platform = Symbols::intern("platform");
+        instances[platform] =  {platform_callables, true};
 
         // Pass 1: Analyze all statements
-        for (auto stmt : root->SUB_STATEMENTS) {
-            checkNode(stmt);
+        for (AstNode stmt : ast.root().subs()) {
+            if (stmt.type() == NODE_IMPORT) continue; // resolved by the module graph
+            checkStatement(stmt);
         }
 
         // Pass 2: Validate functions that were called but not declared
-        for (const auto &fname : calledFunctions) {
-            if (declaredFunctions.find(fname) == declaredFunctions.end()) {
-                semanticError("Function '" + fname + "' called but not declared.");
+        for (Symbol fname : calledFunctions) {
+            if (!declaredFunctions.contains(fname)) {
+                semanticError("Function '" + Symbols::name(fname) + "' called but not declared.");
             }
         }
 }
 
 
 
-void SemanticAnalyzer::parserError(const std::string &message, AST_NODE* current) {
-        std::cerr << "\nSemantics Error: " << message
-                  << " at line " << current->lineno
-                  << ", column " << current->charno << "\n";
-        std::cerr << "  " << current->lineno << " | " << current->sourceLine << "\n";
-        for (int i = 1; i < (current->charno+to_string(current->lineno).length()+1); ++i)
-            std::cerr << " ";
-        for (int i = 0; i < current->value->length(); i++)
-        {
-            std::cerr << "^";
-        }
-        std::cerr << "\n\n";
-        std::exit(1);
+void SemanticAnalyzer::importFrom(const SemanticAnalyzer &module) {
+    scopes.globals().insert(module.scopes.globals());
+    declaredFunctions.insert(module.declaredFunctions);
+    pagescope.insert(module.pagescope);
+}
+
+void SemanticAnalyzer::parserError(const std::string &message, AstNode current) {
+        diagnostics->error("Semantics Error", message, current.lineno(), current.charno(), current.value().length());
+        throw RecoverableError();
+    }
+
+// One statement of a block. An error abandons the statement but not the block,
+// so the statements after it are still checked.
+VarType SemanticAnalyzer::checkStatement(AstNode node, bool uiexceptonstylsheet, bool funcdecl, bool isfrompage) {
+    try {
+        return checkNode(node, uiexceptonstylsheet, funcdecl, isfrompage);
+    } catch (const RecoverableError &) {
+        return TYPE_UNKNOWN;
     }
+}
+
+// Every node that gets checked keeps its type in the Ast, for codegen.
+VarType SemanticAnalyzer::checkNode(AstNode node, bool uiexceptonstylsheet, bool funcdecl, bool isfrompage) {
+    VarType type = inferNode(node, uiexceptonstylsheet, funcdecl, isfrompage);
+    if (node) {
+        annotated->types[node.id()] = type;
+    }
+    return type;
+}
+
+void SemanticAnalyzer::markState(AstNode node) {
+    annotated->flags[node.id()] |= FLAG_STATE;
+}
 
-VarType SemanticAnalyzer::checkNode(AST_NODE *node, bool uiexceptonstylsheet, bool funcdecl, bool isfrompage) {
+VarType SemanticAnalyzer::inferNode(AstNode node, bool uiexceptonstylsheet, bool funcdecl, bool isfrompage) {
     if (!node) return TYPE_UNKNOWN;
 
-    switch (node->TYPE) {
+    switch (node.type()) {
         case NODE_INT:
             return TYPE_INT;
 
@@ -98,11 +164,11 @@ VarType SemanticAnalyzer::checkNode(AST_NODE *node, bool uiexceptonstylsheet, bo
             return TYPE_STRING;
 
         case NODE_BOOL: {
-            VarType var1 = checkNode(node->SUB_STATEMENTS[0]);
-            VarType var2 = checkNode(node->SUB_STATEMENTS[1]);
+            VarType var1 = checkNode(node.subs()[0]);
+            VarType var2 = checkNode(node.subs()[1]);
             if (var1 != var2)
             {
-                parserError("Variables don't match '" + *(node->SUB_STATEMENTS[0]->value) + "'" + "  &  " + "'" + *(node->SUB_STATEMENTS[1]->value) + "' doesnt match!.", node);
+                parserError("Variables don't match '" + node.subs()[0].value() + "'" + "  &  " + "'" + node.subs()[1].value() + "' doesnt match!.", node);
             }
 
             return TYPE_BOOL;
@@ -111,27 +177,27 @@ VarType SemanticAnalyzer::checkNode(AST_NODE *node, bool uiexceptonstylsheet, bo
             return TYPE_FLOAT;
 
         case NODE_DICT: {
-            for (const auto& i : node->SUB_STATEMENTS)
+            for (AstNode i : node.subs())
             {
                 if (!uiexceptonstylsheet)
                 {
-                    if (i->SUB_STATEMENTS[0]->TYPE == NODE_VARIABLE)
+                    if (i.subs()[0].type() == NODE_VARIABLE)
                     {
-                        if (node->value)
+                        if (node.hasValue())
                         {
-                            if (*(node->value) != string("#"))
+                            if (node.value() != string("#"))
                             {
-                                VarType rhsType = checkNode(i->SUB_STATEMENTS[0]);
+                                VarType rhsType = checkNode(i.subs()[0]);
                             }
                         }  else {
-                                VarType rhsType = checkNode(i->SUB_STATEMENTS[0]);
+                                VarType rhsType = checkNode(i.subs()[0]);
                         }
                     }
                 }
 
-                if (i->SUB_STATEMENTS[1]->TYPE == NODE_VARIABLE)
+                if (i.subs()[1].type() == NODE_VARIABLE)
                 {
-                    VarType rhsType = checkNode(i->SUB_STATEMENTS[1]);
+                    VarType rhsType = checkNode(i.subs()[1]);
                 }
             }
 
@@ -141,57 +207,64 @@ VarType SemanticAnalyzer::checkNode(AST_NODE *node, bool uiexceptonstylsheet, bo
         // Variable declaration or assignment
         case NODE_SETSTATE:
         case NODE_VARIABLE: {
-            std::string name = *node->value;
-            if (node->CHILD) {
-                VarType rhsType = checkNode(node->CHILD, uiexceptonstylsheet, funcdecl, isfrompage);
-                if (node->CHILD->TYPE == NODE_DRAW) {
+            Symbol name = node.symbol();
+            if (node.child()) {
+                VarType rhsType = checkNode(node.child(), uiexceptonstylsheet, funcdecl, isfrompage);
+                if (node.child().type() == NODE_DRAW) {
                     instances[name] = {draw_callables, true};
                 }
-                if (node->CHILD->TYPE == NODE_PLATFORM_CLS) {
+                if (node.child().type() == NODE_PLATFORM_CLS) {
                     instances[name] = {platform_callables, true};
                 }
-                if(node->TYPE == NODE_VARIABLE) {
-                    scope[name] = {rhsType, true};
+                if(node.type() == NODE_VARIABLE) {
+                    if (statevars.contains(name)) {
+                        markState(node);
+                    }
+                    scopes.assign(name, {rhsType, true});
                 }
-                if(node->TYPE == NODE_SETSTATE) {
+                if(node.type() == NODE_SETSTATE) {
+                    markState(node);
                     statevars[name] = {rhsType, true};
                 }
                 return rhsType;
             } else {
                 // variable usage
-                auto it = scope.find(name);
-                auto st = statevars.find(name);
+                VarInfo *it = scopes.find(name);
+                VarInfo *st = statevars.find(name);
 
-                if(st == statevars.end()) {
-                    if(it == scope.end()) {
-                        parserError("Variable '" + name + "' used before assignment.", node);
+                if(!st) {
+                    if(!it) {
+                        parserError("Variable '" + node.value() + "' used before assignment.", node);
                     }
                 }
-                if (st != statevars.end()) {
-                    return statevars[name].type;
+                if (st) {
+                    markState(node);
+                    return st->type;
                 }
-                if (it != scope.end()) {
-                    return scope[name].type;
+                if (it) {
+                    return it->type;
                 }
 
             }
         }
         case NODE_page: {
-            if (node->CHILD) {
-                VarType node1 = checkNode(node->CHILD->SUB_STATEMENTS[0]);
+            static const Symbol indexRoute = Symbols::intern("/");
+            ScopeStack::Frame page(scopes);
+            if (node.child()) {
+                VarType node1 = checkNode(node.child().subs()[0]);
                 if (node1 != TYPE_STRING)
                 {
-                    parserError("Title can only be a string but got: '" + *(node->CHILD->SUB_STATEMENTS[0]->value) + "'", node->CHILD->SUB_STATEMENTS[1]);
+                    parserError("Title can only be a string but got: '" + node.child().subs()[0].value() + "'", node.child().subs()[1]);
                 }
 
                 bool isindex = false;
-                if (node->CHILD->SUB_STATEMENTS.size() > 1)
+                if (node.child().subs().size() > 1)
                 {
-                    for (auto it = node->CHILD->SUB_STATEMENTS.begin() +1; it != node->CHILD->SUB_STATEMENTS.end(); ++it)
+                    for (auto it = node.child().subs().begin() +1; it != node.child().subs().end(); ++it)
                     {
-                        AST_NODE* it_node = *it;
-                        if(*(it_node->value) == "route") {
-                            if (*(it_node->CHILD->value) == "/")
+                        AstNode it_node = *it;
+                        if(it_node.value() == "route") {
+                            if (it_node.child().symbol() == indexRoute)
                             {
                                 isindex = true;
                             }
@@ -199,48 +272,48 @@ VarType SemanticAnalyzer::checkNode(AST_NODE *node, bool uiexceptonstylsheet, bo
                             {
                                 isindex = false;
                             }
-                            auto checkroute = pagescope.find(*(it_node->CHILD->value));
-                            if (checkroute == pagescope.end()) {
-                                pagescope[*(it_node->CHILD->value)] = {*(node->CHILD->SUB_STATEMENTS[0]->value), isindex};
+                            PageInfo *checkroute = pagescope.find(it_node.child().symbol());
+                            if (!checkroute) {
+                                pagescope[it_node.child().symbol()] = {node.child().subs()[0].value(), isindex};
                             } else {
-                                parserError("Route '" + *(it_node->CHILD->value) + "' already: '" + checkroute->second.title + "'", node->CHILD->SUB_STATEMENTS[0]);
+                                parserError("Route '" + it_node.child().value() + "' already: '" + checkroute->title + "'", node.child().subs()[0]);
                             }
 
                         }
-                        VarType node2 = checkNode(it_node->CHILD, true);
+                        VarType node2 = checkNode(it_node.child(), true);
                         if (node2 != TYPE_DICT && node2 != TYPE_STRING)
                         {
-                            parserError("Unknown Type in Args in page() but got: '" + *(it_node->value) + "'", it_node);
+                            parserError("Unknown Type in Args in page() but got: '" + it_node.value() + "'", it_node);
                         }
                     }
                     if (isindex) {
-                        auto pagesc = pagescope.find("/");
-                        if (pagesc == pagescope.end()) {
-                            pagescope["/"] = {*(node->CHILD->SUB_STATEMENTS[0]->value), true};
+                        PageInfo *pagesc = pagescope.find(indexRoute);
+                        if (!pagesc) {
+                            pagescope[indexRoute] = {node.child().subs()[0].value(), true};
                         } else {
-                            parserError("Index page already defined: '" + pagesc->second.title + "'", node->CHILD->SUB_STATEMENTS[0]);
+                            parserError("Index page already defined: '" + pagesc->title + "'", node.child().subs()[0]);
                         }
                     }
 
                 } else {
-                    auto pagesc = pagescope.find("/");
+                    PageInfo *pagesc = pagescope.find(indexRoute);
 
-                    if (pagesc == pagescope.end()) {
-                        pagescope["/"] = {*(node->CHILD->SUB_STATEMENTS[0]->value), true};
+                    if (!pagesc) {
+                        pagescope[indexRoute] = {node.child().subs()[0].value(), true};
                     } else {
-                        parserError("Index page already defined as: '" + pagesc->second.title + "'", node->CHILD->SUB_STATEMENTS[0]);
+                        parserError("Index page already defined as: '" + pagesc->title + "'", node.child().subs()[0]);
                     }
                 }
             }
-            if (!node->SUB_STATEMENTS.empty())
+            if (!node.subs().empty())
             {
-                for (auto &i : node->SUB_STATEMENTS)
+                for (AstNode i : node.subs())
                 {
-                    if (i->TYPE == NODE_FUNCTION_DECL && *(i->value) == "onmount")  {
-                        checkNode(i, false, true, true);
+                    if (i.type() == NODE_FUNCTION_DECL && i.value() == "onmount")  {
+                        checkStatement(i, false, true, true);
                         continue;
                     }
-                    checkNode(i, true,false, true);
+                    checkStatement(i, true,false, true);
                 }
             }
             statevars.clear();
@@ -252,32 +325,32 @@ VarType SemanticAnalyzer::checkNode(AST_NODE *node, bool uiexceptonstylsheet, bo
         case NODE_CANVAS:
         case NODE_IMAGE:
         case NODE_VIEW: {
-            if (node->CHILD) {
+            if (node.child()) {
 
-                VarType node1 = checkNode(node->CHILD->SUB_STATEMENTS[0]);
+                VarType node1 = checkNode(node.child().subs()[0]);
                 if (node1 != TYPE_STRING)
                 {
-                    parserError("Title can only be a string but got: '" + *(node->CHILD->SUB_STATEMENTS[0]->value) + "'", node->CHILD->SUB_STATEMENTS[0]);
+                    parserError("Title can only be a string but got: '" + node.child().subs()[0].value() + "'", node.child().subs()[0]);
                 }
 
-                if (node->CHILD->SUB_STATEMENTS.size() > 1)
+                if (node.child().subs().size() > 1)
                 {
-                    for (auto it = node->CHILD->SUB_STATEMENTS.begin() +1; it != node->CHILD->SUB_STATEMENTS.end(); ++it)
+                    for (auto it = node.child().subs().begin() +1; it != node.child().subs().end(); ++it)
                     {
-                        AST_NODE* it_node = *it;
+                        AstNode it_node = *it;
                         VarType node2 = checkNode(it_node, true, true);
                         if (node2 != TYPE_DICT && node2 != TYPE_STRING && node2 != TYPE_FUNCTION && node2 != TYPE_INT)
                         {
-                            parserError("Unknown Type in Args in View() but got: '" + *(it_node->value) + "<->" + *(it_node->CHILD->value) + "'", it_node->CHILD);
+                            parserError("Unknown Type in Args in View() but got: '" + it_node.value() + "<->" + it_node.child().value() + "'", it_node.child());
                         }
                     }
                 }
             }
-            if (!node->SUB_STATEMENTS.empty())
+            if (!node.subs().empty())
             {
-                for (auto &i : node->SUB_STATEMENTS)
+                for (AstNode i : node.subs())
                 {
-                    checkNode(i);
+                    checkStatement(i);
                 }
             }
             return TYPE_FUNCTION;
@@ -285,13 +358,13 @@ VarType SemanticAnalyzer::checkNode(AST_NODE *node, bool uiexceptonstylsheet, bo
         // Binary operations (e.g., +, -, ==)
         case NODE_BINARY_OP:
         case NODE_COMPARISON_OP: {
-            VarType leftType = checkNode(node->SUB_STATEMENTS[0]);
-            VarType rightType = checkNode(node->SUB_STATEMENTS[1]);
-            std::string op = *node->value;
+            VarType leftType = checkNode(node.subs()[0]);
+            VarType rightType = checkNode(node.subs()[1]);
+            std::string op = node.value();
 
             if (leftType == TYPE_INT ||  leftType == TYPE_FLOAT) {
                 if (rightType == TYPE_INT || rightType == TYPE_FLOAT) {
-                    return TYPE_FLOAT;
+                    return (leftType == TYPE_INT && rightType == TYPE_INT) ? TYPE_INT : TYPE_FLOAT;
                 }
             }
             if (leftType != rightType) {
@@ -307,63 +380,50 @@ VarType SemanticAnalyzer::checkNode(AST_NODE *node, bool uiexceptonstylsheet, bo
             if (op == "==" || op == "!=" || op == "<" || op == ">")
                 return TYPE_BOOL;
 
+            if (op == "+" && leftType == TYPE_STRING)
+                return TYPE_STRING;
+
             return TYPE_UNKNOWN;
         }
 
         // Function declaration
         case NODE_FUNCTION_DECL: {
-            std::string name = *node->value;
-            declaredFunctions[name] = {TYPE_FUNCTION, true};
+            declaredFunctions[node.symbol()] = {TYPE_FUNCTION, true};
+            ScopeStack::Frame body(scopes);
 
             // Register arguments in scope
-            if (node->CHILD && node->CHILD->TYPE == NODE_ARGS) {
-                for (auto param : node->CHILD->SUB_STATEMENTS) {
+            if (node.child() && node.child().type() == NODE_ARGS) {
+                for (AstNode param : node.child().subs()) {
                     if (funcdecl)
                     {
-                        std::string name = *param->value;
-
-                        auto it = scope.find(name);
-                        auto st = statevars.find(name);
-
-                            if(st == statevars.end()) {
-                                if(it == scope.end()) {
-                                    parserError("Variable '" + name + "' used before assignment.", node);
-                                }
-                            }
-                        if (it != scope.end()) {
-                                return scope[name].type;
-                        }
-                        if (st != statevars.end()) {
-                                return statevars[name].type;
+                        // a callback's parameters capture names of the enclosing page
+                        if (!scopes.find(param.symbol()) && !statevars.contains(param.symbol())) {
+                            parserError("Variable '" + param.value() + "' used before assignment.", node);
                         }
                     }
-                    else
-                    {
-                        if (param->TYPE == NODE_VARIABLE) {
-                            std::string paramName = *param->value;
-                            scope[paramName] = {TYPE_UNKNOWN, true};
-                    }
+                    else if (param.type() == NODE_VARIABLE) {
+                        scopes.declare(param.symbol(), {TYPE_UNKNOWN, true});
                     }
                 }
             }
 
             // Check the function body
-            for (auto stmt : node->SUB_STATEMENTS)
-                checkNode(stmt);
+            for (AstNode stmt : node.subs())
+                checkStatement(stmt);
             return TYPE_FUNCTION;
         }
 
         // Function call (even undeclared — checked in post-pass)
         case NODE_FUNCTION_CALL: {
-            std::string fname = *node->value;
+            Symbol fname = node.symbol();
             calledFunctions.push_back(fname);
 
             // Evaluate arguments for validity
-            for (auto arg : node->SUB_STATEMENTS)
+            for (AstNode arg : node.subs())
                 checkNode(arg);
 
-            if (declaredFunctions.find(fname) != declaredFunctions.end())
-                return declaredFunctions[fname].type;
+            if (VarInfo *declared = declaredFunctions.find(fname))
+                return declared->type;
 
             return TYPE_UNKNOWN;
         }
@@ -378,31 +438,31 @@ VarType SemanticAnalyzer::checkNode(AST_NODE *node, bool uiexceptonstylsheet, bo
         case NODE_PLATFORM_CLS:
         case NODE_DRAW:
         case NODE_TYPE_CHECK:
-            if (node->CHILD) {
-                if (node->TYPE == NODE_DRAW) {
+            if (node.child()) {
+                if (node.type() == NODE_DRAW) {
                     if (!isfrompage) {
                         //logic to add to instance
                     }
-                    VarType ty = checkNode(node->CHILD->SUB_STATEMENTS[0]);
+                    VarType ty = checkNode(node.child().subs()[0]);
                     if (ty != TYPE_STRING) {
-                        parserError("Type Conversion Must be Str.", node->CHILD);
+                        parserError("Type Conversion Must be Str.", node.child());
                     }
                     return TYPE_FUNCTION;
                 }
-                VarType ty = checkNode(node->CHILD);
+                VarType ty = checkNode(node.child());
 
-                if(node->TYPE == NODE_TOFLOAT || node->TYPE == NODE_TOINT) {
+                if(node.type() == NODE_TOFLOAT || node.type() == NODE_TOINT) {
                     if (ty != TYPE_STRING) {
-                        parserError("Type Conversion Must be Str.", node->CHILD);
+                        parserError("Type Conversion Must be Str.", node.child());
                     }
-                    if (node->TYPE == NODE_TOINT) {
+                    if (node.type() == NODE_TOINT) {
                         return TYPE_INT;
                     }
-                    if (node->TYPE == NODE_TOFLOAT) {
+                    if (node.type() == NODE_TOFLOAT) {
                         return TYPE_FLOAT;
                     }
                 }
-                if (node->TYPE == NODE_TOSTR) {
+                if (node.type() == NODE_TOSTR) {
                     return TYPE_STRING;
                 }
             }
@@ -413,97 +473,107 @@ VarType SemanticAnalyzer::checkNode(AST_NODE *node, bool uiexceptonstylsheet, bo
 
         // If / While / For blocks
         case NODE_IF: {
-            if (node->CHILD) {
-                VarType condType = checkNode(node->CHILD);
+            if (node.child()) {
+                VarType condType = checkNode(node.child());
                 if (condType != TYPE_BOOL) {
-                    parserError("Condition in if statement must evaluate to a boolean.", node->CHILD);
+                    parserError("Condition in if statement must evaluate to a boolean.", node.child());
                 }
-                for (auto stmt : node->CHILD->SUB_STATEMENTS)
+                for (AstNode stmt : node.child().subs())
                 {
                     checkNode(stmt);
                 }
-                for (auto stmt : node->SUB_STATEMENTS)
-                    checkNode(stmt);
+                for (AstNode stmt : node.subs())
+                    checkStatement(stmt);
                 return TYPE_UNKNOWN;
             }
         }
         case NODE_WHILE: {
-            if (node->CHILD) {
-                VarType condType = checkNode(node->CHILD);
+            if (node.child()) {
+                VarType condType = checkNode(node.child());
                 if (condType != TYPE_BOOL)
                     semanticError("Condition in if/while must evaluate to a boolean.");
             }
-            for (auto stmt : node->SUB_STATEMENTS)
-                checkNode(stmt);
+            ScopeStack::Frame body(scopes);
+            for (AstNode stmt : node.subs())
+                checkStatement(stmt);
             return TYPE_UNKNOWN;
         }
         case NODE_ELSE_IF: {
-            if (node->CHILD) {
-                VarType condType = checkNode(node->CHILD);
+            if (node.child()) {
+                VarType condType = checkNode(node.child());
                 if (condType != TYPE_BOOL)
-                    parserError("Condition in 'else If' must evaluate to a boolean.", node->CHILD);
+                    parserError("Condition in 'else If' must evaluate to a boolean.", node.child());
             }
-            for (auto *stmt : node->SUB_STATEMENTS) {
-                checkNode(stmt);
+            for (AstNode stmt : node.subs()) {
+                checkStatement(stmt);
             }
             return TYPE_UNKNOWN;
         }
 
         case NODE_ELSE:
-        case NODE_FOR:
-            for (auto stmt : node->SUB_STATEMENTS)
-                checkNode(stmt);
+            for (AstNode stmt : node.subs())
+                checkStatement(stmt);
+            return TYPE_UNKNOWN;
+        case NODE_FOR: {
+            ScopeStack::Frame body(scopes);
+            if (node.child() && node.child().type() == NODE_ARGS) {
+                for (AstNode clause : node.child().subs())
+                    checkNode(clause);
+            }
+            for (AstNode stmt : node.subs())
+                checkStatement(stmt);
             return TYPE_UNKNOWN;
+        }
         case NODE_STYLESHEET:
-            for (auto stmt : node->SUB_STATEMENTS)
-                checkNode(stmt, false);
+            for (AstNode stmt : node.subs())
+                checkStatement(stmt, false);
             return TYPE_UNKNOWN;
         case NODE_CLS:
-            checkNode(node->CHILD, true);
+            checkNode(node.child(), true);
             return TYPE_UNKNOWN;
         case NODE_MEDIA_QUERY: {
-            checkNode(node->CHILD);
-            for (auto stmt : node->SUB_STATEMENTS)
-                checkNode(stmt, false);
+            checkNode(node.child());
+            for (AstNode stmt : node.subs())
+                checkStatement(stmt, false);
             return TYPE_UNKNOWN;
         }
 
         case NODE_INSTANCE: {
-            auto it = instances.find(*(node->value));
-            if (it == instances.end()) {
-                parserError("'"+ *(node->value) +"' is not Callable", node);
+            InstanceInfo *it = instances.find(node.symbol());
+            if (!it) {
+                parserError("'"+ node.value() +"' is not Callable", node);
             }
-            if (node->CHILD) {
-                auto& secondinstance = it->second;
+            if (node.child()) {
+                auto& secondinstance = *it;
                 auto& calls = secondinstance.callables;
 
-                if(node->CHILD->TYPE == NODE_BINARY_OP) {
-                    auto ch = calls.find(*(node->CHILD->SUB_STATEMENTS[0]->value));
-                    if (ch == calls.end()) {
-                        parserError("'"+ *(node->value) +"' Has no member '"+ *(node->CHILD->SUB_STATEMENTS[0]->value) +"'", node->CHILD);
+                if(node.child().type() == NODE_BINARY_OP) {
+                    CallableInfo *ch = calls.find(node.child().subs()[0].symbol());
+                    if (!ch) {
+                        parserError("'"+ node.value() +"' Has no member '"+ node.child().subs()[0].value() +"'", node.child());
                     }
 
 
-                    if (ch->second.isVariadic) {
-                            if(node->CHILD->SUB_STATEMENTS[0]->TYPE != NODE_FUNCTION_CALL) {
-                                parserError("'" + *(node->CHILD->SUB_STATEMENTS[0]->value) + "' is callable!", node->CHILD);
+                    if (ch->isVariadic) {
+                            if(node.child().subs()[0].type() != NODE_FUNCTION_CALL) {
+                                parserError("'" + node.child().subs()[0].value() + "' is callable!", node.child());
                             }
                     } else {
-                        if(node->CHILD->SUB_STATEMENTS[0]->TYPE == NODE_FUNCTION_CALL) {
-                            parserError("'" + *(node->CHILD->SUB_STATEMENTS[0]->value) + "' is Not callable!", node->CHILD);
+                        if(node.child().subs()[0].type() == NODE_FUNCTION_CALL) {
+                            parserError("'" + node.child().subs()[0].value() + "' is Not callable!", node.child());
 
                         }
                     }
                     // ch.second.returnType
-                    VarType cls = ch->second.returnType;
-                    if(cls == TYPE_STRING && node->CHILD->SUB_STATEMENTS[1]->TYPE != NODE_STRING) {
-                        parserError("Type Mismatch, can't perfom binary Operation on given types", node->CHILD);
+                    VarType cls = ch->returnType;
+                    if(cls == TYPE_STRING && node.child().subs()[1].type() != NODE_STRING) {
+                        parserError("Type Mismatch, can't perfom binary Operation on given types", node.child());
                     }
 
                     if(cls == TYPE_INT) {
-                        if(node->CHILD->SUB_STATEMENTS[1]->TYPE != NODE_FLOAT) {
-                            if(node->CHILD->SUB_STATEMENTS[1]->TYPE != NODE_INT) {
-                                parserError("Type Mismatch, can't perfom binary Operation on given types", node->CHILD);
+                        if(node.child().subs()[1].type() != NODE_FLOAT) {
+                            if(node.child().subs()[1].type() != NODE_INT) {
+                                parserError("Type Mismatch, can't perfom binary Operation on given types", node.child());
                             }
                         }
                     }
@@ -513,47 +583,47 @@ VarType SemanticAnalyzer::checkNode(AST_NODE *node, bool uiexceptonstylsheet, bo
                     }
                     return TYPE_FLOAT;
                 }
-                auto ch = calls.find(*(node->CHILD->value));
-                if (ch == calls.end()) {
-                    parserError("'"+ *(node->value) +"' Has no member '"+ *(node->CHILD->value) +"'", node->CHILD);
+                CallableInfo *ch = calls.find(node.child().symbol());
+                if (!ch) {
+                    parserError("'"+ node.value() +"' Has no member '"+ node.child().value() +"'", node.child());
                 }
-                if(node->CHILD->SUB_STATEMENTS.empty()) {
-                    if (ch->second.isVariadic) {
-                        if(node->CHILD->TYPE != NODE_FUNCTION_CALL) {
-                            parserError("'" + *(node->CHILD->value) + "' is callable!", node->CHILD);
+                if(node.child().subs().empty()) {
+                    if (ch->isVariadic) {
+                        if(node.child().type() != NODE_FUNCTION_CALL) {
+                            parserError("'" + node.child().value() + "' is callable!", node.child());
                         }
                     } else {
                         if (secondinstance.issystemdefined) {
-                            if (node->CHILD->CHILD)
+                            if (node.child().child())
                             {
-                                parserError("'" + *(node->CHILD->value) + "' is not assignable", node->CHILD);
+                                parserError("'" + node.child().value() + "' is not assignable", node.child());
                             }
 
                         }
-                        if(node->CHILD->TYPE == NODE_FUNCTION_CALL) {
-                            parserError("'" + *(node->CHILD->value) + "' is not Callable", node->CHILD);
+                        if(node.child().type() == NODE_FUNCTION_CALL) {
+                            parserError("'" + node.child().value() + "' is not Callable", node.child());
                         }
                     }
                 } else {
-                    if (node->CHILD->SUB_STATEMENTS.size() != ch->second.args.size()) {
-                        parserError("'"+ *(node->CHILD->value) +"' was expecting '"+ to_string(ch->second.args.size()) +" arguments but got: " + to_string(node->CHILD->SUB_STATEMENTS.size()), node->CHILD);
+                    if (node.child().subs().size() != ch->args.size()) {
+                        parserError("'"+ node.child().value() +"' was expecting '"+ to_string(ch->args.size()) +" arguments but got: " + to_string(node.child().subs().size()), node.child());
                     }
-                    if (ch->second.isVariadic) {
-                        if(node->CHILD->TYPE != NODE_FUNCTION_CALL) {
-                            parserError("'" + *(node->CHILD->value) + "' is not callable!", node->CHILD);
+                    if (ch->isVariadic) {
+                        if(node.child().type() != NODE_FUNCTION_CALL) {
+                            parserError("'" + node.child().value() + "' is not callable!", node.child());
                         }
                     } else {
                         if (secondinstance.issystemdefined) {
-                            if (node->CHILD->CHILD)
+                            if (node.child().child())
                             {
-                                parserError("'" + *(node->CHILD->value) + "' is not assignable", node->CHILD);
+                                parserError("'" + node.child().value() + "' is not assignable", node.child());
                             }
 
                         }
                     }
 
-                    for (auto &subs : node->CHILD->SUB_STATEMENTS) {
-                        for (auto &chv : ch->second.args) {
+                    for (AstNode subs : node.child().subs()) {
+                        for (auto &chv : ch->args) {
                             VarType nodecheck = checkNode(subs, uiexceptonstylsheet, funcdecl, isfrompage);
                             if (nodecheck != chv ) {
                                 if (nodecheck == TYPE_INT && chv == TYPE_FLOAT) {
@@ -561,30 +631,30 @@ VarType SemanticAnalyzer::checkNode(AST_NODE *node, bool uiexceptonstylsheet, bo
                                 } else if (nodecheck == TYPE_FLOAT && chv == TYPE_INT) {
                                     continue;
                                 }
-                                parserError("'"+ *(node->CHILD->value) +"' was expecting '"+ vartypestr(chv) +"  but got: " + vartypestr(nodecheck), subs);
+                                parserError("'"+ node.child().value() +"' was expecting '"+ vartypestr(chv) +"  but got: " + vartypestr(nodecheck), subs);
                             }
                         }
                     }
                 }
-                return ch->second.returnType;
+                return ch->returnType;
             }
             
             return TYPE_FUNCTION;
         }
         case NODE_MATH_POW: {
-            if (node->CHILD)
+            if (node.child())
             {
-                VarType arg = checkNode(node->CHILD, uiexceptonstylsheet, funcdecl,isfrompage);
+                VarType arg = checkNode(node.child(), uiexceptonstylsheet, funcdecl,isfrompage);
                 if (arg != TYPE_INT && arg != TYPE_FLOAT) {
-                    parserError("power only accepts number but got "+ nodetostr(node->CHILD->TYPE), node->CHILD);
+                    parserError("power only accepts number but got "+ nodetostr(node.child().type()), node.child());
                 }
                 return TYPE_FLOAT;
             }
-            for (auto &i : node->SUB_STATEMENTS)
+            for (AstNode i : node.subs())
             {
                 VarType arg = checkNode(i, uiexceptonstylsheet, funcdecl,isfrompage);
                 if (arg != TYPE_INT && arg != TYPE_FLOAT) {
-                    parserError("power only--accepts number but got "+ nodetostr(i->TYPE), i);
+                    parserError("power only--accepts number but got "+ nodetostr(i.type()), i);
                 }
             }
             return TYPE_FLOAT;
@@ -593,19 +663,19 @@ VarType SemanticAnalyzer::checkNode(AST_NODE *node, bool uiexceptonstylsheet, bo
         case NODE_MATH_SQRT:
         case NODE_MATH_TAN:
         case NODE_MATH_SIN: {
-            VarType arg = checkNode(node->CHILD, uiexceptonstylsheet, funcdecl,isfrompage);
+            VarType arg = checkNode(node.child(), uiexceptonstylsheet, funcdecl,isfrompage);
             if (arg != TYPE_INT && arg != TYPE_FLOAT) {
-                parserError( nodetostr(node->TYPE) +" only accepts number but got "+ nodetostr(node->CHILD->TYPE), node->CHILD);
+                parserError( nodetostr(node.type()) +" only accepts number but got "+ nodetostr(node.child().type()), node.child());
             }
             return TYPE_FLOAT;
         }
+        case NODE_IMPORT:
+            parserError("import is only allowed at the top level of a file", node);
         default:
             return TYPE_UNKNOWN;
     }
 }
 
 void SemanticAnalyzer::semanticError(const std::string &msg) {
-    std::cerr << "\n[SemanticError] " << msg << std::endl;
-    exit(1);
+    diagnostics->error("SemanticError", msg);
 }
-
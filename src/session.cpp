@@ -0,0 +1,73 @@
+#include "session.hpp"
+#include <cstdint>
+#include <cstdlib>
+
+Arena::Arena(size_t firstBlock)
+    : nextBlock(firstBlock)
+{
+}
+
+Arena::~Arena()
+{
+    for (Cleanup *cleanup = cleanups; cleanup; cleanup = cleanup->next)
+    {
+        cleanup->destroy(cleanup->object);
+    }
+    while (blocks)
+    {
+        Block *previous = blocks->previous;
+        std::free(blocks);
+        blocks = previous;
+    }
+}
+
+void Arena::grow(size_t atLeast)
+{
+    size_t size = nextBlock;
+    while (size < atLeast + sizeof(Block) + alignof(std::max_align_t))
+    {
+        size *= 2;
+    }
+    Block *block = (Block *)std::malloc(size);
+    if (!block)
+    {
+        throw std::bad_alloc();
+    }
+    block->previous = blocks;
+    block->size = size;
+    blocks = block;
+    cursor = (char *)(block + 1);
+    limit = (char *)block + size;
+    reservedBytes += size;
+    nextBlock = size * 2;
+}
+
+void *Arena::do_allocate(size_t bytes, size_t alignment)
+{
+    char *start = (char *)(((uintptr_t)cursor + alignment - 1) & ~(uintptr_t)(alignment - 1));
+    if (!cursor || start + bytes > limit)
+    {
+        grow(bytes + alignment);
+        start = (char *)(((uintptr_t)cursor + alignment - 1) & ~(uintptr_t)(alignment - 1));
+    }
+    cursor = start + bytes;
+    usedBytes += bytes;
+    return start;
+}
+
+void Arena::addCleanup(void *object, void (*destroy)(void *))
+{
+    Cleanup *cleanup = new (allocate(sizeof(Cleanup), alignof(Cleanup))) Cleanup{cleanups, object, destroy};
+    cleanups = cleanup;
+}
+
+std::string *CompilationSession::text(std::string_view value)
+{
+    std::string *copy = new (arena.allocate(sizeof(std::string), alignof(std::string))) std::string(value);
+    if (copy->capacity() > std::string().capacity())
+    {
+        // spilled to the heap; its destructor has to run
+        arena.adopt(copy);
+    }
+    return copy;
+}
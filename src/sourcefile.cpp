@@ -0,0 +1,130 @@
+#include "sourcefile.hpp"
+
+#ifdef _WIN32
+#include <fstream>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+SourceFile::~SourceFile()
+{
+    close();
+}
+
+#ifdef _WIN32
+
+bool SourceFile::open(const std::string &path)
+{
+    close();
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                              nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+    {
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        const void *view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (view)
+        {
+            fileHandle = file;
+            mappingHandle = mapping;
+            data = (const char *)view;
+            length = (size_t)size.QuadPart;
+            mapped = true;
+            return true;
+        }
+        if (mapping)
+        {
+            CloseHandle(mapping);
+        }
+    }
+    CloseHandle(file);
+
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+    {
+        return false;
+    }
+    buffer.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    data = buffer.data();
+    length = buffer.size();
+    return true;
+}
+
+void SourceFile::close()
+{
+    if (mapped)
+    {
+        UnmapViewOfFile(data);
+        CloseHandle(mappingHandle);
+        CloseHandle(fileHandle);
+        mappingHandle = fileHandle = nullptr;
+    }
+    buffer.clear();
+    data = nullptr;
+    length = 0;
+    mapped = false;
+}
+
+#else
+
+bool SourceFile::open(const std::string &path)
+{
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0)
+    {
+        void *view = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (view != MAP_FAILED)
+        {
+            ::close(fd); // the mapping keeps the file alive
+            data = (const char *)view;
+            length = info.st_size;
+            mapped = true;
+            return true;
+        }
+    }
+
+    // empty files, pipes and filesystems without mmap support
+    char chunk[1 << 16];
+    ssize_t got;
+    while ((got = ::read(fd, chunk, sizeof(chunk))) > 0)
+    {
+        buffer.append(chunk, got);
+    }
+    ::close(fd);
+    if (got < 0)
+    {
+        buffer.clear();
+        return false;
+    }
+    data = buffer.data();
+    length = buffer.size();
+    return true;
+}
+
+void SourceFile::close()
+{
+    if (mapped)
+    {
+        munmap((void *)data, length);
+    }
+    buffer.clear();
+    data = nullptr;
+    length = 0;
+    mapped = false;
+}
+
+#endif
@@ -0,0 +1,119 @@
+#include "symbols.hpp"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+namespace {
+
+constexpr size_t SHARD_COUNT = 16;
+constexpr size_t SEGMENT_BITS = 12;
+constexpr size_t SEGMENT_SIZE = size_t(1) << SEGMENT_BITS;
+constexpr size_t MAX_SEGMENTS = 4096; // 16M symbols
+
+struct Slot {
+    uint64_t hash;
+    Symbol symbol; // 0 while the slot is free
+};
+
+// Open-addressed table from name to id, for the names whose hash selects this shard.
+struct Shard {
+    std::mutex lock;
+    std::vector<Slot> slots = std::vector<Slot>(64, Slot{0, 0});
+    size_t used = 0;
+};
+
+struct Table {
+    Shard shards[SHARD_COUNT];
+    // Names by id, in fixed-size segments that never move once allocated.
+    std::atomic<std::string *> segments[MAX_SEGMENTS] = {};
+    std::mutex growing;
+    std::atomic<Symbol> next{1};
+
+    Table()
+    {
+        segments[0] = new std::string[SEGMENT_SIZE];
+    }
+
+    std::string &slotFor(Symbol symbol)
+    {
+        size_t segment = symbol >> SEGMENT_BITS;
+        std::string *names = segments[segment].load(std::memory_order_acquire);
+        if (!names)
+        {
+            std::lock_guard<std::mutex> guard(growing);
+            names = segments[segment].load(std::memory_order_relaxed);
+            if (!names)
+            {
+                names = new std::string[SEGMENT_SIZE];
+                segments[segment].store(names, std::memory_order_release);
+            }
+        }
+        return names[symbol & (SEGMENT_SIZE - 1)];
+    }
+};
+
+// Never destroyed: names handed out must stay valid through static destruction.
+Table &table()
+{
+    static Table *instance = new Table();
+    return *instance;
+}
+
+void grow(Shard &shard)
+{
+    std::vector<Slot> old(shard.slots.size() * 2, Slot{0, 0});
+    old.swap(shard.slots);
+    size_t mask = shard.slots.size() - 1;
+    for (const Slot &slot : old)
+    {
+        if (!slot.symbol)
+        {
+            continue;
+        }
+        size_t at = slot.hash & mask;
+        while (shard.slots[at].symbol)
+        {
+            at = (at + 1) & mask;
+        }
+        shard.slots[at] = slot;
+    }
+}
+
+} // namespace
+
+Symbol Symbols::intern(std::string_view name)
+{
+    Table &names = table();
+    uint64_t hash = std::hash<std::string_view>()(name);
+    Shard &shard = names.shards[(hash >> 59) & (SHARD_COUNT - 1)];
+    std::lock_guard<std::mutex> guard(shard.lock);
+    size_t mask = shard.slots.size() - 1;
+    size_t at = hash & mask;
+    for (; shard.slots[at].symbol; at = (at + 1) & mask)
+    {
+        const Slot &slot = shard.slots[at];
+        if (slot.hash == hash && Symbols::name(slot.symbol) == name)
+        {
+            return slot.symbol;
+        }
+    }
+    Symbol symbol = names.next.fetch_add(1);
+    names.slotFor(symbol).assign(name);
+    shard.slots[at] = {hash, symbol};
+    if (++shard.used * 2 > shard.slots.size())
+    {
+        grow(shard);
+    }
+    return symbol;
+}
+
+const std::string &Symbols::name(Symbol symbol)
+{
+    return table().segments[symbol >> SEGMENT_BITS].load(std::memory_order_acquire)[symbol & (SEGMENT_SIZE - 1)];
+}
+
+size_t Symbols::count()
+{
+    return table().next.load();
+}
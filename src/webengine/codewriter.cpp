@@ -0,0 +1,142 @@
+#include "codewriter.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+#ifndef _WIN32
+#include <climits>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+void CodeWriter::grow(size_t needed)
+{
+    Chunk chunk;
+    chunk.capacity = std::max(nextChunk, needed);
+    nextChunk = std::min(nextChunk * 2, CHUNK);
+    chunk.data = std::make_unique<char[]>(chunk.capacity);
+    chunks.push_back(std::move(chunk));
+}
+
+void CodeWriter::append(CodeWriter &&other)
+{
+    if (other.empty())
+    {
+        return;
+    }
+    // Later writes go on in the last spliced chunk; the spare room left in our
+    // own last chunk is given up.
+    for (Chunk &chunk : other.chunks)
+    {
+        chunks.push_back(std::move(chunk));
+    }
+    bytes += other.bytes;
+    other.chunks.clear();
+    other.bytes = 0;
+}
+
+std::string CodeWriter::str() const
+{
+    std::string out;
+    out.reserve(bytes);
+    for (const Chunk &chunk : chunks)
+    {
+        out.append(chunk.data.get(), chunk.used);
+    }
+    return out;
+}
+
+bool CodeWriter::writeIfChanged(const std::string &path) const
+{
+    std::error_code error;
+    if (std::filesystem::file_size(path, error) == bytes && !error)
+    {
+        std::ifstream in(path, std::ios::binary);
+        std::vector<char> held;
+        bool same = true;
+        for (const Chunk &chunk : chunks)
+        {
+            held.resize(std::max(held.size(), chunk.used));
+            if (!in.read(held.data(), chunk.used) || !std::equal(held.data(), held.data() + chunk.used, chunk.data.get()))
+            {
+                same = false;
+                break;
+            }
+        }
+        if (same)
+        {
+            return true;
+        }
+    }
+    return writeTo(path);
+}
+
+#ifdef _WIN32
+
+bool CodeWriter::writeTo(const std::string &path) const
+{
+    std::error_code error;
+    std::filesystem::path file(path);
+    if (file.has_parent_path())
+    {
+        std::filesystem::create_directories(file.parent_path(), error);
+    }
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    for (const Chunk &chunk : chunks)
+    {
+        out.write(chunk.data.get(), chunk.used);
+    }
+    return bool(out);
+}
+
+#else
+
+bool CodeWriter::writeTo(const std::string &path) const
+{
+    std::error_code error;
+    std::filesystem::path file(path);
+    if (file.has_parent_path())
+    {
+        std::filesystem::create_directories(file.parent_path(), error);
+    }
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        return false;
+    }
+    std::vector<iovec> pieces;
+    pieces.reserve(chunks.size());
+    for (const Chunk &chunk : chunks)
+    {
+        if (chunk.used)
+        {
+            pieces.push_back({chunk.data.get(), chunk.used});
+        }
+    }
+    // writev takes at most IOV_MAX pieces and may stop part way through one
+    size_t next = 0;
+    while (next < pieces.size())
+    {
+        int count = (int)std::min<size_t>(pieces.size() - next, IOV_MAX);
+        ssize_t written = ::writev(fd, &pieces[next], count);
+        if (written < 0)
+        {
+            ::close(fd);
+            return false;
+        }
+        while (next < pieces.size() && (size_t)written >= pieces[next].iov_len)
+        {
+            written -= pieces[next].iov_len;
+            next++;
+        }
+        if (written > 0)
+        {
+            pieces[next].iov_base = (char *)pieces[next].iov_base + written;
+            pieces[next].iov_len -= written;
+        }
+    }
+    return ::close(fd) == 0;
+}
+
+#endif
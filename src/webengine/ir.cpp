@@ -0,0 +1,198 @@
+#include "ir.hpp"
+#include "irpasses.hpp"
+#include <sstream>
+
+const std::string *IrExpr::literal() const
+{
+    if (values.size() != 1 || values[0].op != VALUE_CONST || values[0].type != TYPE_STRING)
+    {
+        return nullptr;
+    }
+    return &values[0].text;
+}
+
+void PassManager::add(std::unique_ptr<IrPass> pass)
+{
+    passes.push_back(std::move(pass));
+}
+
+void PassManager::run(IrPage &page)
+{
+    for (std::unique_ptr<IrPass> &pass : passes)
+    {
+        pass->run(page);
+    }
+}
+
+PassManager PassManager::standard()
+{
+    PassManager manager;
+    manager.add(std::make_unique<FoldStrings>());
+    manager.add(std::make_unique<HoistStatic>());
+    manager.add(std::make_unique<StateMasks>());
+    return manager;
+}
+
+std::string cppLiteral(const std::string &text)
+{
+    std::string out = "\"";
+    out.reserve(text.size() + 2);
+    for (char c : text)
+    {
+        switch (c)
+        {
+            case '\\': out += "\\\\"; break;
+            case '\"': out += "\\\""; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default: out += c; break;
+        }
+    }
+    return out + "\"";
+}
+
+std::string maskLiteral(uint64_t mask)
+{
+    if (mask == ~uint64_t(0))
+    {
+        return "~0ull";
+    }
+    std::stringstream ss;
+    ss << "0x" << std::hex << mask;
+    return ss.str();
+}
+
+static void print(const IrExpr &expr, uint32_t at, CodeWriter &out)
+{
+    const IrValue &value = expr.values[at];
+    switch (value.op)
+    {
+        case VALUE_CONST:
+            if (value.type == TYPE_STRING)
+            {
+                out << "string(" << cppLiteral(value.text) << ")";
+            }
+            else
+            {
+                out << value.text;
+            }
+            break;
+        case VALUE_NAME:
+            out << value.text;
+            break;
+        case VALUE_STATE:
+            out << value.text << "->get()";
+            break;
+        case VALUE_BINARY:
+            out << "(";
+            print(expr, value.operands[0], out);
+            out << " " << value.text << " ";
+            print(expr, value.operands[1], out);
+            out << ")";
+            break;
+        case VALUE_POSTFIX:
+            print(expr, value.operands[0], out);
+            out << value.text;
+            break;
+        case VALUE_CALL:
+            out << value.text << "(";
+            for (size_t i = 0; i < value.operands.size(); i++)
+            {
+                out << (i ? ", " : "");
+                print(expr, value.operands[i], out);
+            }
+            out << ")";
+            break;
+    }
+}
+
+CodeWriter &operator<<(CodeWriter &out, const IrExpr &expr)
+{
+    if (!expr.empty())
+    {
+        print(expr, expr.result(), out);
+    }
+    return out;
+}
+
+CodeWriter &operator<<(CodeWriter &out, const IrArgument &argument)
+{
+    const std::string *text = argument.expr.literal();
+    return text ? out << cppLiteral(*text) : out << argument.expr;
+}
+
+std::string printExpr(const IrExpr &expr)
+{
+    CodeWriter out;
+    out << expr;
+    return out.str();
+}
+
+static void print(const IrOp &op, CodeWriter &out)
+{
+    switch (op.kind)
+    {
+        case IR_RAW:
+            out << op.name;
+            break;
+        case IR_STATE:
+            out << "\n\tauto " << op.name << " = make_shared<appstate::State<" << op.key << ">>(\"" << op.name << "\","
+                << IrArgument{op.value} << ");";
+            break;
+        case IR_ELEMENT:
+            if (op.value.empty())
+            {
+                out << "\n\tVNode " << op.name << "(\"" << op.key << "\");\n";
+            }
+            else
+            {
+                out << "\n\t\tVNode " << op.name << "(\"" << op.key << "\"," << IrArgument{op.value} << ");\n";
+            }
+            break;
+        case IR_ATTR:
+            out << "\t\t" << op.name << ".setAttr(\"" << op.key << "\", " << IrArgument{op.value} << ");\n";
+            break;
+        case IR_FIELD:
+            out << "\t\t" << op.name << "." << op.key << " = " << IrArgument{op.value} << ";\n";
+            break;
+        case IR_CLICK:
+            out << "\t" << op.name << ".onClick([";
+            for (size_t i = 0; i < op.captures.size(); i++)
+            {
+                out << (i ? ", " : "") << op.captures[i];
+            }
+            out << "]() {\n";
+            for (const IrOp &statement : op.body)
+            {
+                out << "\t\t";
+                print(statement, out);
+                out << "\n";
+            }
+            out << "\t\tupdateUI(" << maskLiteral(op.mask) << ");\t});\n";
+            break;
+        case IR_APPEND:
+            out << "\n\t" << op.key << ".addChild(" << op.name << ");";
+            break;
+        case IR_SECTION:
+            out << "\n\t\tif (page.section(" << op.index << ", " << maskLiteral(op.mask) << ")) {";
+            for (const IrOp &inner : op.body)
+            {
+                print(inner, out);
+            }
+            out << "\n\t\t}";
+            break;
+        case IR_STATIC:
+            out << "\n\tstatic constexpr char " << op.name << "[] = " << IrArgument{op.value} << ";"
+                << "\n\t" << op.key << ".addChild(VNode::prerendered(" << op.name << "));";
+            break;
+    }
+}
+
+void printOps(const std::vector<IrOp> &ops, CodeWriter &out)
+{
+    for (const IrOp &op : ops)
+    {
+        print(op, out);
+    }
+}
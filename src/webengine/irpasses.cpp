@@ -0,0 +1,279 @@
+#include "irpasses.hpp"
+#include <algorithm>
+#include <utility>
+
+static constexpr uint64_t ALL_STATE = ~uint64_t(0); // past 64 states, or unknown
+
+static bool isString(const IrValue &value)
+{
+    return value.op == VALUE_CONST && value.type == TYPE_STRING;
+}
+
+// Copies the value at `at` and what it uses into `to`, joining string
+// constants on the way, and returns where it landed: always the last value of
+// `to`, so a join only ever drops the value just pushed.
+static uint32_t fold(const IrExpr &from, uint32_t at, IrExpr &to)
+{
+    IrValue value = from.values[at];
+    for (uint32_t &operand : value.operands)
+    {
+        operand = fold(from, operand, to);
+    }
+    if (value.op == VALUE_BINARY && value.text == "+" && isString(to.values[value.operands[1]]))
+    {
+        IrValue &lhs = to.values[value.operands[0]];
+        std::string rhs = to.values[value.operands[1]].text;
+        // "a" + "b" is "ab", and (x + "a") + "b" is x + "ab"
+        if (isString(lhs))
+        {
+            lhs.text += rhs;
+            to.values.pop_back();
+            return value.operands[0];
+        }
+        if (lhs.op == VALUE_BINARY && lhs.text == "+" && isString(to.values[lhs.operands[1]]))
+        {
+            to.values[lhs.operands[1]].text += rhs;
+            to.values.pop_back();
+            return value.operands[0];
+        }
+    }
+    return to.push(std::move(value));
+}
+
+static void fold(std::vector<IrOp> &ops)
+{
+    for (IrOp &op : ops)
+    {
+        if (!op.value.empty())
+        {
+            IrExpr folded;
+            fold(op.value, op.value.result(), folded);
+            op.value = std::move(folded);
+        }
+        fold(op.body);
+    }
+}
+
+void FoldStrings::run(IrPage &page)
+{
+    fold(page.ops);
+}
+
+static constexpr size_t NO_END = SIZE_MAX;
+
+// The IR_APPEND closing the element opened at `at`; NO_END for an element kept
+// in a variable, which is never appended.
+static size_t elementEnd(const std::vector<IrOp> &ops, size_t at)
+{
+    for (size_t i = at + 1; i < ops.size(); i++)
+    {
+        if (ops[i].kind == IR_APPEND && ops[i].name == ops[at].name)
+        {
+            return i;
+        }
+    }
+    return NO_END;
+}
+
+static bool isConstant(const IrExpr &expr)
+{
+    return expr.values.size() == 1 && expr.values[0].op == VALUE_CONST;
+}
+
+// Appends the markup of the element ops[at..end] to `html`, or returns false
+// if anything in it is only known at run time. Same output as renderToHTML:
+// id first, then the other attributes, text, children.
+static bool serialize(const std::vector<IrOp> &ops, size_t at, size_t end, std::string &html)
+{
+    const IrOp &element = ops[at];
+    const std::string *text = element.value.empty() ? nullptr : element.value.literal();
+    if (!element.value.empty() && !text)
+    {
+        return false;
+    }
+    std::vector<std::pair<std::string, std::string>> attrs;
+    std::string children;
+    for (size_t i = at + 1; i < end; i++)
+    {
+        const IrOp &op = ops[i];
+        switch (op.kind)
+        {
+            case IR_ATTR: {
+                const std::string *value = op.value.literal();
+                if (!value || op.name != element.name)
+                {
+                    return false;
+                }
+                auto same = std::find_if(attrs.begin(), attrs.end(), [&op](const auto &attr) { return attr.first == op.key; });
+                if (same != attrs.end())
+                {
+                    same->second = *value;
+                }
+                else
+                {
+                    attrs.emplace_back(op.key, *value);
+                }
+                break;
+            }
+            case IR_FIELD:
+                // width and height only show on a canvas
+                if (op.key == "type" || !isConstant(op.value))
+                {
+                    return false;
+                }
+                break;
+            case IR_ELEMENT: {
+                size_t childEnd = elementEnd(ops, i);
+                if (childEnd >= end || !serialize(ops, i, childEnd, children))
+                {
+                    return false;
+                }
+                i = childEnd;
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+    std::stable_partition(attrs.begin(), attrs.end(), [](const auto &attr) { return attr.first == "id"; });
+    html += "<" + element.key;
+    for (const auto &[key, value] : attrs)
+    {
+        html += " " + key + "=\"" + value + "\"";
+    }
+    html += ">";
+    if (text)
+    {
+        html += *text;
+    }
+    html += children + "</" + element.key + ">";
+    return true;
+}
+
+static void hoist(std::vector<IrOp> &ops)
+{
+    for (size_t i = 0; i < ops.size(); i++)
+    {
+        if (ops[i].kind == IR_SECTION)
+        {
+            hoist(ops[i].body);
+            continue;
+        }
+        if (ops[i].kind != IR_ELEMENT)
+        {
+            continue;
+        }
+        // a dynamic element can still have static children; they come up next
+        size_t end = elementEnd(ops, i);
+        std::string html;
+        if (end == NO_END || !serialize(ops, i, end, html))
+        {
+            continue;
+        }
+        IrOp fragment{IR_STATIC, ops[i].name + "_html", ops[end].key};
+        fragment.value.push({VALUE_CONST, TYPE_STRING, std::move(html)});
+        ops[i] = std::move(fragment);
+        ops.erase(ops.begin() + i + 1, ops.begin() + end + 1);
+    }
+}
+
+void HoistStatic::run(IrPage &page)
+{
+    hoist(page.ops);
+}
+
+void StateMasks::run(IrPage &page)
+{
+    dependencies.clear();
+    states = 0;
+    assign(page.ops);
+}
+
+void StateMasks::assign(std::vector<IrOp> &ops)
+{
+    for (IrOp &op : ops)
+    {
+        switch (op.kind)
+        {
+            case IR_STATE:
+                dependencies[op.symbol] = states < 64 ? uint64_t(1) << states : ALL_STATE;
+                states++;
+                break;
+            case IR_RAW:
+                if (op.symbol)
+                {
+                    dependencies[op.symbol] |= reads(op);
+                }
+                break;
+            case IR_CLICK:
+                op.mask = writes(op);
+                break;
+            case IR_SECTION:
+                assign(op.body);
+                op.mask = reads(op);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+uint64_t StateMasks::reads(const IrExpr &expr) const
+{
+    uint64_t mask = 0;
+    for (const IrValue &value : expr.values)
+    {
+        if (value.op == VALUE_STATE || (value.op == VALUE_NAME && value.symbol))
+        {
+            const uint64_t *bits = dependencies.find(value.symbol);
+            mask |= bits ? *bits : value.op == VALUE_STATE ? ALL_STATE : 0;
+        }
+    }
+    return mask;
+}
+
+// A click's body runs later, so building the op itself reads nothing.
+uint64_t StateMasks::reads(const IrOp &op) const
+{
+    switch (op.kind)
+    {
+        case IR_RAW: {
+            if (op.opaque)
+            {
+                return ALL_STATE;
+            }
+            uint64_t mask = 0;
+            for (Symbol name : op.uses)
+            {
+                const uint64_t *bits = dependencies.find(name);
+                mask |= bits ? *bits : 0;
+            }
+            return mask;
+        }
+        case IR_ELEMENT:
+        case IR_ATTR:
+        case IR_FIELD:
+            return reads(op.value);
+        case IR_SECTION: {
+            uint64_t mask = 0;
+            for (const IrOp &inner : op.body)
+            {
+                mask |= reads(inner);
+            }
+            return mask;
+        }
+        default:
+            return 0;
+    }
+}
+
+uint64_t StateMasks::writes(const IrOp &op) const
+{
+    uint64_t mask = 0;
+    for (Symbol state : op.uses)
+    {
+        const uint64_t *bits = dependencies.find(state);
+        mask |= bits ? *bits : ALL_STATE;
+    }
+    return mask;
+}
@@ -18,175 +18,436 @@ WebEngine::WebEngine()
 }
 
 
-string WebEngine::pyxtocpp_type(enum NODE_TYPE type, AST_NODE* node) {
-    switch (type)
+// C++ spelling of the type analysis resolved for `node`.
+string WebEngine::cppType(AstNode node) {
+    switch (node.resolvedType())
     {
-        case NODE_BINARY_OP: {
-            string lhs = pyxtocpp_type(node->SUB_STATEMENTS[0]->TYPE, node->SUB_STATEMENTS[0]); 
-            return lhs;
-        }
-        case NODE_BOOL:
+        case TYPE_BOOL:
             return "bool";
-        case NODE_INT:
+        case TYPE_INT:
             return "int";
-        case NODE_STRING:
-            return "string";
-        case NODE_DICT:
-            return "unordered_map<string,string>";
-        case NODE_TOFLOAT:
+        case TYPE_FLOAT:
             return "float";
-        case NODE_TOINT:
-            return "int";
-        case NODE_TOSTR:
+        case TYPE_STRING:
             return "string";
+        case TYPE_DICT:
+            return "unordered_map<string,string>";
         default:
-            cerr << "Error unknown Type\n";
-            break;
+            return "auto";
     }
-    
-    return "//error";
 }
 
-bool WebEngine::gen(AST_NODE *root) {
-    filebuffer << "#include <iostream>\n";
-    filebuffer << "#include \"vdom.hpp\"\n";
-    filebuffer << "#include <format>\n";
-    filebuffer << "#include <cmath>\n";
-    filebuffer << "using namespace std;\n\n";
-
-    filebuffer << R"(void updateUI() {
-        // Re-render the current page
-        if (GlobalState::getCurrentPage()) {
-            GlobalState::getCurrentPage()->render();
-        }
-    })";
+bool WebEngine::gen(const Ast &ast) {
+    planUnits(ast);
 
-    stringstream codebuffer;
+    CodeWriter codebuffer;
 
     codebuffer << "\n";
 
     // Top-level: convert each root sub-statement into C++ statements
-    for (auto &stmt : root->SUB_STATEMENTS) {
-        string out = HandleAst(stmt, "root", true, false);
-        if (!out.empty()) {
-            codebuffer << out << "\n";
+    for (AstNode stmt : ast.root().subs()) {
+        size_t before = codebuffer.size();
+        HandleAst(stmt, codebuffer, "root", true, false);
+        if (codebuffer.size() != before) {
+            codebuffer << "\n";
         }
     }
-    filebuffer << "int main() {" << mainbuffer.str() << codebuffer.str();
-    filebuffer << "\tEM_ASM({\n\t\tModule._handleRoute(allocateUTF8(window.location.pathname));\n\t\twindow.addEventListener(\"popstate\", () => {\n\t\tModule._handleRoute(allocateUTF8(window.location.pathname));\n\t\t});\n\t});return 0;\n}\n";
 
-    
+    CodeWriter header;
+    header << "#pragma once\n";
+    header << "#include <iostream>\n";
+    header << "#include \"vdom.hpp\"\n";
+    header << "#include <format>\n";
+    header << "#include <cmath>\n";
+    header << "using namespace std;\n\n";
+
+    header << R"(inline void updateUI(uint64_t changed = ~0ull) {
+        // Re-render the current page, rebuilding the sections that read `changed` state
+        if (GlobalState::getCurrentPage()) {
+            GlobalState::getCurrentPage()->render(changed);
+        }
+    })";
+    header << "\n";
+    header.append(std::move(headerbuffer));
+
+    CodeWriter app;
+    app << "#include \"app.hpp\"\n";
+    vector<Symbol> globals;
+    for (const auto &[name, type] : hoisted) {
+        app << type << " " << Symbols::name(name) << ";\n";
+        globals.push_back(name);
+    }
+    app.append(std::move(filebuffer));
+    app << "int main() {";
+    declareGlobals(globals, app);
+    app.append(std::move(mainbuffer));
+    app.append(std::move(codebuffer));
+    app << "\tEM_ASM({\n\t\tModule._handleRoute(allocateUTF8(window.location.pathname));\n\t\twindow.addEventListener(\"popstate\", () => {\n\t\tModule._handleRoute(allocateUTF8(window.location.pathname));\n\t\t});\n\t});return 0;\n}\n";
+
+
 
 
     for (const auto &pair : variable_buffer) {
-        cout << pair.first << " <=> " << pair.second << endl;
+        cout << Symbols::name(pair.first) << " <=> " << pair.second << endl;
     }
-    return makefile("web/generated.cpp", filebuffer.str());
-}
 
+    // A unit whose text is unchanged keeps its timestamp, so the builder
+    // recompiles only the pages that changed.
+    if (!header.writeIfChanged("web/gen/app.hpp") || !app.writeIfChanged("web/gen/app.cpp")) {
+        cerr << "could not write web/gen" << endl;
+        return false;
+    }
+    units.push_back("web/gen/app.cpp");
+    for (const auto &[name, code] : pagefiles) {
+        string path = "web/gen/pages/" + name + ".cpp";
+        if (!code.writeIfChanged(path)) {
+            cerr << "could not write " << path << endl;
+            return false;
+        }
+        units.push_back(path);
+    }
+    // a page that is gone takes its unit with it
+    error_code error;
+    for (const auto &entry : filesystem::directory_iterator("web/gen/pages", error)) {
+        if (find(units.begin(), units.end(), "web/gen/pages/" + entry.path().filename().string()) == units.end()) {
+            filesystem::remove(entry.path(), error);
+        }
+    }
+    return true;
+}
 
-// Escape C-style string literal (for embedding fixed literal pieces in generated C++ code)
-string WebEngine::escape_for_cpp_literal(const string &in) {
-    string out;
-    out.reserve(in.size()*2);
-    for (char c : in) {
-        switch (c) {
-            case '\\': out += "\\\\"; break;
-            case '\"': out += "\\\""; break;
-            case '\n': out += "\\n"; break;
-            case '\r': out += "\\r"; break;
-            case '\t': out += "\\t"; break;
-            default: out += c; break;
+void WebEngine::planUnits(const Ast &ast) {
+    SymbolMap<string> globals; // root variables so far; "" for a type that can't be spelled
+    SymbolSet stylesheets;     // universal ones, which every later page adds
+    for (AstNode stmt : ast.root().subs()) {
+        if (!stmt) continue;
+        AstNode page;
+        if (stmt.type() == NODE_page) {
+            page = stmt;
+        } else if (stmt.type() == NODE_VARIABLE && stmt.child() && stmt.child().type() == NODE_page) {
+            page = stmt.child();
+        }
+        if (page) {
+            SymbolSet names = stylesheets;
+            collectNames(page, names);
+            bool spelled = all_of(names.begin(), names.end(), [&globals](Symbol name) {
+                const string *type = globals.find(name);
+                return !type || !type->empty();
+            });
+            if (spelled) {
+                vector<Symbol> &reads = pageunits[page.id()];
+                for (Symbol name : names) {
+                    if (const string *type = globals.find(name)) {
+                        hoisted[name] = *type;
+                        reads.push_back(name);
+                    }
+                }
+            }
         }
+        if (stmt.type() == NODE_STYLESHEET) {
+            globals[stmt.symbol()] = "string";
+            if (stmt.child()) {
+                stylesheets.insert(stmt.symbol());
+            }
+        } else if (stmt.type() == NODE_VARIABLE && stmt.child() && !stmt.isState() && !globals.contains(stmt.symbol())) {
+            globals[stmt.symbol()] = globalType(stmt);
+        }
+    }
+}
+
+// Block-scope redeclarations of hoisted variables. Inside the block they hide
+// what `using namespace std` brings in, as main()'s locals used to: a global
+// named count is not std::count there.
+void WebEngine::declareGlobals(const vector<Symbol> &names, CodeWriter &out) {
+    for (Symbol name : names) {
+        out << "\n\textern " << *hoisted.find(name) << " " << Symbols::name(name) << ";";
     }
-    return out;
 }
 
-// Helper to create a C++ literal: "\"...\""
-string WebEngine::cpp_literal(const string &s) {
-    return "\"" + escape_for_cpp_literal(s) + "\"";
+// C++ type of the root variable `p` declares; "" unless HandleAst declares it
+// as `type name = value`.
+string WebEngine::globalType(AstNode p) {
+    NODE_TYPE dtype = p.child().type();
+    string el, eltype;
+    if (dtype == NODE_DICT) {
+        return "unordered_map<string,string>";
+    }
+    if (dtype == NODE_page || (dtype != NODE_CANVAS && elementKind(dtype, el, eltype)) ||
+        dtype == NODE_TOINT || dtype == NODE_TOFLOAT || dtype == NODE_TOSTR ||
+        dtype == NODE_DRAW || dtype == NODE_PLATFORM_CLS) {
+        return "";
+    }
+    string type = cppType(p.child());
+    return type == "auto" ? "" : type;
+}
+
+// Every variable `p` mentions, callback bodies included: a page builder may
+// read any of them whenever it runs.
+void WebEngine::collectNames(AstNode p, SymbolSet &names) {
+    if (!p) return;
+    if (p.type() == NODE_VARIABLE || p.type() == NODE_INSTANCE) {
+        names.insert(p.symbol());
+    }
+    collectNames(p.child(), names);
+    for (AstNode sub : p.subs()) {
+        collectNames(sub, names);
+    }
 }
 
-string WebEngine::exprForNode(AST_NODE *p) {
-    if (!p) return string("/*null*/");
 
-    switch (p->TYPE) {
+// Appends `p` to `expr` a value at a time and returns the value it ends in.
+uint32_t WebEngine::lowerExpr(AstNode p, IrExpr &expr) {
+    if (!p) return expr.push({VALUE_NAME, TYPE_UNKNOWN, "/*null*/"});
+
+    IrValue value{VALUE_NAME, p.resolvedType()};
+    switch (p.type()) {
         case NODE_STRING:
-            return "string(" + cpp_literal(*(p->value)) + ")";
+            value.op = VALUE_CONST;
+            value.type = TYPE_STRING;
+            value.text = p.value();
+            break;
         case NODE_FLOAT:
         case NODE_INT:
-            return *(p->value);
+            value.op = VALUE_CONST;
+            value.type = p.type() == NODE_INT ? TYPE_INT : TYPE_FLOAT;
+            value.text = p.value();
+            break;
         case NODE_VARIABLE:
-            // use variable name directly — assumes the generated C++ defines this name earlier
-            return HandleAst(p, "root", true);
+            if (p.child()) {
+                CodeWriter text;
+                HandleAst(p, text, "root", true);
+                value.text = text.str();
+                break;
+            }
+            value.op = p.isState() ? VALUE_STATE : VALUE_NAME;
+            value.text = p.value();
+            value.symbol = p.symbol();
+            break;
         case NODE_BOOL:
-        case NODE_BINARY_OP: {
-            string lhs = exprForNode(p->SUB_STATEMENTS[0]);
-            string rhs = exprForNode(p->SUB_STATEMENTS[1]);
-            string op = *(p->value);
-            return "(" + lhs + " " + op + " " + rhs + ")";
-        }
-
-        /*
-            def jd() {
-                return 5 + 3;
+            if (p.subCount() == 0) { // true / false
+                value.op = VALUE_CONST;
+                value.type = TYPE_BOOL;
+                value.text = p.value();
+                break;
             }
+            [[fallthrough]];
+        case NODE_BINARY_OP:
+            value.op = VALUE_BINARY;
+            value.text = p.value();
+            value.operands = {lowerExpr(p.subs()[0], expr), lowerExpr(p.subs()[1], expr)};
+            break;
+        case NODE_UNARY_OP:
+            value.op = VALUE_POSTFIX;
+            value.text = p.value();
+            value.operands = {lowerExpr(p.child(), expr)};
+            break;
+        case NODE_TOSTR:
+        case NODE_TOINT:
+        case NODE_TOFLOAT:
+            value.op = VALUE_CALL;
+            value.text = p.type() == NODE_TOSTR ? "to_string" : p.type() == NODE_TOINT ? "stoi" : "stof";
+            value.operands = {lowerExpr(p.child(), expr)};
+            break;
+        default:
+            break;
+    }
+    return expr.push(std::move(value));
+}
 
-        */
-        case NODE_UNARY_OP: {
-            string operand = exprForNode(p->CHILD);
-            string op = *(p->value);
-            
-            return operand  + op ;
+IrExpr WebEngine::lowerExpr(AstNode p) {
+    IrExpr expr;
+    lowerExpr(p, expr);
+    return expr;
+}
+
+// src, id and class: a string or variable as is, anything else as the text of
+// the expression.
+IrExpr WebEngine::lowerAttribute(AstNode p) {
+    if (p && (p.type() == NODE_STRING || p.type() == NODE_VARIABLE)) return lowerExpr(p);
+    IrExpr expr;
+    expr.push({VALUE_CONST, TYPE_STRING, printExpr(lowerExpr(p))});
+    return expr;
+}
+
+// A style dict as one string, "key:value;" per entry. String and variable
+// values are kept; numbers are spelled out with to_string.
+IrExpr WebEngine::lowerStyle(AstNode dict) {
+    IrExpr expr;
+    int64_t joined = -1;
+    auto append = [&](uint32_t piece) {
+        joined = joined < 0 ? piece : expr.push({VALUE_BINARY, TYPE_STRING, "+", 0, {uint32_t(joined), piece}});
+    };
+    for (AstNode kv : dict.subs()) {
+        string key = kv.subs()[0].value();
+        AstNode valNode = kv.subs()[1];
+        if (valNode.type() == NODE_STRING) {
+            append(expr.push({VALUE_CONST, TYPE_STRING, key + ":" + valNode.value() + ";"}));
+        } else if (valNode.type() == NODE_VARIABLE) {
+            append(expr.push({VALUE_CONST, TYPE_STRING, key + ":"}));
+            uint32_t value = lowerExpr(valNode, expr);
+            if (expr.values[value].type == TYPE_INT || expr.values[value].type == TYPE_FLOAT) {
+                value = expr.push({VALUE_CALL, TYPE_STRING, "to_string", 0, {value}});
+            }
+            append(value);
+            append(expr.push({VALUE_CONST, TYPE_STRING, ";"}));
         }
+    }
+    if (joined < 0) expr.push({VALUE_CONST, TYPE_STRING, ""});
+    return expr;
+}
+
+IrOp WebEngine::lowerState(AstNode p) {
+    IrOp op{IR_STATE, p.value(), cppType(p.child()), lowerExpr(p.child())};
+    op.symbol = p.symbol();
+    statevars.insert(p.symbol());
+    return op;
+}
+
+IrOp WebEngine::lowerStatement(AstNode p, string parent, bool funcdecl) {
+    CodeWriter text;
+    HandleAst(p, text, parent, funcdecl);
+    IrOp op{IR_RAW, text.str()};
+    if (p && p.type() == NODE_VARIABLE && p.child() && !p.isState()) {
+        op.symbol = p.symbol();
+        collectUses(p.child(), op);
+    } else {
+        collectUses(p, op);
+    }
+    return op;
+}
+
+// Names `p` reads as it runs. Callback bodies run later and don't count; calls
+// and platform queries may read anything.
+void WebEngine::collectUses(AstNode p, IrOp &op) {
+    if (!p) return;
+    switch (p.type()) {
+        case NODE_FUNCTION_DECL:
+            return;
+        case NODE_FUNCTION_CALL:
+        case NODE_INSTANCE:
+        case NODE_PLATFORM_CLS:
+        case NODE_DRAW:
+            op.opaque = true;
+            return;
+        case NODE_VARIABLE:
+            if (!p.child()) {
+                op.uses.push_back(p.symbol());
+                return;
+            }
+            break;
         default:
-            return MakeConversion(p, p->TYPE, false);
+            break;
+    }
+    collectUses(p.child(), op);
+    for (AstNode sub : p.subs()) {
+        collectUses(sub, op);
+    }
+}
+
+// States running `p` assigns.
+void WebEngine::collectWrites(AstNode p, vector<Symbol> &states) {
+    if (!p) return;
+    if (p.type() == NODE_VARIABLE && p.child() && p.isState()) {
+        states.push_back(p.symbol());
+    }
+    collectWrites(p.child(), states);
+    for (AstNode sub : p.subs()) {
+        collectWrites(sub, states);
+    }
+}
+
+// Whether running `p` can add an element to the page: it builds one somewhere
+// outside a callback.
+bool WebEngine::addsChildren(AstNode p) {
+    if (!p || p.type() == NODE_FUNCTION_DECL) return false;
+    string el, eltype;
+    if (elementKind(p.type(), el, eltype)) return true;
+    if (addsChildren(p.child())) return true;
+    for (AstNode sub : p.subs()) {
+        if (addsChildren(sub)) return true;
+    }
+    return false;
+}
+
+bool WebEngine::elementKind(NODE_TYPE type, string &el, string &eltype) {
+    switch (type) {
+        case NODE_VIEW: el = "div"; eltype = "view"; return true;
+        case NODE_TEXT: el = "p"; eltype = "text"; return true;
+        case NODE_IMAGE: el = "img"; eltype = "img"; return true;
+        case NODE_CANVAS: el = "canvas"; eltype = "canvas"; return true;
+        case NODE_INPUT: el = "input"; eltype = "input"; return true;
+        default: return false;
     }
 }
 
-string WebEngine::MakePage(AST_NODE *p, string var, bool firstpage) {
+// Operators print their own parentheses; a literal or variable condition needs them added.
+void WebEngine::conditionFor(AstNode p, CodeWriter &out) {
+    if (p && (p.type() == NODE_BINARY_OP || p.type() == NODE_BOOL) && p.subCount() == 2) {
+        out << lowerExpr(p);
+    } else {
+        out << "(" << lowerExpr(p) << ")";
+    }
+}
+
+void WebEngine::MakePage(AstNode p, string var, CodeWriter &ss, bool firstpage) {
             statevars.clear();
             string varid = var;
-            stringstream ss;
-            filebuffer << "\nauto "+varid+ " = make_shared<VPage>();\n";
-            ss << "\t"+varid+"->builder = [&";
+            // a page with a unit of its own is built by a function there, any
+            // other by a lambda in main()
+            auto unitreads = pageunits.find(p.id());
+            bool unit = unitreads != pageunits.end();
+            CodeWriter own;
+            CodeWriter &out = unit ? own : ss;
+            filebuffer << "\nauto " << varid << " = make_shared<VPage>();\n";
             vector<string> stylesheetimports;
-            if (!variable_buffer.empty()) {
+            for (const auto &pair : variable_buffer) {
+                if (pair.second == true) {
+                    stylesheetimports.push_back(Symbols::name(pair.first));
+                }
+            }
+            if (unit) {
+                headerbuffer << "void build_" << varid << "(VPage& page);\n";
+                ss << "\t" << varid << "->builder = build_" << varid << ";";
+                out << "#include \"app.hpp\"\n\nvoid build_" << varid << "(VPage& page) {";
+                declareGlobals(unitreads->second, out);
+                out << "\n";
+            } else {
+                ss << "\t" << varid << "->builder = [&";
                 for (const auto &pair : variable_buffer) {
-                    if (pair.second == true) {
-                        stylesheetimports.push_back(pair.first);
+                    // hoisted ones are at namespace scope, and can't be captured
+                    if (!hoisted.contains(pair.first)) {
+                        ss << ", " << Symbols::name(pair.first);
                     }
-                    ss << ", " << pair.first; 
                 }
+                ss << "](VPage& page) {\n";
             }
-            ss << "](VPage& page) {\n";
 
             for (const auto &imps : stylesheetimports) {
-                ss << "\t\tpage.addStyle(" << imps << ");\n";
-            }
-            AST_NODE *args = p->CHILD;
-            AST_NODE *styleParam = nullptr;
-            AST_NODE *idparam = nullptr;
-            AST_NODE *clsparam = nullptr;
-            AST_NODE *routeParam = nullptr;
-            AST_NODE *titleArg = nullptr;
-            if (args && !args->SUB_STATEMENTS.empty()) {
-                titleArg = args->SUB_STATEMENTS[0];
-                for (size_t i = 1; i < args->SUB_STATEMENTS.size(); ++i) {
-                    AST_NODE *param = args->SUB_STATEMENTS[i];
-                    if (param && param->TYPE == NODE_VARIABLE && param->value && *(param->value) == "style") {
+                out << "\t\tpage.addStyle(" << imps << ");\n";
+            }
+            AstNode args = p.child();
+            AstNode styleParam;
+            AstNode idparam;
+            AstNode clsparam;
+            AstNode routeParam;
+            AstNode titleArg;
+            if (args && !args.subs().empty()) {
+                titleArg = args.subs()[0];
+                for (size_t i = 1; i < args.subs().size(); ++i) {
+                    AstNode param = args.subs()[i];
+                    if (param && param.type() == NODE_VARIABLE && param.hasValue() && param.value() == "style") {
                         
                         styleParam = param; // styleParam->CHILD -> NODE_DICT
                     }
-                    if (param && param->TYPE == NODE_VARIABLE && param->value && *(param->value) == "route") {
+                    if (param && param.type() == NODE_VARIABLE && param.hasValue() && param.value() == "route") {
     
                         routeParam = param; // styleParam->CHILD -> NODE_DICT
                     }
-                    if (param && param->TYPE == NODE_VARIABLE && param->value && *(param->value) == "cls") {
+                    if (param && param.type() == NODE_VARIABLE && param.hasValue() && param.value() == "cls") {
                     
                         clsparam = param; // styleParam->CHILD -> NODE_DICT
                     }
-                    if (param && param->TYPE == NODE_VARIABLE && param->value && *(param->value) == "id") {
+                    if (param && param.type() == NODE_VARIABLE && param.hasValue() && param.value() == "id") {
                         idparam = param; // styleParam->CHILD -> NODE_DICT
                     }
                 }
@@ -194,609 +455,487 @@ string WebEngine::MakePage(AST_NODE *p, string var, bool firstpage) {
 
             if (routeParam) {
                 // Router::add("/", page_1);
-                mainbuffer << "\n\tRouter::add(\""+*(routeParam->CHILD->value) + "\","+ varid +");";
+                mainbuffer << "\n\tRouter::add(\"" << routeParam.child().value() << "\"," << varid << ");";
             } else {
-                mainbuffer << "\n\tRouter::add(\"/\","+ varid +");";
+                mainbuffer << "\n\tRouter::add(\"/\"," << varid << ");";
             }
             if (titleArg) {
                 
-                if (titleArg->TYPE == NODE_STRING) {
-                    ss << "\t\tpage.setTitle(\"" << *(titleArg->value) << "\");\n"; 
-                } else if (titleArg->TYPE == NODE_VARIABLE) {
-                    ss << "\t\tpage.setTitle(" << *(titleArg->value) << ");\n"; 
+                if (titleArg.type() == NODE_STRING) {
+                    out << "\t\tpage.setTitle(\"" << titleArg.value() << "\");\n"; 
+                } else if (titleArg.type() == NODE_VARIABLE) {
+                    out << "\t\tpage.setTitle(" << titleArg.value() << ");\n"; 
                 } else {
-                    ss << "\t\tpage.setTitle(\"(" << exprForNode(titleArg) << ")\");\n";
+                    out << "\t\tpage.setTitle(\"(" << lowerExpr(titleArg) << ")\");\n";
                 }
             } else {
-                ss << "\t\tpage.setTitle(\"Create Helios--> App\");\n";
+                out << "\t\tpage.setTitle(\"Create Helios--> App\");\n";
             }
 
             if (clsparam) {
                 //page.bodyAttrs["class"] = "main-body";
-                if (clsparam->CHILD->TYPE == NODE_STRING) {
-                    ss << "\t\tpage.bodyAttrs[\"class\"] = \"" << *(clsparam->CHILD->value) << "\";\n";
-                } else if (clsparam->CHILD->TYPE == NODE_VARIABLE) {
-                    ss << "\t\tpage.bodyAttrs[\"class\"] = " << *(clsparam->CHILD->value) << ";\n";
+                if (clsparam.child().type() == NODE_STRING) {
+                    out << "\t\tpage.bodyAttrs[\"class\"] = \"" << clsparam.child().value() << "\";\n";
+                } else if (clsparam.child().type() == NODE_VARIABLE) {
+                    out << "\t\tpage.bodyAttrs[\"class\"] = " << clsparam.child().value() << ";\n";
                 } else {
-                    ss << "\t\tpage.bodyAttrs[\"class\"] =\"(" << exprForNode(clsparam->CHILD) << ")\";\n";
+                    out << "\t\tpage.bodyAttrs[\"class\"] =\"(" << lowerExpr(clsparam.child()) << ")\";\n";
                 }
             }
 
-            if (styleParam && styleParam->CHILD && styleParam->CHILD->TYPE == NODE_DICT) {
-                AST_NODE *dict = styleParam->CHILD;
-                ss << "\t\tpage.bodyAttrs[\"style\"] = \"";
-                for (auto &kv : dict->SUB_STATEMENTS) {
-                    AST_NODE *keyNode = kv->SUB_STATEMENTS[0];
-                    AST_NODE *valNode = kv->SUB_STATEMENTS[1];
-                    string key = (keyNode->TYPE == NODE_STRING) ? *(keyNode->value) : *(keyNode->value);
+            IrPage builder;
+            if (styleParam && styleParam.child() && styleParam.child().type() == NODE_DICT) {
+                builder.ops.push_back({IR_FIELD, "page", "bodyAttrs[\"style\"]", lowerStyle(styleParam.child())});
+            }
 
-                    // Build page.bodyAttrs["style"] = "background-color:#f0f0f0; font-family:Arial,sans-serif; margin:20px;";
-                    if (valNode->TYPE == NODE_STRING) {
-                        ss << key << ":" << *(valNode->value) << ";";
-                    }
-                        if (valNode->TYPE == NODE_VARIABLE) {
-                        if (find(statevars.begin(), statevars.end(), *(valNode->value)) != statevars.end())
-                            {
-                                ss << key << ":" << "\"+" <<  *(valNode->value) << "->get()" << "+\";\"+\"";
-                            } else {
-                                ss << key << ":" << "\"+" << *(valNode->value) << "+\";\"+\"";
-                            }
-                    }
+            // each element of the page, and each statement that adds any (a loop of
+            // them, say), is a section, rebuilt only when state it reads changes
+            uint32_t section = 0;
+            string el, eltype;
+            for (AstNode child : p.subs()) {
+                if (!child) continue;
+                if (elementKind(child.type(), el, eltype)) {
+                    IrOp op{IR_SECTION};
+                    op.index = section++;
+                    lowerElement(child, "page", el, eltype, false, op.body);
+                    builder.ops.push_back(std::move(op));
+                    continue;
+                }
+                if (child.type() == NODE_SETSTATE) {
+                    builder.ops.push_back(lowerState(child));
+                    continue;
+                }
+                if (child.type() == NODE_VARIABLE && child.child() && !child.isState() &&
+                    child.child().type() != NODE_CANVAS && elementKind(child.child().type(), el, eltype)) {
+                    builder.ops.push_back({IR_RAW, "\n\t\t"});
+                    lowerElement(child.child(), "root", el, child.value(), true, builder.ops);
+                    continue;
+                }
+                IrOp op = lowerStatement(child, "page", true);
+                op.name = "\n\t\t" + op.name;
+                if (addsChildren(child)) {
+                    IrOp wrapped{IR_SECTION};
+                    wrapped.index = section++;
+                    wrapped.body.push_back(std::move(op));
+                    builder.ops.push_back(std::move(wrapped));
+                    continue;
                 }
-                ss << "\";\n";
+                builder.ops.push_back(std::move(op));
             }
+            builder.ops.push_back({IR_RAW, unit ? "\n}\n" : "\n\t\t};"});
+            passes.run(builder);
 
-            for (auto &child : p->SUB_STATEMENTS) {
-                ss << "\n\t\t" << HandleAst(child, "page", true);
-            }
-            ss << "\n\t\t};";
-            
             pagecount++;
-            return ss.str();
+            printOps(builder.ops, out);
+            if (unit) {
+                pagefiles.emplace_back(varid, std::move(own));
+            }
         }
 
-string WebEngine::MakeElement(AST_NODE *p, string parent, string el,string eltype, bool isvar) {
-    
-    
-    string varid = eltype+"_" + to_string(idcount);
+void WebEngine::MakeElement(AstNode p, CodeWriter &out, string parent, string el, string eltype, bool isvar) {
+    IrPage unit;
+    lowerElement(p, parent, el, eltype, isvar, unit.ops);
+    passes.run(unit);
+    printOps(unit.ops, out);
+}
+
+void WebEngine::lowerElement(AstNode p, string parent, string el, string eltype, bool isvar, vector<IrOp> &ops) {
+    string varid = eltype+"_" + to_string(idcount++);
     if (isvar)
     {
         varid = eltype;
     }
-    stringstream ss;
-    if (el != "p")
-    {
-        ss << "\n\tVNode "+varid+"(\""+ el +"\");\n";
-    }
     
-    AST_NODE *args = p->CHILD;
-    AST_NODE *styleParam = nullptr;
-    AST_NODE *firstparam = nullptr;
-    AST_NODE *clsparam = nullptr;
-    AST_NODE *onclkParam = nullptr;
-    AST_NODE *idparam = nullptr;
-    AST_NODE *heightparam = nullptr;
-    AST_NODE *widthparam = nullptr;
-
-    if (args && !args->SUB_STATEMENTS.empty()) {
-        firstparam = args->SUB_STATEMENTS[0];
-        for (size_t i = 1; i < args->SUB_STATEMENTS.size(); ++i) {
-            AST_NODE *param = args->SUB_STATEMENTS[i];
-            if (param && param->TYPE == NODE_VARIABLE && param->value && *(param->value) == "style") {
+    AstNode args = p.child();
+    AstNode styleParam;
+    AstNode firstparam;
+    AstNode clsparam;
+    AstNode onclkParam;
+    AstNode idparam;
+    AstNode heightparam;
+    AstNode widthparam;
+
+    if (args && !args.subs().empty()) {
+        firstparam = args.subs()[0];
+        for (size_t i = 1; i < args.subs().size(); ++i) {
+            AstNode param = args.subs()[i];
+            if (param && param.type() == NODE_VARIABLE && param.hasValue() && param.value() == "style") {
                 styleParam = param;
             }
-            if (param && param->TYPE == NODE_VARIABLE && param->value && *(param->value) == "onclick") {
+            if (param && param.type() == NODE_VARIABLE && param.hasValue() && param.value() == "onclick") {
                 onclkParam = param;
             }
-            if (param && param->TYPE == NODE_VARIABLE && param->value && *(param->value) == "cls") {
+            if (param && param.type() == NODE_VARIABLE && param.hasValue() && param.value() == "cls") {
                 clsparam = param;
             }
-            if (param && param->TYPE == NODE_VARIABLE && param->value && *(param->value) == "id")
+            if (param && param.type() == NODE_VARIABLE && param.hasValue() && param.value() == "id")
             {
                 idparam = param; 
             }
-            if (param && param->TYPE == NODE_VARIABLE && param->value && *(param->value) == "height") {
+            if (param && param.type() == NODE_VARIABLE && param.hasValue() && param.value() == "height") {
                 heightparam = param;
             }
-            if (param && param->TYPE == NODE_VARIABLE && param->value && *(param->value) == "width") {
+            if (param && param.type() == NODE_VARIABLE && param.hasValue() && param.value() == "width") {
                 widthparam = param;
             }
 
         }
     }
+
+    IrOp element{IR_ELEMENT, varid, el};
+    if (el == "p" && firstparam)
+    {
+        if (firstparam.type() != NODE_STRING && firstparam.type() != NODE_VARIABLE) {
+            cout << "gor error P text is not a string or variable";
+            exit(1);
+        }
+        element.value = lowerExpr(firstparam);
+    }
+    ops.push_back(std::move(element));
+
     if (firstparam)
     {
         if (el == "img")
         {
-            if (firstparam->TYPE == NODE_STRING) {
-                    ss << "\t" << varid << ".setAttr(\"src\", \"" << *(firstparam->value) << "\");\n"; 
-                } else if (firstparam->TYPE == NODE_VARIABLE) {
-                    ss << "\t" << varid << ".setAttr(\"src\"," << HandleAst(firstparam->CHILD, parent)  << ");\n"; 
-                } else {
-                    ss << "\t" << varid << ".setAttr(\"src\", \"" << exprForNode(firstparam) << "\");\n";
-            }
-        }
-        if (el == "p")
-        {
-            if (firstparam->TYPE == NODE_STRING) {
-                    ss << "\n\t\tVNode "+varid+"(\""+ el + "\",\"" + *(firstparam->value) +"\");\n";
-                } else if (firstparam->TYPE == NODE_VARIABLE) {
-                    ss << "\n\t\tVNode "+varid+"(\""+ el + "\"," + HandleAst(firstparam, parent) +");\n"; 
-                } else {
-                    cout << "gor error P text is not a string or variable";
-                    exit(1);
-            }
+            ops.push_back({IR_ATTR, varid, "src", lowerAttribute(firstparam)});
         }
-        if (el == "div")
+        if (el == "canvas")
         {
-            if (firstparam->TYPE == NODE_STRING) {
-                    ss << "\t\t" << varid << ".setAttr(\"id\", \"" << *(firstparam->value) << "\");\n"; 
-                } else if (firstparam->TYPE == NODE_VARIABLE) {
-                    ss << "\t\t" << varid << ".setAttr(\"id\"," << *(firstparam->value) << ");\n"; 
-                } else {
-                    ss << "\t\t" << varid << ".setAttr(\"id\", \"" << exprForNode(firstparam) << "\");\n";
-            }
+            IrOp type{IR_FIELD, varid, "type"};
+            type.value.push({VALUE_NAME, TYPE_UNKNOWN, "VNodeType::CANVAS"});
+            ops.push_back(std::move(type));
         }
-        if (el == "canvas")
+        if (el == "div" || el == "canvas")
         {
-            // canvas.type = VNodeType::CANVAS;
-            ss  << "\t\t" << varid << ".type = VNodeType::CANVAS;\n";
-            if (firstparam->TYPE == NODE_STRING) {
-                    ss << "\t\t" << varid << ".setAttr(\"id\", \"" << *(firstparam->value) << "\");\n"; 
-                } else if (firstparam->TYPE == NODE_VARIABLE) {
-                    ss << "\t\t" << varid << ".setAttr(\"id\"," << *(firstparam->value) << ");\n"; 
-                } else {
-                    ss << "\t\t" << varid << ".setAttr(\"id\", \"" << exprForNode(firstparam) << "\");\n";
-            }
+            ops.push_back({IR_ATTR, varid, "id", lowerAttribute(firstparam)});
         }
-        
-        
     }
     
     if (idparam)
     {
-        if (idparam->CHILD->TYPE == NODE_STRING) {
-                    ss << "\t\t" << varid << ".setAttr(\"id\", \"" << *(idparam->CHILD->value) << "\");\n"; 
-                } else if (idparam->CHILD->TYPE == NODE_VARIABLE) {
-                    ss << "\t\t" << varid << ".setAttr(\"id\"," << *(idparam->CHILD->value) << ");\n"; 
-                } else {
-                    ss << "\t\t" << varid << ".setAttr(\"id\", \"" << exprForNode(idparam->CHILD) << "\");\n";
-            }
+        ops.push_back({IR_ATTR, varid, "id", lowerAttribute(idparam.child())});
     }
 
     if (heightparam)
     {
-        if (heightparam->CHILD->TYPE == NODE_INT) {
-                    ss << "\t\t" << varid << ".height = " << *(heightparam->CHILD->value) << ";\n"; 
-        } else if (heightparam->CHILD->TYPE == NODE_VARIABLE) {
-            ss << "\t\t" << varid << ".height = " << *(heightparam->CHILD->value) << ";\n"; 
-        } else {
-            ss << "\t\t" << varid << ".height = " << exprForNode(heightparam->CHILD) << ";\n";
-        }
+        ops.push_back({IR_FIELD, varid, "height", lowerExpr(heightparam.child())});
     }
 
     if (widthparam)
     {
-        if (widthparam->CHILD->TYPE == NODE_INT) {
-                    ss << "\t\t" << varid << ".width = " << *(widthparam->CHILD->value) << ";\n"; 
-        } else if (widthparam->CHILD->TYPE == NODE_VARIABLE) {
-            ss << "\t\t" << varid << ".width = " << *(widthparam->CHILD->value) << ";\n"; 
-        } else {
-            ss << "\t\t" << varid << ".width = " << exprForNode(widthparam->CHILD) << ";\n";
-        }
+        ops.push_back({IR_FIELD, varid, "width", lowerExpr(widthparam.child())});
     }
 
     if (clsparam) {
-        //page.bodyAttrs["class"] = "main-body";
-        if (clsparam->CHILD->TYPE == NODE_STRING) {
-            ss << "\t" << varid << ".setAttr(\"class\",  \"" << *(clsparam->CHILD->value) << "\");\n";
-        } else if (clsparam->CHILD->TYPE == NODE_VARIABLE) {
-            ss << "\t" << varid << ".setAttr(\"class\",  " << *(clsparam->CHILD->value) << ");\n";
-        } else {
-            ss << "\t" << varid << ".setAttr(\"class\", \"(" << exprForNode(clsparam->CHILD) << "\");\n";
-        }
+        ops.push_back({IR_ATTR, varid, "class", lowerAttribute(clsparam.child())});
     }
 
     if (onclkParam)
     {
-        AST_NODE *chld = onclkParam->CHILD->CHILD;
-
-        ss << "\t" << varid << ".onClick([";
-        if (chld) {
-            for (auto &i : chld->SUB_STATEMENTS)
-        {
-            ss << *(i->value);
-            if (&i != &chld->SUB_STATEMENTS.back())
+        IrOp click{IR_CLICK, varid};
+        if (AstNode chld = onclkParam.child().child()) {
+            for (AstNode i : chld.subs())
             {
-                ss << ", ";
+                click.captures.push_back(i.value());
             }
         }
-        }
-        
-        
-        ss << "]() {\n";
-        for (auto &i : onclkParam->CHILD->SUB_STATEMENTS)
+        for (AstNode i : onclkParam.child().subs())
         {
-            ss << "\t\t" << HandleAst(i, parent, true) << "\n";   
+            CodeWriter text;
+            HandleAst(i, text, parent, true);
+            click.body.push_back({IR_RAW, text.str()});
         }
-        ss << "\t\tupdateUI();\t});\n";
+        collectWrites(onclkParam.child(), click.uses);
+        ops.push_back(std::move(click));
     }
-    
 
-    if (styleParam && styleParam->CHILD && styleParam->CHILD->TYPE == NODE_DICT) {
-        AST_NODE *dict = styleParam->CHILD;
-        ss << "\t" << varid << ".setAttr(\"style\", \"";
-        for (auto &kv : dict->SUB_STATEMENTS) {
-            AST_NODE *keyNode = kv->SUB_STATEMENTS[0];
-            AST_NODE *valNode = kv->SUB_STATEMENTS[1];
-            string key = (keyNode->TYPE == NODE_STRING) ? *(keyNode->value) : *(keyNode->value);
-
-            // Build page.bodyAttrs["style"] = "background-color:#f0f0f0; font-family:Arial,sans-serif; margin:20px;";
-            if (valNode->TYPE == NODE_STRING) {
-                ss << key << ":" << *(valNode->value) << ";";
-            }
-            if (valNode->TYPE == NODE_VARIABLE) {
-                if (find(statevars.begin(), statevars.end(), *(valNode->value)) != statevars.end())
-                    {
-                        ss << key << ":" << "\"+" <<  *(valNode->value) << "->get()" << "+\";\"+\"";
-                    } else {
-                        ss << key << ":" << "\"+" << *(valNode->value) << "+\";\"+\"";
-                    }
-            }
-        }
-        ss << "\");\n";
+    if (styleParam && styleParam.child() && styleParam.child().type() == NODE_DICT) {
+        ops.push_back({IR_ATTR, varid, "style", lowerStyle(styleParam.child())});
     }
 
-    for (auto &child : p->SUB_STATEMENTS) {
-        ss << HandleAst(child, varid);
+    string childel, childtype;
+    for (AstNode child : p.subs()) {
+        if (child && elementKind(child.type(), childel, childtype)) {
+            lowerElement(child, varid, childel, childtype, false, ops);
+        } else {
+            ops.push_back(lowerStatement(child, varid));
+        }
     }
 
     if (!isvar)
     {
-        ss << "\n\t" << parent << ".addChild(" << varid << ");";
+        ops.push_back({IR_APPEND, varid, parent});
     }
-    
-
-    idcount++;
-    return ss.str();
 }
 
-string WebEngine::MakeConversion(AST_NODE *p, NODE_TYPE type, bool isroot) {
+void WebEngine::MakeConversion(AstNode p, NODE_TYPE type, CodeWriter &out, bool isroot) {
     switch (type) {
-        case NODE_TOSTR: {
-            stringstream ss;
-            ss << "to_string(";
-            ss << exprForNode(p->CHILD);
-            ss << ")";
-            if(isroot) {
-                ss << ";";
-            }
-            return ss.str();
-        }
-        case NODE_TOINT: {
-            stringstream ss;
-            ss << "stoi(";
-            ss << exprForNode(p->CHILD);
-            ss << ")";
-            if(isroot) {
-                ss << ";";
-            }
-            return ss.str();
-        }
-        case NODE_TOFLOAT: {
-            stringstream ss;
-            ss << "stof(";
-            ss << exprForNode(p->CHILD);
-            ss << ")";
-            if(isroot) {
-                ss << ";";
-            }
-            return ss.str();
-        }
+        case NODE_TOSTR:
+            out << "to_string(" << lowerExpr(p.child()) << ")";
+            break;
+        case NODE_TOINT:
+            out << "stoi(" << lowerExpr(p.child()) << ")";
+            break;
+        case NODE_TOFLOAT:
+            out << "stof(" << lowerExpr(p.child()) << ")";
+            break;
         default:
-            return "";
+            return;
+    }
+    if (isroot) {
+        out << ";";
     }
-    return "";
 }
 
-string WebEngine::MakeDraw(AST_NODE *p,bool isroot, string parent) {
-    stringstream ss;
+void WebEngine::MakeDraw(AstNode p, CodeWriter &out, bool isroot, string parent) {
     if (isroot) {
         // Canvas2D ctx("id");
-        ss << "Canvas2D ";
-        ss << parent << *(p->CHILD->SUB_STATEMENTS[0]->value) << idcount;
-        ss << "(";
-        ss << HandleAst(p->CHILD->SUB_STATEMENTS[0]);
-        ss << ");";
-    } else {
-        ss << "(";
-        ss << HandleAst(p->CHILD->SUB_STATEMENTS[0]);
-        ss << ");";  
+        out << "Canvas2D " << parent << p.child().subs()[0].value() << idcount;
     }
-    return ss.str();
+    out << "(";
+    HandleAst(p.child().subs()[0], out);
+    out << ");";
 }
 
-string WebEngine::makeMath(AST_NODE *p, NODE_TYPE nodetype) {
-    stringstream mathstr;
+void WebEngine::makeMath(AstNode p, NODE_TYPE nodetype, CodeWriter &out) {
     // std::cout << cos(23.56) << sin(34) << tan(234) << sqrt(54) << pow(12, 2);
     switch (nodetype)
     {
         case NODE_MATH_COS: {
-            mathstr << "cos(" << exprForNode(p->CHILD) << ")";
+            out << "cos(" << lowerExpr(p.child()) << ")";
             break;
         }
         case NODE_MATH_SIN: {
-            mathstr << "sin(" << exprForNode(p->CHILD) << ")";
+            out << "sin(" << lowerExpr(p.child()) << ")";
             break;
         }
         case NODE_MATH_TAN: {
-            mathstr << "tan(" << exprForNode(p->CHILD) << ")";
+            out << "tan(" << lowerExpr(p.child()) << ")";
             break;
         }
         case NODE_MATH_SQRT: {
-            mathstr << "sqrt(" << exprForNode(p->CHILD) << ")";
+            out << "sqrt(" << lowerExpr(p.child()) << ")";
             break;
         }
         case NODE_MATH_POW: {
-            if (p->CHILD)
+            if (p.child())
             {
-                mathstr << "pow(" << exprForNode(p->CHILD) << "," << exprForNode(p->CHILD) << ")";
+                out << "pow(" << lowerExpr(p.child()) << "," << lowerExpr(p.child()) << ")";
             } else {
-                mathstr << "pow(" << exprForNode(p->SUB_STATEMENTS[0]) << "," << exprForNode(p->SUB_STATEMENTS[1]) << ")";
+                out << "pow(" << lowerExpr(p.subs()[0]) << "," << lowerExpr(p.subs()[1]) << ")";
             }
             break;
         }
         default:
             break;
     }
-    return mathstr.str();
 }
 
-string WebEngine::HandleAst(AST_NODE *p, string parent, bool funcdecl, bool fromui) { 
-    if (!p) return "";
-        switch (p->TYPE) {
+void WebEngine::HandleAst(AstNode p, CodeWriter &out, string parent, bool funcdecl, bool fromui) { 
+    if (!p) return;
+        switch (p.type()) {
         case NODE_VARIABLE: {
             // variable assignment or bare reference
-            if (!p->CHILD) {
+            if (!p.child()) {
                 // bare variable reference (as statement? unlikely). Return empty.
-                
-                    stringstream ss;
-                    if (find(statevars.begin(), statevars.end(), *(p->value)) != statevars.end())
+                    if (p.isState())
                     {
-                        ss << *(p->value) << "->get()";
-                        return ss.str();
+                        out << p.value() << "->get()";
                     } else {
                         if (funcdecl)
                         {
-                            return *(p->value);
+                            out << p.value();
                         }
                         else
                         {
-                                return "\n\t"+parent + ".addChild("+ *(p->value) +");\n";
+                                out << "\n\t" << parent << ".addChild(" << p.value() << ");\n";
                         }
                     }
+                    return;
             } else {
                 // declaration: infer type from child
-                NODE_TYPE dtype = p->CHILD->TYPE;
-                if (find(statevars.begin(), statevars.end(), *(p->value)) != statevars.end())
+                NODE_TYPE dtype = p.child().type();
+                if (p.isState())
                 {
                     // state variable assignment
-                    string varName = *(p->value);
-                    string expr = exprForNode(p->CHILD);
-                    return "\t" + varName + "->set(" + expr + ");";
+                    out << "\t" << p.value() << "->set(" << lowerExpr(p.child()) << ");";
+                    return;
                 }
                 else
                 {
-                        string varbufName = *(p->value);
                     
                     if (!fromui) {
-                        variable_buffer[varbufName] = false;
+                        variable_buffer[p.symbol()] = false;
                     }
+                    // a hoisted root variable is declared above main(), and only assigned here
+                    const string *global = fromui ? nullptr : hoisted.find(p.symbol());
+                    string el, eltype;
                     if (dtype == NODE_DICT) {
                         // create unordered_map and insert key-values
-                        string varName = *(p->value);
-                        stringstream ss;
-                        ss << "    unordered_map<string,string> " << varName << ";\n";
-                        for (auto &kv : p->CHILD->SUB_STATEMENTS) {
+                        string varName = p.value();
+                        if (!global) {
+                            out << "    unordered_map<string,string> " << varName << ";\n";
+                        }
+                        for (AstNode kv : p.child().subs()) {
                             // kv is NODE_KEYVALUE: substatements[0]=key, [1]=value
-                            AST_NODE *keyN = kv->SUB_STATEMENTS[0];
-                            AST_NODE *valN = kv->SUB_STATEMENTS[1];
+                            AstNode keyN = kv.subs()[0];
+                            AstNode valN = kv.subs()[1];
 
                             // keys are typically strings or ids; treat as string literal
-                            string keyLiteral = (keyN->TYPE == NODE_STRING) ? *(keyN->value) : *(keyN->value);
-                            string keyCpp = cpp_literal(keyLiteral);
+                            out << "    " << varName << ".insert({ " << cppLiteral(keyN.value()) << ", ";
 
                             // value: if string -> literal; if variable -> variable name expression; else -> expr
-                            string valExpr;
-                            if (valN->TYPE == NODE_STRING) {
-                                valExpr = cpp_literal(*(valN->value));
+                            if (valN.type() == NODE_STRING) {
+                                out << cppLiteral(valN.value());
                             } else {
-                                valExpr = exprForNode(valN);
+                                out << lowerExpr(valN);
                             }
-
-                            ss << "    " << varName << ".insert({ " << keyCpp << ", " << valExpr << " });\n";
+                            out << " });\n";
                         }
-                        return ss.str();
                     } else if (dtype == NODE_page) {
-                        string varName = *(p->value);
-                        return MakePage(p->CHILD, varName);
-                    } else if (dtype == NODE_VIEW || dtype == NODE_TEXT || dtype == NODE_IMAGE || dtype == NODE_INPUT) {
-                        string el = "div";
-                        string eltype = *(p->value);
-                        switch (dtype)
-                        {
-                        case NODE_VIEW:
-                            el = "div";
-                            
-                            break;
-                        case NODE_TEXT:
-                            el = "p";
-                            
-                            break;
-                        case NODE_IMAGE:
-                            el = "img";
-                            
-                            break;
-                        case NODE_INPUT:
-                            el = "input";
-                        
-                            break;
-                        default:
-                            break;
-                        }
-                        return MakeElement(p->CHILD, "root", el, eltype, true);
+                        MakePage(p.child(), p.value(), out);
+                    } else if (dtype != NODE_CANVAS && elementKind(dtype, el, eltype)) {
+                        MakeElement(p.child(), out, "root", el, p.value(), true);
                     } else if (dtype == NODE_TOINT || dtype == NODE_TOFLOAT || dtype == NODE_TOSTR) {
-                        return MakeConversion(p, dtype, false);
+                        MakeConversion(p, dtype, out, false);
                     } else if (dtype == NODE_DRAW) {
-                        stringstream ss;
-                        ss << "Canvas2D " << *(p->value) << MakeDraw(p->CHILD, false, parent);
-                        return ss.str();
+                        out << "Canvas2D " << p.value();
+                        MakeDraw(p.child(), out, false, parent);
                     } else if (dtype == NODE_PLATFORM_CLS) {
-                        stringstream ss;
-                        ss << "auto " << *(p->value) << " = " << HandleAst(p->CHILD, parent, funcdecl, false);
-                        return ss.str();
+                        out << "auto " << p.value() << " = ";
+                        HandleAst(p.child(), out, parent, funcdecl, false);
                     }
                     else {
                         // simple assignment: type name = expr;
-                        string varName = *(p->value);
-                        string expr = exprForNode(p->CHILD);
-                        string ctype = pyxtocpp_type(p->CHILD->TYPE, p->CHILD);
-                        if (ctype == "ERROR") ctype = "auto";
-                        return "    " + ctype + " " + varName + " = " + expr + ";";
+                        out << "    ";
+                        if (!global) {
+                            out << cppType(p.child()) << " ";
+                        }
+                        out << p.value() << " = " << lowerExpr(p.child()) << ";";
                     }
+                    return;
                 }
                             
             }
         }
         case NODE_STRING: {
-            return exprForNode(p);
+            out << lowerExpr(p);
+            return;
         }
         case NODE_PRINT: {
-            if (p->CHILD->TYPE == NODE_VARIABLE)
+            if (p.child().type() == NODE_VARIABLE)
             {
-                stringstream ss;
-                ss << "cout << " << HandleAst(p->CHILD, parent, true) << " << endl;";
-                return  ss.str();
+                out << "cout << ";
+                HandleAst(p.child(), out, parent, true);
+                out << " << endl;";
             }
             else
             {
-                
-                string expr = exprForNode(p->CHILD);
-            return "\tcout << " + expr + " << endl;";
+                out << "\tcout << " << lowerExpr(p.child()) << " << endl;";
             }
-            
-            
+            return;
         }
         case NODE_GO: {
-            stringstream ss;
-            ss << "Router::go(\"";
-            for (auto i : p->SUB_STATEMENTS) {
-                ss << *(i->value);
+            out << "Router::go(\"";
+            for (AstNode i : p.subs()) {
+                out << i.value();
             }
-            ss << "\");";
-            return ss.str();
+            out << "\");";
+            return;
         }
         case NODE_IF: {
             bool haselsif = false;
-            stringstream ss;
-            ss << "\tif";
-            ss << exprForNode(p->CHILD);
-            ss << "{";
-            for (auto i : p->SUB_STATEMENTS)
+            out << "\tif";
+            conditionFor(p.child(), out);
+            out << "{";
+            for (AstNode i : p.subs())
             {
-                ss << "\n    ";
-                if (i->TYPE == NODE_ELSE || i->TYPE == NODE_ELSE_IF)
+                out << "\n    ";
+                if (i.type() == NODE_ELSE || i.type() == NODE_ELSE_IF)
                 {
                     haselsif = true;
-                    ss << "\n    }"; 
+                    out << "\n    }"; 
                 }
                 
-                ss << HandleAst(i);
+                HandleAst(i, out);
             }
             if (!haselsif)
             {
-                ss << "}";
+                out << "}";
             }
-            return ss.str();
+            return;
         }
         case NODE_ELSE: {
-            stringstream ss;
-            ss << "\n    else {";
-            for (auto i : p->SUB_STATEMENTS) {
-                ss << HandleAst(i);
+            out << "\n    else {";
+            for (AstNode i : p.subs()) {
+                HandleAst(i, out);
             }
-            ss << "\n    }";
-            return ss.str();
+            out << "\n    }";
+            return;
         }
         case NODE_ELSE_IF: {
-            stringstream ss;
-            ss << "\n\telse if";
-            ss << exprForNode(p->CHILD);
-            ss << "{";
-            for (auto i : p->SUB_STATEMENTS)
+            out << "\n\telse if";
+            conditionFor(p.child(), out);
+            out << "{";
+            for (AstNode i : p.subs())
             {
-                ss << "\n\t" << HandleAst(i);
+                out << "\n\t";
+                HandleAst(i, out);
             }
-            
-            return ss.str();
+            return;
         } case NODE_page: {
-            
-            return MakePage(p, "page_"+to_string(pagecount));
-        } case NODE_VIEW: {
-            return MakeElement(p, parent, "div", "view");
-        } case NODE_TEXT: {
-            return MakeElement(p, parent, "p", "text");
-        } case NODE_IMAGE: {
-            return MakeElement(p, parent, "img", "img");
+            MakePage(p, "page_" + to_string(pagecount), out);
+            return;
+        } case NODE_VIEW:
+          case NODE_TEXT:
+          case NODE_IMAGE:
+          case NODE_CANVAS:
+          case NODE_INPUT: {
+            string el, eltype;
+            elementKind(p.type(), el, eltype);
+            MakeElement(p, out, parent, el, eltype);
+            return;
         } case NODE_SETSTATE: {
-            string varname = *(p->value);
-            string ctype = pyxtocpp_type(p->CHILD->TYPE, p->CHILD);
-            // auto counter = make_shared<appstate::State<auto>>("counter", 0);
-            string makeendvar;
-            if (ctype == "string") {
-                makeendvar = "\""+  *(p->CHILD->value) +"\"";
-            } else {
-                makeendvar =  *(p->CHILD->value);
-            }
-            stringstream ss;
-            string endvar = ">>(\""+ varname +"\"," + makeendvar + ");";
-            ss << "\n\tauto " << varname << " = make_shared<appstate::State<" << ctype << endvar;
-            statevars.push_back(varname);
-            return ss.str();
+            printOps({lowerState(p)}, out);
+            return;
         }
         case NODE_STYLESHEET: {
-            stringstream ss;
-            ss << "\tstring " << *(p->value) << " = R\"(\n\t";
+            out << "\t";
+            if (!hoisted.contains(p.symbol())) {
+                out << "string ";
+            }
+            out << p.value() << " = R\"(\n\t";
             bool isuniversal = false;
-            if(p->CHILD) {
+            if(p.child()) {
                 isuniversal = true;
             }
-            variable_buffer[*(p->value)] = isuniversal;
-            for (auto &subs : p->SUB_STATEMENTS) {
-                ss << HandleAst(subs, parent, true);
+            variable_buffer[p.symbol()] = isuniversal;
+            for (AstNode subs : p.subs()) {
+                HandleAst(subs, out, parent, true);
             }
-            ss << ")\";\n\t";
-            return ss.str();
+            out << ")\";\n\t";
+            return;
         }
         case NODE_CLS: {
-            stringstream ss;
-            ss << "\t." << *(p->value) << "{ \n";
-            if (p->CHILD) {
-                for (auto &kv : p->CHILD->SUB_STATEMENTS) {
-                    ss << "\t\t\t" << *(kv->SUB_STATEMENTS[0]->value) << " : ";
-                    if (kv->SUB_STATEMENTS[1]->TYPE == NODE_VARIABLE) {
-                        ss << ")\" +" <<  HandleAst(kv->SUB_STATEMENTS[1], parent, true)  << "+ R\"(";
-                    } else if (kv->SUB_STATEMENTS[1]->TYPE == NODE_STRING) {
-                        ss << *(kv->SUB_STATEMENTS[1]->value);
+            out << "\t." << p.value() << "{ \n";
+            if (p.child()) {
+                for (AstNode kv : p.child().subs()) {
+                    out << "\t\t\t" << kv.subs()[0].value() << " : ";
+                    if (kv.subs()[1].type() == NODE_VARIABLE) {
+                        out << ")\" +";
+                        HandleAst(kv.subs()[1], out, parent, true);
+                        out << "+ R\"(";
+                    } else if (kv.subs()[1].type() == NODE_STRING) {
+                        out << kv.subs()[1].value();
                     } else {
-                        ss << HandleAst(kv->SUB_STATEMENTS[1], parent, true);
+                        HandleAst(kv.subs()[1], out, parent, true);
                     }
                     //  
-                    ss << ";\n";
+                    out << ";\n";
                 }
             }
-            ss << "\t\t}";
-            return ss.str();
+            out << "\t\t}";
+            return;
         }
         case NODE_MEDIA_QUERY: {
             // string unis = R"(
@@ -804,220 +943,166 @@ string WebEngine::HandleAst(AST_NODE *p, string parent, bool funcdecl, bool from
             //         background-color: purple
             //     }
             // )";
-            stringstream ss;
-            ss << "\n\t\t@media only screen and (";
-            if(p->CHILD->TYPE == NODE_STRING) {
-                ss << *(p->CHILD->value);
+            out << "\n\t\t@media only screen and (";
+            if(p.child().type() == NODE_STRING) {
+                out << p.child().value();
             } else {
-                ss <<  HandleAst(p->CHILD, parent);
+                HandleAst(p.child(), out, parent);
             }
-            ss << ") {"; 
-            for (auto &cls : p->SUB_STATEMENTS) {
-                ss << "\n\t\t\t" << HandleAst(cls, parent, true);
+            out << ") {"; 
+            for (AstNode cls : p.subs()) {
+                out << "\n\t\t\t";
+                HandleAst(cls, out, parent, true);
             }
-            ss << "\n\t\t}\n";
-            return ss.str();
-        }
-        case NODE_CANVAS: {
-            return MakeElement(p, parent, "canvas", "canvas");  
-        }
-        case NODE_INPUT: {
-            return MakeElement(p, parent, "input", "input");
+            out << "\n\t\t}\n";
+            return;
         }
         case NODE_FUNCTION_DECL: {
-            if (*(p->value) == "onmount") {
-                stringstream ss;
-                ss << parent << ".onMount([&";
-                if (!statevars.empty()) {
-                    for (auto &i : statevars) {
-                        ss << ", " << i;
-                    }
-                }
-                ss << "]() {\n";
-                for (auto &stmt : p->SUB_STATEMENTS) {
-                    ss << "\t\t\t" << HandleAst(stmt, parent) << "\n";
-                }
-                ss << "\t\t});\n";
-                return ss.str();
-            }
-
-            if (*(p->value) == "animatefps") {
-                stringstream ss;
-                ss << parent << ".onAnimatefps([&";
-                if (!statevars.empty()) {
-                    for (auto &i : statevars) {
-                        ss << ", " << i;
-                    }
-                }
-                ss << "]() {\n";
-                for (auto &stmt : p->SUB_STATEMENTS) {
-                    ss << "\t\t\t" << HandleAst(stmt, parent) << "\n";
+            if (p.value() == "onmount" || p.value() == "animatefps" || p.value() == "listener") {
+                if (p.value() == "onmount") {
+                    out << parent << ".onMount([&";
+                } else if (p.value() == "animatefps") {
+                    out << parent << ".onAnimatefps([&";
+                } else {
+                    out << parent << ".addevent(\"" << p.child().subs()[0].value() << "\", [&";
                 }
-                ss << "\t\t});\n";
-                return ss.str();
-            }
-
-            if (*(p->value) == "listener") {
-                stringstream ss;
-                string eventarg = *(p->CHILD->SUB_STATEMENTS[0]->value);
-                ss << parent << ".addevent(\"" << eventarg << "\", [&";
-                if (!statevars.empty()) {
-                    for (auto &i : statevars) {
-                        ss << ", " << i;
-                    }
+                for (Symbol i : statevars) {
+                    out << ", " << Symbols::name(i);
                 }
-                ss << "]() {\n";
-                for (auto &stmt : p->SUB_STATEMENTS) {
-                    ss << "\t\t\t" << HandleAst(stmt, parent) << "\n";
+                out << "]() {\n";
+                for (AstNode stmt : p.subs()) {
+                    out << "\t\t\t";
+                    HandleAst(stmt, out, parent);
+                    out << "\n";
                 }
-                ss << "\t\t});\n";
-                return ss.str();
+                out << "\t\t});\n";
+                return;
             }
             
-            stringstream ss;
-            stringstream tmpl;
-            tmpl << "";
-            string ftype = "\nvoid";
-            ss << *(p->value) << "(";
-            AST_NODE *args = p->CHILD;
-            if (args && !args->SUB_STATEMENTS.empty()) {
+            // The return type is known only once the body is written, so the
+            // body goes into a writer of its own and follows it into headerbuffer.
+            CodeWriter tmpl;
+            CodeWriter body;
+            string ftype = "void";
+            body << p.value() << "(";
+            AstNode args = p.child();
+            if (args && !args.subs().empty()) {
                 tmpl << "\ntemplate <";
-                for (size_t i = 0; i < args->SUB_STATEMENTS.size(); ++i) {
+                for (size_t i = 0; i < args.subs().size(); ++i) {
                     
-                    AST_NODE *param = args->SUB_STATEMENTS[i];
-                    tmpl << "typename " << *(param->value) << to_string(i);
+                    AstNode param = args.subs()[i];
+                    tmpl << "typename " << param.value() << i;
 
-                    ss << *(param->value) << to_string(i) << "&&" << " " << *(param->value);
-                    if (i < args->SUB_STATEMENTS.size() - 1) {
-                        ss << ", ";
+                    body << param.value() << i << "&&" << " " << param.value();
+                    if (i < args.subs().size() - 1) {
+                        body << ", ";
                         tmpl << ", ";
                     }
                 }
                 tmpl << ">\n";
             }
-            ss << ") {\n";
-            for (auto &stmt : p->SUB_STATEMENTS) {
-                if (stmt->TYPE == NODE_RETURN)
+            body << ") {\n";
+            for (AstNode stmt : p.subs()) {
+                if (stmt.type() == NODE_RETURN)
                 {
-                    ftype = pyxtocpp_type(stmt->CHILD->TYPE, stmt->CHILD);
-                    if (ftype == "ERROR") ftype = "auto";
-                    ss << "\treturn ";
-                    ss << exprForNode(stmt->CHILD) << ";\n";
+                    ftype = cppType(stmt.child());
+                    body << "\treturn " << lowerExpr(stmt.child()) << ";\n";
                     continue;
                 }
-                ss << HandleAst(stmt, parent);
+                HandleAst(stmt, body, parent);
             }
-            ss << "\n}\n";
+            body << "\n}\n";
 
-            filebuffer << tmpl.str() << ftype << " " << ss.str();
-            return "";
+            // every unit includes app.hpp, so what is defined there is inline
+            if (tmpl.empty()) {
+                headerbuffer << "\n";
+            }
+            headerbuffer.append(std::move(tmpl));
+            headerbuffer << "inline " << ftype << " ";
+            headerbuffer.append(std::move(body));
+            return;
         }
         case NODE_FUNCTION_CALL: {
-            stringstream ss;
-            ss << *(p->value) << "(";
-            if (!p->SUB_STATEMENTS.empty()) {
-                for (size_t i = 0; i < p->SUB_STATEMENTS.size(); ++i) {
-                    ss << exprForNode(p->SUB_STATEMENTS[i]);
-                    if (i < p->SUB_STATEMENTS.size() - 1) {
-                        ss << ",";
-                    }
+            out << p.value() << "(";
+            for (size_t i = 0; i < p.subs().size(); ++i) {
+                out << lowerExpr(p.subs()[i]);
+                if (i < p.subs().size() - 1) {
+                    out << ",";
                 }
             }
-            ss << ");";
-            return ss.str();
-        }
-        case NODE_TOFLOAT: {
-            // static_cast<float>(integerValue);
-            return MakeConversion(p, NODE_TOFLOAT, true);
-        }
-        case NODE_TOINT: {
-            return MakeConversion(p, NODE_TOINT, true);
+            out << ");";
+            return;
         }
+        case NODE_TOFLOAT:
+        case NODE_TOINT:
         case NODE_TOSTR: {
-            return MakeConversion(p, NODE_TOSTR, true);
+            // static_cast<float>(integerValue);
+            MakeConversion(p, p.type(), out, true);
+            return;
         }
         case NODE_DRAW: {
-            return MakeDraw(p, true, parent);
+            MakeDraw(p, out, true, parent);
+            return;
         }
         case NODE_INSTANCE: {
-            stringstream ss;
-            ss << *(p->value) << "." << HandleAst(p->CHILD,parent,funcdecl, fromui);
-            return ss.str();
+            out << p.value() << ".";
+            HandleAst(p.child(), out, parent, funcdecl, fromui);
+            return;
         }
         case NODE_BINARY_OP:
         case NODE_BOOL:
         case NODE_UNARY_OP: {
-            if (p->TYPE == NODE_BINARY_OP || p->TYPE == NODE_BOOL)
+            out << lowerExpr(p);
+            if (p.type() == NODE_BINARY_OP || p.type() == NODE_BOOL)
             {
-                return exprForNode(p) + ";";
+                out << ";";
             }
-            
-            return exprForNode(p);
+            return;
         }
 
         case NODE_FOR: {
-            stringstream ss;
-            ss << "for (";
-            if (p->CHILD->TYPE == NODE_ARGS)
+            out << "for (";
+            if (p.child().type() == NODE_ARGS)
             {
-                for (auto &i : p->CHILD->SUB_STATEMENTS)
+                for (AstNode i : p.child().subs())
                 {
-                    ss << HandleAst(i, parent, funcdecl, fromui);
+                    HandleAst(i, out, parent, funcdecl, fromui);
                 }
-                
-                //ss << HandleAst(p->CHILD->SUB_STATEMENTS[0], parent, funcdecl, fromui) << exprForNode(p->CHILD->SUB_STATEMENTS[1]) <<  exprForNode(p->CHILD->SUB_STATEMENTS[2]) << ") {\n";
             }
-            ss << "){";
-            for (auto &i : p->SUB_STATEMENTS)
+            out << "){";
+            for (AstNode i : p.subs())
             {
-            ss << HandleAst(i, parent, funcdecl, fromui);
+                HandleAst(i, out, parent, funcdecl, fromui);
             }
             
-            ss << "}";
-            return ss.str();
+            out << "}";
+            return;
         }
         case NODE_MATH_COS:
         case NODE_MATH_POW:
         case NODE_MATH_SIN:
         case NODE_MATH_TAN:
         case NODE_MATH_SQRT: {
-            stringstream ss;
-            ss << makeMath(p, p->TYPE);
+            makeMath(p, p.type(), out);
             if (fromui)
             {
-                ss << ";";
+                out << ";";
             }
-                
-            return ss.str();
+            return;
         }
         case NODE_PLATFORM_CLS: {
-            stringstream ss;
-            ss << "Platform()";
-            if (p->CHILD) {
-                ss << "." << HandleAst(p->CHILD->CHILD,parent,funcdecl, fromui) << "()";
+            out << "Platform()";
+            if (p.child()) {
+                out << ".";
+                HandleAst(p.child().child(), out, parent, funcdecl, fromui);
+                out << "()";
             }
             if(!fromui) {
-                ss << ";";
+                out << ";";
             }
-            return ss.str();
+            return;
         }
             default:
-            return "";
+            return;
     }
 }
-// Write file to disk
-bool WebEngine::makefile(const string &directoryPath, const string &filebuffer) {
-    try {
-        filesystem::path p(directoryPath);
-        if (!p.parent_path().empty() && !filesystem::exists(p.parent_path())) {
-            filesystem::create_directories(p.parent_path());
-        }
-        ofstream MyFile(directoryPath);
-        MyFile << filebuffer;
-        MyFile.close();
-        return true;
-    } catch (const std::exception &e) {
-        cerr << "makefile error: " << e.what() << endl;
-        return false;
-    }
-}
\ No newline at end of file
@@ -0,0 +1,127 @@
+#include "astcache.hpp"
+#include "check.hpp"
+#include "lexer.hpp"
+#include "parser.hpp"
+#include "semantics.hpp"
+#include <filesystem>
+#include <random>
+#include <string>
+
+namespace fs = std::filesystem;
+
+static const std::string PROGRAM = R"(ratio = 2.5
+greeting = "say \"hi\""
+def shout(a) {
+    print(a)
+}
+page("Home") {
+    @state n : 0
+    view("box", onclick=(n) {
+        n = n + 1
+    }) {
+        text("count")
+    }
+}
+)";
+
+static std::unique_ptr<Ast> parse(const std::string &text, CompilationSession &session)
+{
+    TokenStream tokens = Lexer(text).tokenize();
+    SourceMap sourcemap(text);
+    auto ast = std::make_unique<Ast>(Parser(tokens, sourcemap, session).parse(), &session.arena);
+    SemanticAnalyzer(session.diagnostics).analyze(*ast);
+    return ast;
+}
+
+// Every node, analysis annotations included, depth first.
+static void dump(AstNode node, std::string &out)
+{
+    if (!node)
+    {
+        out += "-;";
+        return;
+    }
+    out += nodetostr(node.type()) + "(" + (node.hasValue() ? node.value() : "") + " " + std::to_string(node.lineno()) + ":" +
+           std::to_string(node.charno()) + " @" + std::to_string(node.offset()) + "+" + std::to_string(node.length()) +
+           " t" + std::to_string(node.resolvedType()) + (node.isState() ? " state " : " ");
+    if (node.type() == NODE_INT)
+    {
+        out += std::to_string(node.intValue());
+    }
+    else if (node.type() == NODE_FLOAT)
+    {
+        out += std::to_string(node.floatValue());
+    }
+    dump(node.child(), out);
+    for (AstNode sub : node.subs())
+    {
+        dump(sub, out);
+    }
+    out += ");";
+}
+
+static std::string dump(const Ast &ast)
+{
+    std::string out;
+    dump(ast.root(), out);
+    return out;
+}
+
+int main()
+{
+    fs::path directory = fs::temp_directory_path() / ("helios-astcache-test-" + std::to_string(std::random_device()()));
+    AstCache cache(directory.string());
+
+    CompilationSession session;
+    std::unique_ptr<Ast> ast = parse(PROGRAM, session);
+    CHECK(session.diagnostics.all().empty());
+    SourceHash hash = hashSource(PROGRAM);
+
+    // nothing stored yet
+    CHECK(!cache.load("index.ink", hash, session));
+    CHECK(cache.store("index.ink", hash, *ast));
+
+    // a hit is the same tree, types and state flags included
+    {
+        CompilationSession reader;
+        std::unique_ptr<Ast> loaded = cache.load("index.ink", hash, reader);
+        CHECK(loaded && dump(*loaded) == dump(*ast));
+    }
+
+    // other bytes or another file miss
+    std::string edited = PROGRAM + "extra = 1\n";
+    SourceHash editedHash = hashSource(edited);
+    CHECK(!cache.load("index.ink", editedHash, session));
+    CHECK(!cache.load("other.ink", hash, session));
+
+    // storing the edited file replaces the entry: the old bytes miss from then on
+    {
+        CompilationSession writer;
+        std::unique_ptr<Ast> changed = parse(edited, writer);
+        CHECK(cache.store("index.ink", editedHash, *changed));
+        CompilationSession reader;
+        std::unique_ptr<Ast> loaded = cache.load("index.ink", editedHash, reader);
+        CHECK(loaded && dump(*loaded) == dump(*changed));
+        CHECK(!cache.load("index.ink", hash, reader));
+    }
+
+    // a damaged entry is a miss, not a crash
+    for (const fs::directory_entry &entry : fs::directory_iterator(directory))
+    {
+        if (entry.path().extension() == ".ast")
+        {
+            fs::resize_file(entry.path(), fs::file_size(entry.path()) / 2);
+        }
+    }
+    CHECK(!cache.load("index.ink", editedHash, session));
+
+    // the checked program is remembered by its hash alone
+    SourceHash program = combineHashes(hash, editedHash);
+    CHECK(!cache.isChecked(program));
+    cache.markChecked(program);
+    CHECK(cache.isChecked(program));
+    CHECK(!cache.isChecked(combineHashes(editedHash, hash)));
+
+    fs::remove_all(directory);
+    return failures();
+}
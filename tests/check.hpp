@@ -0,0 +1,24 @@
+#pragma once
+#ifndef __CHECK_H
+#define __CHECK_H
+#include <iostream>
+
+// Just enough to fail a ctest run: CHECK reports the expression that didn't
+// hold and carries on, and a test's main() returns failures().
+inline int &failures()
+{
+    static int count = 0;
+    return count;
+}
+
+#define CHECK(condition)                                                                         \
+    do                                                                                           \
+    {                                                                                            \
+        if (!(condition))                                                                        \
+        {                                                                                        \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition ") failed\n";      \
+            failures()++;                                                                        \
+        }                                                                                        \
+    } while (0)
+
+#endif
@@ -0,0 +1,96 @@
+#include "check.hpp"
+#include "lexer.hpp"
+#include "threadpool.hpp"
+#include <random>
+#include <string>
+
+// Pieces random sources are made of. Comments, strings and escapes are the
+// ones that can carry a line break the lexer mustn't split at.
+static const char *const FRAGMENTS[] = {
+    "page", "view", "text", "if", "else", "while", "for", "def", "return", "true", "false", "@state", "@stylesheet",
+    "name", "x1", "_tmp", "count", "0", "42", "3.25", "\"str\"", "'single'", "\"esc\\\"aped\"", "\"line\\nbreak\"",
+    "\"unterminated", "/*", "*/", "/* note */", "#", "(", ")", "{", "}", "[", "]", ",", ":", ".", "=", "==", "!=", "<=",
+    ">=", "+", "-", "*", "/", "++", "--", "&", "$", " ", "  ", "\t", "\n", "\n", "\n    ", "\r\n",
+};
+
+static std::string randomSource(std::mt19937 &random, size_t bytes)
+{
+    std::uniform_int_distribution<size_t> pick(0, std::size(FRAGMENTS) - 1);
+    std::string text;
+    while (text.size() < bytes)
+    {
+        text += FRAGMENTS[pick(random)];
+        text += ' ';
+    }
+    return text;
+}
+
+static bool sameTokens(const TokenStream &a, const TokenStream &b)
+{
+    if (a.size() != b.size())
+    {
+        std::cerr << "token counts differ: " << a.size() << " vs " << b.size() << "\n";
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); i++)
+    {
+        if (a.type(i) != b.type(i) || a.keywords[i] != b.keywords[i] || a.symbols[i] != b.symbols[i] ||
+            a.offsets[i] != b.offsets[i] || a.lines[i] != b.lines[i] || a.columns[i] != b.columns[i] ||
+            a.value(i) != b.value(i))
+        {
+            std::cerr << "token " << i << " differs: '" << a.value(i) << "' vs '" << b.value(i) << "'\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+// A worker thread always lexes in one piece.
+static TokenStream lexSerially(const std::string &text)
+{
+    return ThreadPool::shared().submit([&text] { return Lexer(text).tokenize(); }).get();
+}
+
+static void parallelMatchesSerial()
+{
+    std::mt19937 random(6);
+    CHECK(ThreadPool::shared().size() > 1); // or there is nothing to split for
+    for (int round = 0; round < 3; round++)
+    {
+        std::string text = randomSource(random, Lexer::PARALLEL_MIN_BYTES + Lexer::PARALLEL_CHUNK_BYTES * round + 4099);
+        CHECK(sameTokens(Lexer(text).tokenize(), lexSerially(text)));
+    }
+}
+
+static void incrementalMatchesFull()
+{
+    std::mt19937 random(13);
+    std::string text = randomSource(random, 16 << 10);
+    IncrementalLexer lexer;
+    CHECK(sameTokens(lexer.update(text), Lexer(text).tokenize()));
+    for (int edit = 0; edit < 300; edit++)
+    {
+        size_t at = std::uniform_int_distribution<size_t>(0, text.size())(random);
+        size_t erase = std::uniform_int_distribution<size_t>(0, 24)(random);
+        text.erase(at, erase);
+        text.insert(at, randomSource(random, std::uniform_int_distribution<size_t>(0, 16)(random)));
+        if (!sameTokens(lexer.update(text), Lexer(text).tokenize()))
+        {
+            std::cerr << "after edit " << edit << " at offset " << at << "\n";
+            failures()++;
+            return;
+        }
+    }
+    // the same text again, and then nothing at all
+    CHECK(sameTokens(lexer.update(text), Lexer(text).tokenize()));
+    CHECK(lexer.relexedBytes() < text.size());
+    std::string empty;
+    CHECK(sameTokens(lexer.update(empty), Lexer(empty).tokenize()));
+}
+
+int main()
+{
+    parallelMatchesSerial();
+    incrementalMatchesFull();
+    return failures();
+}
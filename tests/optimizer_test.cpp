@@ -0,0 +1,135 @@
+#include "check.hpp"
+#include "lexer.hpp"
+#include "optimizer.hpp"
+#include "parser.hpp"
+#include "semantics.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+static const std::string PROGRAM = R"(print(1 + 2 * 3)
+print("a" + "b")
+print(3 > 2)
+print(to_int("42"))
+print(to_float("0.5"))
+print(2147483647 + 1)
+print(to_float("0.1"))
+if true {
+    print("yes")
+} else {
+    print("no")
+}
+sqrt(16)
+unused = 5
+def never() {
+    print("never")
+}
+shown = 3
+def later() {
+    print("later")
+}
+page("Home") {
+    @state n : 0
+    view("box", onclick=(n) {
+        print(shown)
+        later()
+        n = n + 1
+    }) {
+        text("hi")
+    }
+}
+)";
+
+// The program as codegen gets it: parsed, analysed, then optimized.
+struct Optimized {
+    CompilationSession session;
+    std::unique_ptr<Ast> program;
+    std::unique_ptr<Ast> ast;
+
+    explicit Optimized(const std::string &text)
+    {
+        TokenStream tokens = Lexer(text).tokenize();
+        SourceMap sourcemap(text);
+        program = std::make_unique<Ast>(Parser(tokens, sourcemap, session).parse(), &session.arena);
+        SemanticAnalyzer(session.diagnostics).analyze(*program);
+        ast = std::make_unique<Ast>(Optimizer(*program).run(&session.arena));
+    }
+
+    // What each top-level print() is left printing, in order.
+    std::vector<AstNode> printed() const
+    {
+        std::vector<AstNode> values;
+        for (AstNode statement : ast->root().subs())
+        {
+            if (statement.type() == NODE_PRINT)
+            {
+                values.push_back(statement.child());
+            }
+        }
+        return values;
+    }
+
+    bool declares(enum NODE_TYPE type, const std::string &name) const
+    {
+        for (AstNode statement : ast->root().subs())
+        {
+            if (statement.type() == type && statement.hasValue() && statement.value() == name)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool has(enum NODE_TYPE type) const
+    {
+        for (AstNode statement : ast->root().subs())
+        {
+            if (statement.type() == type)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+static bool literal(AstNode node, enum NODE_TYPE type, const std::string &text)
+{
+    return node && node.type() == type && node.value() == text;
+}
+
+int main()
+{
+    Optimized program(PROGRAM);
+    CHECK(!program.session.diagnostics.hasErrors());
+
+    std::vector<AstNode> printed = program.printed();
+    CHECK(printed.size() == 8);
+    if (printed.size() == 8)
+    {
+        CHECK(literal(printed[0], NODE_INT, "7") && printed[0].intValue() == 7);
+        CHECK(literal(printed[1], NODE_STRING, "ab"));
+        CHECK(literal(printed[2], NODE_BOOL, "true"));
+        CHECK(literal(printed[3], NODE_INT, "42") && printed[3].intValue() == 42);
+        CHECK(printed[4].type() == NODE_FLOAT && printed[4].floatValue() == 0.5);
+        // wraps in a 32-bit int at run time, so it stays as written
+        CHECK(printed[5].type() == NODE_BINARY_OP);
+        // stof gives the float nearest 0.1, not the double
+        CHECK(printed[6].type() == NODE_TOFLOAT);
+        // only the branch that runs is left, unwrapped
+        CHECK(literal(printed[7], NODE_STRING, "yes"));
+    }
+    CHECK(!program.has(NODE_IF));
+
+    // nothing reads these, and computing them has no effect
+    CHECK(!program.has(NODE_MATH_SQRT));
+    CHECK(!program.declares(NODE_VARIABLE, "unused"));
+    CHECK(!program.declares(NODE_FUNCTION_DECL, "never"));
+    // read only inside a click callback, which runs later
+    CHECK(program.declares(NODE_VARIABLE, "shown"));
+    CHECK(program.declares(NODE_FUNCTION_DECL, "later"));
+    CHECK(program.has(NODE_page));
+
+    return failures();
+}
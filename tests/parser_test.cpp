@@ -0,0 +1,128 @@
+#include "check.hpp"
+#include "lexer.hpp"
+#include "parser.hpp"
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// Top-level statements an edited file is made of, a few with syntax errors.
+static const char *const STATEMENTS[] = {
+    "x = 1 + 2 * 3",
+    "s = \"a\" + 'b'",
+    "print(x)",
+    "def add(a, b) {\n    return a + b\n}",
+    "def shout(t) {\n    print(t)\n}",
+    "if x > 2 {\n    print(\"big\")\n} else {\n    print(\"small\")\n}",
+    "while x < 10 {\n    x = x + 1\n}",
+    "items = [1, 2, 3]",
+    "style = {\"color\": \"red\", \"margin\": \"0px\"}",
+    "page(\"Home\") {\n    @state n : 0\n    view(\"box\", onclick=(n) {\n        n = n + 1\n    }) {\n        text(n)\n    }\n}",
+    "page(\"About\") {\n    text(\"about\")\n}",
+    "y = to_int(\"4\")",
+    "z = (x + \n",
+    "true",
+    ") oops",
+};
+
+// Every field of every node, depth first.
+static void dump(const AST_NODE *node, std::string &out)
+{
+    if (!node)
+    {
+        out += "-;";
+        return;
+    }
+    char number[sizeof node->number];
+    std::memcpy(number, &node->number, sizeof number);
+    out += nodetostr(node->TYPE) + "(" + (node->value ? *node->value : "") + " " + std::to_string(node->lineno) + ":" +
+           std::to_string(node->charno) + " @" + std::to_string(node->offset) + "+" + std::to_string(node->length) + " #" +
+           std::string(number, sizeof number) + " ";
+    dump(node->CHILD, out);
+    for (const AST_NODE *sub : node->SUB_STATEMENTS)
+    {
+        dump(sub, out);
+    }
+    out += ");";
+}
+
+static std::string join(const std::vector<std::string> &statements)
+{
+    std::string text;
+    for (const std::string &statement : statements)
+    {
+        text += statement + "\n";
+    }
+    return text;
+}
+
+static void reuseMatchesFreshParse()
+{
+    std::mt19937 random(13);
+    auto pick = [&random](size_t count) { return std::uniform_int_distribution<size_t>(0, count - 1)(random); };
+    std::vector<std::string> statements;
+    for (int i = 0; i < 24; i++)
+    {
+        statements.push_back(STATEMENTS[pick(std::size(STATEMENTS))]);
+    }
+
+    IncrementalParser incremental;
+    size_t reused = 0;
+    for (int edit = 0; edit < 400; edit++)
+    {
+        std::string text = join(statements);
+        TokenStream tokens = Lexer(text).tokenize();
+        SourceMap sourcemap(text);
+
+        auto session = std::make_shared<CompilationSession>();
+        std::string incrementally;
+        dump(incremental.parse(tokens, sourcemap, session), incrementally);
+        reused += incremental.reusedStatements();
+
+        CompilationSession fresh;
+        std::string whole;
+        dump(Parser(tokens, sourcemap, fresh).parse(), whole);
+
+        if (incrementally != whole || session->diagnostics.all().size() != fresh.diagnostics.all().size())
+        {
+            std::cerr << "reparse differs from a fresh parse after edit " << edit << " of:\n" << text << "\n";
+            failures()++;
+            return;
+        }
+
+        // move, add, drop or retype a statement, or shift everything after a point
+        size_t at = pick(statements.size());
+        switch (pick(6))
+        {
+            case 0:
+                statements.insert(statements.begin() + at, STATEMENTS[pick(std::size(STATEMENTS))]);
+                break;
+            case 1:
+                if (statements.size() > 1)
+                {
+                    statements.erase(statements.begin() + at);
+                }
+                break;
+            case 2:
+                statements[at] = STATEMENTS[pick(std::size(STATEMENTS))];
+                break;
+            case 3:
+                statements.insert(statements.begin() + at, "");
+                break;
+            case 4:
+                statements[at].insert(pick(statements[at].size() + 1), 1, " 9+\"(){}\n"[pick(9)]);
+                break;
+            case 5:
+                std::swap(statements[at], statements[pick(statements.size())]);
+                break;
+        }
+    }
+    CHECK(reused > 0);
+}
+
+int main()
+{
+    reuseMatchesFreshParse();
+    return failures();
+}
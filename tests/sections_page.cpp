@@ -0,0 +1,28 @@
+// Drives the page sections_test generates, natively: renders it, clicks the
+// element that changes its state, and prints the page's children each time.
+#include "app.hpp"
+#include <cstdio>
+
+static void print(VPage &page)
+{
+    for (const std::string &markup : page.html)
+    {
+        std::printf("%s\n", markup.c_str());
+    }
+    std::printf("--\n");
+}
+
+int main()
+{
+    auto page = std::make_shared<VPage>();
+    page->builder = build_page_1;
+    Router::add("/", page);
+    handleRoute("/");
+    print(*page);
+    for (int click = 0; click < 2; click++)
+    {
+        page->children[0].onclick();
+        print(*page);
+    }
+    return 0;
+}
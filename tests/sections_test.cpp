@@ -0,0 +1,128 @@
+#include "check.hpp"
+#include "core.hpp"
+#include "lexer.hpp"
+#include "optimizer.hpp"
+#include "parser.hpp"
+#include "semantics.hpp"
+#include "web_engine.hpp"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+
+namespace fs = std::filesystem;
+
+// A loop between two elements: the page's children are the view, the rows and
+// the tail, and a click re-creates only the view.
+static const std::string PROGRAM = R"(page("Home Page") {
+    @state txt : "a"
+    view("btn", onclick=(txt) {
+        txt = "b"
+    }) {
+        text(txt)
+    }
+    for (i = 0 : i < 3 : i++) {
+        text("row")
+    }
+    text("tail")
+}
+)";
+
+static const std::string ROWS = "<p>row</p>\n<p>row</p>\n<p>row</p>\n<p>tail</p>\n--\n";
+
+static std::string read(const fs::path &path)
+{
+    std::ifstream file(path);
+    std::stringstream text;
+    text << file.rdbuf();
+    return text.str();
+}
+
+// Whatever `command` prints to stdout.
+static std::string run(const std::string &command)
+{
+    std::string out;
+    FILE *pipe = popen(command.c_str(), "r");
+    if (!pipe)
+    {
+        return out;
+    }
+    char buffer[4096];
+    size_t count;
+    while ((count = fread(buffer, 1, sizeof buffer, pipe)) > 0)
+    {
+        out.append(buffer, count);
+    }
+    pclose(pipe);
+    return out;
+}
+
+// The statements of the page each sit in a section of their own, in order.
+static void lowersToSections()
+{
+    std::string page = read("web/gen/pages/page_1.cpp");
+    size_t view = page.find("page.section(0, 0x1)");
+    size_t loop = page.find("page.section(1, ");
+    size_t tail = page.find("page.section(2, ");
+    CHECK(view != std::string::npos && loop != std::string::npos && tail != std::string::npos);
+    CHECK(view < loop && loop < tail);
+    size_t rows = page.find("for (");
+    CHECK(rows > loop && rows < tail);
+    CHECK(page.find("page.section(3, ") == std::string::npos);
+}
+
+// Built natively, the page keeps its children in source order however many of
+// them a section adds, and a click replaces the view and nothing else.
+static void rebuildsInOrder()
+{
+    std::string command = std::string(HELIOS_TEST_CXX) + " -std=c++20 -w -I\"" + HELIOS_TEST_STUBS + "\"";
+#ifdef HELIOS_TEST_NOFORMAT
+    command += std::string(" -I\"") + HELIOS_TEST_NOFORMAT + "\"";
+#endif
+    command += std::string(" -Iweb -Iweb/gen web/vdom.cpp web/gen/pages/page_1.cpp \"") + HELIOS_TEST_DRIVER + "\" -o page";
+    CHECK(std::system(command.c_str()) == 0);
+    std::string out = run("./page");
+    // state lives in the browser, so its text is empty here; a re-created view
+    // has a callback of its own
+    auto view = [](int callback) {
+        return "<div id=\"btn\" data-callback=\"callback_" + std::to_string(callback) + "\"><p></p></div>\n";
+    };
+    CHECK(out == view(0) + ROWS + view(1) + ROWS + view(2) + ROWS);
+    if (failures())
+    {
+        std::cerr << "the page printed:\n" << out;
+    }
+}
+
+int main()
+{
+    fs::path directory = fs::temp_directory_path() / ("helios-sections-test-" + std::to_string(std::random_device()()));
+    fs::create_directories(directory);
+    fs::path previous = fs::current_path();
+
+    // the runtime exactly as `helios create` writes it
+    Core core;
+    core.saveProjectRoot(directory.string());
+    core.generateFiles({"web"}, directory.string());
+    fs::current_path(directory);
+
+    CompilationSession session;
+    TokenStream tokens = Lexer(PROGRAM).tokenize();
+    SourceMap sourcemap(PROGRAM);
+    Ast program(Parser(tokens, sourcemap, session).parse(), &session.arena);
+    SemanticAnalyzer(session.diagnostics).analyze(program);
+    CHECK(!session.diagnostics.hasErrors());
+    Ast ast = Optimizer(program).run(&session.arena);
+    WebEngine engine;
+    CHECK(engine.gen(ast));
+
+    lowersToSections();
+    rebuildsInOrder();
+
+    fs::current_path(previous);
+    fs::remove_all(directory);
+    return failures();
+}
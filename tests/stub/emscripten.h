@@ -0,0 +1,8 @@
+#pragma once
+// Enough of emscripten.h to build the page runtime natively, with no browser
+// behind it: the JavaScript a call would run is dropped.
+#define EM_ASM(...) ((void)0)
+#define EM_ASM_INT(...) 0
+#define EM_ASM_DOUBLE(...) 0.0
+#define EMSCRIPTEN_KEEPALIVE
+inline void emscripten_run_script(const char *) {}